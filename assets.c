@@ -0,0 +1,121 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <naomi/ta.h>
+#include <naomi/font.h>
+#include "common.h"
+#include "state.h"
+#include "assets.h"
+#include "sprites.h"
+#include "pack.h"
+#include "boottrace.h"
+
+typedef struct
+{
+    unsigned int asset;
+    char *name;
+    // Where in the sprites structure this sprite is kept.
+    size_t offset;
+} sprite_asset_t;
+
+static sprite_asset_t sprite_assets[] = {
+    { ASSET_SPRITE_UP, "up.png", offsetof(sprites_t, up) },
+    { ASSET_SPRITE_DOWN, "dn.png", offsetof(sprites_t, down) },
+    { ASSET_SPRITE_CURSOR, "cursor.png", offsetof(sprites_t, cursor) },
+    { ASSET_SPRITE_PSWOFF, "pswoff.png", offsetof(sprites_t, pswoff) },
+    { ASSET_SPRITE_PSWON, "pswon.png", offsetof(sprites_t, pswon) },
+    { ASSET_SPRITE_BUTTONMASK, "buttonmask.png", offsetof(sprites_t, buttonmask) },
+};
+
+// What is loaded right now, and what it is costing us.
+static unsigned int loaded = 0;
+static unsigned int resident = 0;
+
+// FreeType reads the font data for as long as the font is around.
+static void *mono_data = NULL;
+static unsigned int mono_len = 0;
+
+texture_description_t **sprite_slot(state_t *state, sprite_asset_t *sprite)
+{
+    return (texture_description_t **)((uint8_t *)&state->sprites + sprite->offset);
+}
+
+unsigned int sprite_bytes(sprite_asset_t *sprite)
+{
+    // Twiddled and VQ sprites take up exactly as much VRAM as they do in
+    // the pack once inflated.
+    const pack_entry_t *entry = pack_find(sprite->name);
+    return entry ? entry->size : 0;
+}
+
+void assets_require(state_t *state, unsigned int manifest)
+{
+    for (int i = 0; i < sizeof(sprite_assets) / sizeof(sprite_assets[0]); i++)
+    {
+        if ((manifest & sprite_assets[i].asset) && !(loaded & sprite_assets[i].asset))
+        {
+            texture_description_t **slot = sprite_slot(state, &sprite_assets[i]);
+            int step = boottrace_start("load %s", sprite_assets[i].name);
+            *slot = sprite_load(sprite_assets[i].name);
+            boottrace_end(step);
+            if (*slot != NULL)
+            {
+                loaded |= sprite_assets[i].asset;
+                resident += sprite_bytes(&sprite_assets[i]);
+            }
+        }
+    }
+
+    if ((manifest & ASSET_FONT_MONO) && !(loaded & ASSET_FONT_MONO))
+    {
+        int step = boottrace_start("inflate dejavumono.ttf");
+        mono_data = pack_load("dejavumono.ttf", &mono_len);
+        boottrace_end(step);
+        if (mono_data != NULL)
+        {
+            step = boottrace_start("font_add mono");
+            state->font_mono = font_add(mono_data, mono_len);
+            boottrace_end(step);
+            step = boottrace_start("font_set_size mono");
+            font_set_size(state->font_mono, 12);
+            boottrace_end(step);
+            loaded |= ASSET_FONT_MONO;
+            resident += mono_len;
+        }
+    }
+}
+
+void assets_release(state_t *state, unsigned int manifest)
+{
+    for (int i = 0; i < sizeof(sprite_assets) / sizeof(sprite_assets[0]); i++)
+    {
+        if ((manifest & sprite_assets[i].asset) && (loaded & sprite_assets[i].asset))
+        {
+            texture_description_t **slot = sprite_slot(state, &sprite_assets[i]);
+            resident -= sprite_bytes(&sprite_assets[i]);
+            ta_texture_desc_free(*slot);
+            *slot = NULL;
+            loaded &= ~sprite_assets[i].asset;
+        }
+    }
+
+    if ((manifest & ASSET_FONT_MONO) && (loaded & ASSET_FONT_MONO))
+    {
+        font_discard(state->font_mono);
+        state->font_mono = NULL;
+        free(mono_data);
+        mono_data = NULL;
+        resident -= mono_len;
+        loaded &= ~ASSET_FONT_MONO;
+    }
+}
+
+unsigned int assets_loaded()
+{
+    return loaded;
+}
+
+unsigned int assets_resident_bytes()
+{
+    return resident;
+}
@@ -0,0 +1,42 @@
+#ifndef __ASSETS_H
+#define __ASSETS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "state.h"
+
+// Assets that are only loaded once a screen that needs them is shown. The
+// menu fonts and sounds aren't in here, since they're needed from the start.
+#define ASSET_SPRITE_UP 0x01
+#define ASSET_SPRITE_DOWN 0x02
+#define ASSET_SPRITE_CURSOR 0x04
+#define ASSET_SPRITE_PSWOFF 0x08
+#define ASSET_SPRITE_PSWON 0x10
+#define ASSET_SPRITE_BUTTONMASK 0x20
+#define ASSET_FONT_MONO 0x40
+
+// Handy groups of the above.
+#define ASSET_SPRITES 0x3F
+#define ASSET_MENU (ASSET_SPRITE_UP | ASSET_SPRITE_DOWN | ASSET_SPRITE_CURSOR)
+#define ASSET_ALL 0x7F
+
+// Make sure every asset in the manifest is loaded. Anything already loaded
+// is left alone, so this is cheap to call every time a screen is entered.
+void assets_require(state_t *state, unsigned int manifest);
+
+// Give back the memory used by every asset in the manifest. Nothing may use
+// them until assets_require() is called for them again.
+void assets_release(state_t *state, unsigned int manifest);
+
+// Which assets are currently loaded, and how many bytes of heap and VRAM
+// they are taking up.
+unsigned int assets_loaded();
+unsigned int assets_resident_bytes();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,113 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <naomi/timer.h>
+#include "common.h"
+#include "memtest.h"
+#include "avsync.h"
+
+// The AICA monitor registers. Writing a channel to MSLC makes its current
+// play position, in samples, readable from CA.
+#define AICA_MSLC_REG ((volatile uint32_t *)0xA070280C)
+#define AICA_CA_REG ((volatile uint32_t *)0xA0702814)
+
+static int clock_profile = -1;
+static uint32_t clock_total = 0;
+
+uint32_t avsync_clock()
+{
+    // Profiles can only be read once, so keep chaining them together.
+    if (clock_profile >= 0)
+    {
+        clock_total += profile_end(clock_profile);
+    }
+    clock_profile = profile_start();
+    return clock_total;
+}
+
+void avsync_clock_stop()
+{
+    if (clock_profile >= 0)
+    {
+        profile_end(clock_profile);
+        clock_profile = -1;
+    }
+    clock_total = 0;
+}
+
+int16_t *avsync_make_click()
+{
+    // A short full scale square wave burst, then silence.
+    int16_t *click = malloc(AVSYNC_SOUND_SAMPLES * sizeof(int16_t));
+    unsigned int length = (AVSYNC_SAMPLERATE / (1000000 / AVSYNC_CLICK_US));
+    for (unsigned int i = 0; i < AVSYNC_SOUND_SAMPLES; i++)
+    {
+        if (i < length)
+        {
+            click[i] = ((i / 11) & 1) ? -30000 : 30000;
+        }
+        else
+        {
+            click[i] = 0;
+        }
+    }
+
+    return click;
+}
+
+static uint16_t channel_position(int channel)
+{
+    MEMTEST_G2_WAIT();
+    *AICA_MSLC_REG = (*AICA_MSLC_REG & ~0x3F00) | (channel << 8);
+    MEMTEST_G2_WAIT();
+    return *AICA_CA_REG & 0xFFFF;
+}
+
+void avsync_snapshot(avsync_snapshot_t *snapshot)
+{
+    for (int channel = 0; channel < AVSYNC_CHANNELS; channel++)
+    {
+        snapshot->positions[channel] = channel_position(channel);
+    }
+}
+
+int avsync_find_start(avsync_snapshot_t *snapshot)
+{
+    // Our click is the only thing playing on this screen, so any channel that
+    // has moved and is still within the length of the click is it.
+    int best = -1;
+    for (int channel = 0; channel < AVSYNC_CHANNELS; channel++)
+    {
+        uint16_t position = channel_position(channel);
+        if (position != snapshot->positions[channel] && position < AVSYNC_SOUND_SAMPLES)
+        {
+            if (best < 0 || position < best)
+            {
+                best = position;
+            }
+        }
+    }
+
+    return best;
+}
+
+void avsync_record(avsync_results_t *results, int32_t offset)
+{
+    results->offsets[results->next] = offset;
+    results->next = (results->next + 1) % AVSYNC_HISTORY;
+    results->count = min(results->count + 1, AVSYNC_HISTORY);
+
+    int bucket = (offset - AVSYNC_LOWEST_US) / AVSYNC_BUCKET_US;
+    if (offset < AVSYNC_LOWEST_US)
+    {
+        results->under++;
+    }
+    else if (bucket >= AVSYNC_BUCKETS)
+    {
+        results->over++;
+    }
+    else
+    {
+        results->buckets[bucket]++;
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef __AVSYNC_H
+#define __AVSYNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// The number of AICA channels, all of which we watch for our click.
+#define AVSYNC_CHANNELS 64
+
+// Sample rate and length of the click. The click itself is short, but the
+// sound runs on in silence so that its play position keeps counting long
+// enough for us to read it back.
+#define AVSYNC_SAMPLERATE 44100
+#define AVSYNC_CLICK_US 3000
+#define AVSYNC_SOUND_SAMPLES (AVSYNC_SAMPLERATE / 4)
+
+// How many measurements we keep, and how they are bucketed for display.
+#define AVSYNC_HISTORY 256
+#define AVSYNC_BUCKETS 60
+#define AVSYNC_BUCKET_US 2000
+#define AVSYNC_LOWEST_US -20000
+
+typedef struct
+{
+    // Play positions of every channel just before we started the click.
+    uint16_t positions[AVSYNC_CHANNELS];
+} avsync_snapshot_t;
+
+typedef struct
+{
+    // Audio start minus flash start, in microseconds, for recent clicks.
+    int32_t offsets[AVSYNC_HISTORY];
+    unsigned int count;
+    unsigned int next;
+
+    // Clicks we never saw start playing.
+    unsigned int missed;
+
+    // How many offsets landed in each bucket, and outside of them.
+    unsigned int buckets[AVSYNC_BUCKETS];
+    unsigned int under;
+    unsigned int over;
+} avsync_results_t;
+
+// A microsecond clock that keeps counting from the first call onward.
+uint32_t avsync_clock();
+void avsync_clock_stop();
+
+// Build the click sound, ready to be registered with the audio driver.
+int16_t *avsync_make_click();
+
+// Remember where every channel is, then look for one that has since started
+// over, meaning the driver keyed our click on. Returns the number of samples
+// it has played so far, or -1 if none has started yet.
+void avsync_snapshot(avsync_snapshot_t *snapshot);
+int avsync_find_start(avsync_snapshot_t *snapshot);
+
+// Add a measurement to the running results.
+void avsync_record(avsync_results_t *results, int32_t offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
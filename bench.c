@@ -0,0 +1,348 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <naomi/system.h>
+#include <naomi/timer.h>
+#include "common.h"
+#include "memtest.h"
+#include "bench.h"
+
+// Distance, in words, between each link of the latency chain. Any odd
+// number visits every word of a power of two sized window exactly once.
+#define BENCH_LATENCY_STRIDE 2053
+
+void bench_read(unsigned int addr, unsigned int size, int width)
+{
+    switch(width)
+    {
+        case 0:
+        {
+            volatile uint8_t *mem = (volatile uint8_t *)addr;
+            for (unsigned int i = 0; i < size; i++) { (void)mem[i]; }
+            break;
+        }
+        case 1:
+        {
+            volatile uint16_t *mem = (volatile uint16_t *)addr;
+            for (unsigned int i = 0; i < size / 2; i++) { (void)mem[i]; }
+            break;
+        }
+        case 2:
+        {
+            volatile uint32_t *mem = (volatile uint32_t *)addr;
+            for (unsigned int i = 0; i < size / 4; i++) { (void)mem[i]; }
+            break;
+        }
+        case 3:
+        {
+            volatile uint64_t *mem = (volatile uint64_t *)addr;
+            for (unsigned int i = 0; i < size / 8; i++) { (void)mem[i]; }
+            break;
+        }
+    }
+}
+
+void bench_write(bench_t *bench, unsigned int addr, unsigned int size, int width)
+{
+    // G2 regions only ever get 32 and 64-bit writes, the latter of which
+    // goes out as two words, so count the batch in words.
+    unsigned int g2 = bench->flags & MEMTEST_FLAG_G2;
+
+    switch(width)
+    {
+        case 0:
+        {
+            volatile uint8_t *mem = (volatile uint8_t *)addr;
+            for (unsigned int i = 0; i < size; i++) { mem[i] = i; }
+            break;
+        }
+        case 1:
+        {
+            volatile uint16_t *mem = (volatile uint16_t *)addr;
+            for (unsigned int i = 0; i < size / 2; i++) { mem[i] = i; }
+            break;
+        }
+        case 2:
+        {
+            volatile uint32_t *mem = (volatile uint32_t *)addr;
+            for (unsigned int i = 0; i < size / 4; i++)
+            {
+                if (g2 && (i % MEMTEST_G2_BATCH) == 0) { MEMTEST_G2_WAIT(); }
+                mem[i] = i;
+            }
+            break;
+        }
+        case 3:
+        {
+            volatile uint64_t *mem = (volatile uint64_t *)addr;
+            for (unsigned int i = 0; i < size / 8; i++)
+            {
+                if (g2 && (i % (MEMTEST_G2_BATCH / 2)) == 0) { MEMTEST_G2_WAIT(); }
+                mem[i] = i;
+            }
+            break;
+        }
+    }
+}
+
+void bench_copy(bench_t *bench, unsigned int dest, unsigned int src, unsigned int size, int width)
+{
+    unsigned int g2 = bench->flags & MEMTEST_FLAG_G2;
+
+    switch(width)
+    {
+        case 0:
+        {
+            volatile uint8_t *to = (volatile uint8_t *)dest;
+            volatile uint8_t *from = (volatile uint8_t *)src;
+            for (unsigned int i = 0; i < size; i++) { to[i] = from[i]; }
+            break;
+        }
+        case 1:
+        {
+            volatile uint16_t *to = (volatile uint16_t *)dest;
+            volatile uint16_t *from = (volatile uint16_t *)src;
+            for (unsigned int i = 0; i < size / 2; i++) { to[i] = from[i]; }
+            break;
+        }
+        case 2:
+        {
+            volatile uint32_t *to = (volatile uint32_t *)dest;
+            volatile uint32_t *from = (volatile uint32_t *)src;
+            for (unsigned int i = 0; i < size / 4; i++)
+            {
+                if (g2 && (i % MEMTEST_G2_BATCH) == 0) { MEMTEST_G2_WAIT(); }
+                to[i] = from[i];
+            }
+            break;
+        }
+        case 3:
+        {
+            volatile uint64_t *to = (volatile uint64_t *)dest;
+            volatile uint64_t *from = (volatile uint64_t *)src;
+            for (unsigned int i = 0; i < size / 8; i++)
+            {
+                if (g2 && (i % (MEMTEST_G2_BATCH / 2)) == 0) { MEMTEST_G2_WAIT(); }
+                to[i] = from[i];
+            }
+            break;
+        }
+    }
+}
+
+uint32_t bench_measure(bench_t *bench, int op, int width, unsigned int size)
+{
+    // Some regions can't take byte or halfword accesses at all. Regions that
+    // are only tested a word at a time can still be benchmarked at any width.
+    if ((bench->flags & (MEMTEST_FLAG_NO_NARROW | MEMTEST_FLAG_G2)) && width < 2)
+    {
+        return BENCH_UNSUPPORTED;
+    }
+
+    // Keep making passes until we've run long enough for the microsecond
+    // timer to give us a meaningful figure.
+    uint64_t bytes = 0;
+    uint32_t elapsed = 0;
+    while (elapsed < BENCH_MIN_US)
+    {
+        if (job_cancelled(&bench->job))
+        {
+            return BENCH_RUNNING;
+        }
+
+        int profile = profile_start();
+        switch(op)
+        {
+            case BENCH_OP_READ:
+            {
+                bench_read(bench->startaddr, size, width);
+                bytes += size;
+                break;
+            }
+            case BENCH_OP_WRITE:
+            {
+                bench_write(bench, bench->startaddr, size, width);
+                bytes += size;
+                break;
+            }
+            case BENCH_OP_COPY:
+            {
+                // Copy the bottom half of the window over the top half.
+                bench_copy(bench, bench->startaddr + (size / 2), bench->startaddr, size / 2, width);
+                bytes += size / 2;
+                break;
+            }
+        }
+        elapsed += profile_end(profile);
+    }
+
+    return (uint32_t)((bytes * 1000000) / ((uint64_t)elapsed * 1024));
+}
+
+uint32_t bench_sqwrite(bench_t *bench, unsigned int size)
+{
+    // We can't be sure the G2 FIFO keeps up with store queue bursts.
+    if (bench->flags & MEMTEST_FLAG_G2)
+    {
+        return BENCH_UNSUPPORTED;
+    }
+
+    size &= ~31;
+    uint64_t bytes = 0;
+    uint32_t elapsed = 0;
+    while (elapsed < BENCH_MIN_US)
+    {
+        if (job_cancelled(&bench->job))
+        {
+            return BENCH_RUNNING;
+        }
+
+        int profile = profile_start();
+        hw_memcpy((void *)bench->startaddr, bench->source, size);
+        elapsed += profile_end(profile);
+        bytes += size;
+    }
+
+    return (uint32_t)((bytes * 1000000) / ((uint64_t)elapsed * 1024));
+}
+
+uint32_t bench_latency(bench_t *bench, unsigned int size)
+{
+    // Build a chain through the window where each word holds the offset of
+    // the next, spread out so that no two reads in a row are neighbors.
+    unsigned int words = 1;
+    while (words * 2 <= size / 4)
+    {
+        words *= 2;
+    }
+
+    volatile uint32_t *mem = (volatile uint32_t *)bench->startaddr;
+    for (unsigned int i = 0; i < words; i++)
+    {
+        if ((bench->flags & MEMTEST_FLAG_G2) && (i % MEMTEST_G2_BATCH) == 0) { MEMTEST_G2_WAIT(); }
+        mem[i] = ((i + BENCH_LATENCY_STRIDE) & (words - 1)) * 4;
+    }
+
+    // Now follow it. Each read depends on the last, so nothing can overlap.
+    uint64_t steps = 0;
+    uint32_t elapsed = 0;
+    uint32_t offset = 0;
+    while (elapsed < BENCH_MIN_US)
+    {
+        if (job_cancelled(&bench->job))
+        {
+            return BENCH_RUNNING;
+        }
+
+        int profile = profile_start();
+        for (unsigned int i = 0; i < words; i++)
+        {
+            offset = mem[offset / 4];
+        }
+        elapsed += profile_end(profile);
+        steps += words;
+    }
+
+    return (uint32_t)(((uint64_t)elapsed * 1000) / steps);
+}
+
+void bench_restore(bench_t *bench, unsigned int size)
+{
+    volatile uint32_t *mem = (volatile uint32_t *)bench->startaddr;
+    for (unsigned int i = 0; i < size / 4; i++)
+    {
+        if ((bench->flags & MEMTEST_FLAG_G2) && (i % MEMTEST_G2_BATCH) == 0) { MEMTEST_G2_WAIT(); }
+        mem[i] = bench->backup[i];
+    }
+}
+
+unsigned int bench_thread(void *param)
+{
+    bench_t *bench = (bench_t *)param;
+
+    /* First, grab our window and save what's in it. */
+    unsigned int size = bench->size;
+
+    volatile uint32_t *mem = (volatile uint32_t *)bench->startaddr;
+    for (unsigned int i = 0; i < size / 4; i++)
+    {
+        bench->backup[i] = mem[i];
+    }
+
+    /* Now, measure every operation at every width. */
+    for (int op = 0; op < BENCH_OPS; op++)
+    {
+        for (int width = 0; width < BENCH_WIDTHS; width++)
+        {
+            uint32_t result = bench_measure(bench, op, width, size);
+            if (result == BENCH_RUNNING) { bench_restore(bench, size); return JOB_CANCELLED; }
+
+            job_publish_begin(&bench->job);
+            bench->results[op][width] = result;
+            job_publish_end(&bench->job);
+        }
+    }
+
+    uint32_t sqwrite = bench_sqwrite(bench, size);
+    if (sqwrite == BENCH_RUNNING) { bench_restore(bench, size); return JOB_CANCELLED; }
+    job_publish_begin(&bench->job);
+    bench->sqwrite = sqwrite;
+    job_publish_end(&bench->job);
+
+    uint32_t latency = bench_latency(bench, size);
+    if (latency == BENCH_RUNNING) { bench_restore(bench, size); return JOB_CANCELLED; }
+    job_publish_begin(&bench->job);
+    bench->latency = latency;
+    job_publish_end(&bench->job);
+
+    /* Finally, put back what we found. */
+    bench_restore(bench, size);
+
+    return JOB_FINISHED;
+}
+
+bench_t *start_bench(unsigned int startaddr, unsigned int size, unsigned int flags)
+{
+    bench_t *bench = malloc(sizeof(bench_t));
+    if (bench == NULL)
+    {
+        return NULL;
+    }
+    bench->startaddr = startaddr;
+    bench->size = min(size, BENCH_WINDOW) & ~31;
+    bench->flags = flags;
+    bench->backup = malloc(bench->size);
+    bench->source = memalign(32, bench->size);
+    if (bench->backup == NULL || bench->source == NULL)
+    {
+        free(bench->backup);
+        free(bench->source);
+        free(bench);
+        return NULL;
+    }
+    memset(bench->source, 0xA5, bench->size);
+
+    for (int op = 0; op < BENCH_OPS; op++)
+    {
+        for (int width = 0; width < BENCH_WIDTHS; width++)
+        {
+            bench->results[op][width] = BENCH_RUNNING;
+        }
+    }
+    bench->sqwrite = BENCH_RUNNING;
+    bench->latency = BENCH_RUNNING;
+
+    job_start(&bench->job, bench_thread, bench, JOB_NO_TIMEOUT);
+    return bench;
+}
+
+void end_bench(bench_t *bench)
+{
+    // Ask the worker to stop after its current pass, and wait for it to put
+    // the window back the way it found it.
+    job_end(&bench->job);
+    free(bench->backup);
+    free(bench->source);
+    free(bench);
+}
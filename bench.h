@@ -0,0 +1,68 @@
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "jobs.h"
+
+// How much of a region we benchmark against. Everything in this window is
+// saved first and put back once we are done, even if we are cancelled.
+#define BENCH_WINDOW (32 * 1024)
+
+// How long, in microseconds, each measurement runs for at a minimum. We
+// keep making passes over the window until we've gone at least this long.
+#define BENCH_MIN_US 20000
+
+// The kinds of measurements we make.
+#define BENCH_OP_READ 0
+#define BENCH_OP_WRITE 1
+#define BENCH_OP_COPY 2
+#define BENCH_OPS 3
+
+// The access widths we measure each of the above at, as 8, 16, 32 and 64 bits.
+#define BENCH_WIDTHS 4
+
+// Special result values. Anything else is a throughput in KB/s or a latency in ns.
+#define BENCH_RUNNING 0xFFFFFFFF
+#define BENCH_UNSUPPORTED 0xFFFFFFFE
+
+typedef struct
+{
+    unsigned int startaddr;
+    unsigned int size;
+
+    // The same flags as a memory test uses for this region, which tell us
+    // which access widths it can take and whether it sits behind G2.
+    unsigned int flags;
+
+    // The worker making the measurements, checked for cancellation in
+    // between passes.
+    job_t job;
+
+    // Original contents of the window, and a store queue aligned source
+    // buffer in main RAM.
+    uint32_t *backup;
+    uint32_t *source;
+
+    // Throughput for each operation at each width in KB/s.
+    uint32_t results[BENCH_OPS][BENCH_WIDTHS];
+
+    // Throughput of store queue writes from main RAM in KB/s.
+    uint32_t sqwrite;
+
+    // Average time for a single dependent 32-bit read, in nanoseconds.
+    uint32_t latency;
+} bench_t;
+
+// Returns NULL if there isn't enough free memory for the window's buffers.
+bench_t *start_bench(unsigned int startaddr, unsigned int size, unsigned int flags);
+void end_bench(bench_t *bench);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
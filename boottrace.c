@@ -0,0 +1,142 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <naomi/system.h>
+#include <naomi/timer.h>
+#include "common.h"
+#include "crc.h"
+#include "boottrace.h"
+
+// Marks a valid saved boot trace, "BOOT" when viewed in a hex dump.
+#define BOOTTRACE_MAGIC 0x544F4F42
+
+// The trace is kept at the very end of SRAM, out of the way of the header
+// that the retention test keeps at the start.
+#define BOOTTRACE_SRAM_ADDR (SRAM_BASE + SRAM_SIZE - BOOTTRACE_SRAM_SIZE)
+
+static boottrace_t current;
+static boottrace_t last;
+static unsigned int lastvalid = 0;
+static unsigned int finished = 0;
+static unsigned int saving = 0;
+
+// The running total, and the timer for each step in progress.
+static int total;
+static int profiles[BOOTTRACE_MAX_STEPS];
+
+void boottrace_begin()
+{
+    total = profile_start();
+    memset(&current, 0, sizeof(current));
+    current.magic = BOOTTRACE_MAGIC;
+
+    // Read back whatever the last boot saved before we get to overwrite it.
+    volatile uint32_t *sram = (volatile uint32_t *)BOOTTRACE_SRAM_ADDR;
+    for (unsigned int i = 0; i < sizeof(last) / 4; i++)
+    {
+        ((uint32_t *)&last)[i] = sram[i];
+    }
+
+    lastvalid = (
+        last.magic == BOOTTRACE_MAGIC &&
+        last.count <= BOOTTRACE_MAX_STEPS &&
+        last.crc == crc_update(0, &last, sizeof(last) - sizeof(last.crc))
+    );
+
+    // Only keep saving if we were asked to on an earlier boot, since games
+    // can keep saves anywhere in SRAM.
+    saving = lastvalid;
+}
+
+int boottrace_start(const char *fmt, ...)
+{
+    if (finished || current.count >= BOOTTRACE_MAX_STEPS)
+    {
+        return -1;
+    }
+
+    int step = current.count++;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(current.steps[step].name, BOOTTRACE_NAME_LENGTH, fmt, args);
+    va_end(args);
+
+    profiles[step] = profile_start();
+    return step;
+}
+
+void boottrace_end(int step)
+{
+    if (step < 0 || finished)
+    {
+        return;
+    }
+
+    current.steps[step].us = profile_end(profiles[step]);
+}
+
+void boottrace_save()
+{
+    volatile uint32_t *sram = (volatile uint32_t *)BOOTTRACE_SRAM_ADDR;
+    for (unsigned int i = 0; i < sizeof(current) / 4; i++)
+    {
+        sram[i] = ((uint32_t *)&current)[i];
+    }
+}
+
+void boottrace_finish()
+{
+    if (finished)
+    {
+        return;
+    }
+
+    current.total_us = profile_end(total);
+    current.crc = crc_update(0, &current, sizeof(current) - sizeof(current.crc));
+    finished = 1;
+
+    if (saving)
+    {
+        boottrace_save();
+    }
+}
+
+unsigned int boottrace_saving()
+{
+    return saving;
+}
+
+void boottrace_set_saving(unsigned int enable)
+{
+    if (saving == (enable ? 1 : 0))
+    {
+        return;
+    }
+
+    saving = enable ? 1 : 0;
+    if (saving)
+    {
+        // Nothing to save until the boot is over, finishing will do it.
+        if (finished)
+        {
+            boottrace_save();
+        }
+    }
+    else
+    {
+        // Wiping the marker is enough for the next boot to leave SRAM alone.
+        volatile uint32_t *sram = (volatile uint32_t *)BOOTTRACE_SRAM_ADDR;
+        sram[0] = 0;
+    }
+}
+
+boottrace_t *boottrace_current()
+{
+    return &current;
+}
+
+boottrace_t *boottrace_last()
+{
+    return lastvalid ? &last : NULL;
+}
@@ -0,0 +1,66 @@
+#ifndef __BOOTTRACE_H
+#define __BOOTTRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// The most initialization steps we keep track of. Anything past this is
+// still counted in the total, just not broken out.
+#define BOOTTRACE_MAX_STEPS 24
+
+// The longest step name, including its terminator.
+#define BOOTTRACE_NAME_LENGTH 24
+
+typedef struct
+{
+    char name[BOOTTRACE_NAME_LENGTH];
+    // How long this step took, in microseconds.
+    uint32_t us;
+} boottrace_step_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t count;
+    // Time from boottrace_begin() to boottrace_finish(), in microseconds.
+    uint32_t total_us;
+    boottrace_step_t steps[BOOTTRACE_MAX_STEPS];
+    uint32_t crc;
+} boottrace_t;
+
+// How much of the end of SRAM a saved trace takes up.
+#define BOOTTRACE_SRAM_SIZE ((sizeof(boottrace_t) + 3) & ~3)
+
+// Start timing the boot, and pick up the trace the last boot left in SRAM.
+void boottrace_begin();
+
+// Time a single step, named using printf-style formatting. Once the boot is
+// finished these do nothing, so they're safe to leave in code that also runs
+// long after boot.
+int boottrace_start(const char *fmt, ...);
+void boottrace_end(int step);
+
+// Stop timing the boot, and save the trace to SRAM for next time if saving
+// is turned on.
+void boottrace_finish();
+
+// Whether each boot saves its trace to SRAM. This is only ever on if the
+// last boot left a valid trace there, or it is turned on by hand, so that
+// booting never writes over game saves uninvited. Turning it on saves this
+// boot's trace right away, and turning it off wipes the saved one.
+unsigned int boottrace_saving();
+void boottrace_set_saving(unsigned int saving);
+
+// The trace for this boot, and the one the last boot saved, or NULL if there
+// wasn't a valid one in SRAM.
+boottrace_t *boottrace_current();
+boottrace_t *boottrace_last();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -4,6 +4,7 @@
 #include "common.h"
 #include "state.h"
 #include "controls.h"
+#include "maplewd.h"
 
 #define REPEAT_INITIAL_DELAY 500000
 #define REPEAT_SUBSEQUENT_DELAY 50000
@@ -89,10 +90,22 @@ controls_t get_controls(state_t *state, int reinit, int full_separate)
         }
     }
 
-    // First, poll the buttons and act accordingly.
-    maple_poll_buttons();
-    jvs_buttons_t pressed = maple_buttons_pressed();
-    jvs_buttons_t held = maple_buttons_held();
+    // First, poll the buttons and act accordingly. If an EEPROM request we
+    // gave up on is still on the bus, leave it alone and act as if nothing
+    // has changed since the last poll.
+    jvs_buttons_t pressed;
+    jvs_buttons_t held;
+    if (maplewd_busy())
+    {
+        memset(&pressed, 0, sizeof(pressed));
+        held = maple_buttons_held();
+    }
+    else
+    {
+        maple_poll_buttons();
+        pressed = maple_buttons_pressed();
+        held = maple_buttons_held();
+    }
 
     // Copy over joystick config.
     controls_t controls;
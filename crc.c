@@ -0,0 +1,86 @@
+#include <stdint.h>
+#include "crc.h"
+
+// Reflected polynomial for the standard CRC32, same as zlib uses.
+#define CRC_POLYNOMIAL 0xEDB88320
+
+// Tables for the slice-by-8 kernel, built the first time we're called so
+// that they don't take up space in the ROM.
+static uint32_t crc_tables[8][256];
+static int crc_tables_ready = 0;
+
+void crc_init()
+{
+    for (unsigned int i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ CRC_POLYNOMIAL) : (crc >> 1);
+        }
+        crc_tables[0][i] = crc;
+    }
+
+    // Each further table is the CRC of the previous one shifted through
+    // another zero byte, letting us consume eight bytes per step.
+    for (unsigned int i = 0; i < 256; i++)
+    {
+        for (int slice = 1; slice < 8; slice++)
+        {
+            uint32_t prev = crc_tables[slice - 1][i];
+            crc_tables[slice][i] = (prev >> 8) ^ crc_tables[0][prev & 0xFF];
+        }
+    }
+
+    crc_tables_ready = 1;
+}
+
+uint32_t crc_update(uint32_t crc, const void *data, unsigned int len)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    if (!crc_tables_ready)
+    {
+        crc_init();
+    }
+
+    crc = ~crc;
+
+    // Get ourselves aligned so that we can do word reads.
+    while (len > 0 && (((uintptr_t)bytes) & 3) != 0)
+    {
+        crc = (crc >> 8) ^ crc_tables[0][(crc ^ *bytes) & 0xFF];
+        bytes++;
+        len--;
+    }
+
+    // Now, eight bytes at a time. The SH-4 is little endian so the first
+    // word lines up with the low bytes of the running CRC.
+    while (len >= 8)
+    {
+        uint32_t one = ((const uint32_t *)bytes)[0] ^ crc;
+        uint32_t two = ((const uint32_t *)bytes)[1];
+
+        crc = crc_tables[7][one & 0xFF] ^
+              crc_tables[6][(one >> 8) & 0xFF] ^
+              crc_tables[5][(one >> 16) & 0xFF] ^
+              crc_tables[4][one >> 24] ^
+              crc_tables[3][two & 0xFF] ^
+              crc_tables[2][(two >> 8) & 0xFF] ^
+              crc_tables[1][(two >> 16) & 0xFF] ^
+              crc_tables[0][two >> 24];
+
+        bytes += 8;
+        len -= 8;
+    }
+
+    // Finally, whatever is left over.
+    while (len > 0)
+    {
+        crc = (crc >> 8) ^ crc_tables[0][(crc ^ *bytes) & 0xFF];
+        bytes++;
+        len--;
+    }
+
+    return ~crc;
+}
@@ -0,0 +1,19 @@
+#ifndef __CRC_H
+#define __CRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Update a running CRC32 with more data. This produces the same values as
+// zlib's crc32(), so start with a crc of 0 and compare against any other
+// tool that uses the standard CRC32.
+uint32_t crc_update(uint32_t crc, const void *data, unsigned int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,270 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "crc.h"
+#include "jobs.h"
+#include "maplewd.h"
+#include "eeprombench.h"
+
+// Every EEPROM write made by any run since boot.
+static unsigned int total_writes = 0;
+
+void eeprombench_pattern(unsigned int pattern, uint8_t *data)
+{
+    for (unsigned int i = 0; i < MAPLEWD_EEPROM_SIZE; i++)
+    {
+        if (pattern < 2)
+        {
+            // Neighbouring bits and neighbouring bytes always differ.
+            data[i] = ((i + pattern) & 1) ? 0xAA : 0x55;
+        }
+        else if (pattern < 10)
+        {
+            // Each byte has its set bit somewhere different, so that over
+            // all eight patterns every bit of every byte gets set once.
+            data[i] = 1 << ((i + pattern - 2) & 7);
+        }
+        else
+        {
+            data[i] = ~(1 << ((i + pattern - 10) & 7));
+        }
+    }
+}
+
+unsigned int eeprombench_bucket(uint32_t us)
+{
+    unsigned int bucket = 0;
+    while (bucket < (EEPROMBENCH_BUCKETS - 1) && us >= (EEPROMBENCH_BUCKET_BASE_US << bucket))
+    {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+unsigned int eeprombench_total_writes()
+{
+    return total_writes;
+}
+
+unsigned int eeprombench_cycles_left()
+{
+    // Always leave enough writes to put the original contents back.
+    if (total_writes + EEPROMBENCH_RESTORE_ATTEMPTS >= EEPROMBENCH_MAX_WRITES)
+    {
+        return 0;
+    }
+
+    return EEPROMBENCH_MAX_WRITES - (total_writes + EEPROMBENCH_RESTORE_ATTEMPTS);
+}
+
+void eeprombench_record(eeprom_bench_t *bench, eeprombench_histogram_t *histogram, int result, uint32_t elapsed_us)
+{
+    job_publish_begin(&bench->job);
+    if (result == MAPLEWD_TIMED_OUT || result == MAPLEWD_BUSY)
+    {
+        bench->timeouts++;
+    }
+    else
+    {
+        if (result != MAPLEWD_OK)
+        {
+            bench->failures++;
+        }
+
+        histogram->buckets[eeprombench_bucket(elapsed_us)]++;
+        histogram->min_us = histogram->count ? min(histogram->min_us, elapsed_us) : elapsed_us;
+        histogram->max_us = max(histogram->max_us, elapsed_us);
+        histogram->total_us += elapsed_us;
+        histogram->count++;
+    }
+    job_publish_end(&bench->job);
+}
+
+int eeprombench_read(eeprom_bench_t *bench, uint8_t *data)
+{
+    uint32_t elapsed_us = 0;
+    int result = maplewd_eeprom_read(data, MAPLEWD_DEFAULT_DEADLINE, &elapsed_us);
+    eeprombench_record(bench, &bench->reads, result, elapsed_us);
+    return result;
+}
+
+int eeprombench_write(eeprom_bench_t *bench, uint8_t *data)
+{
+    // Count the write before making it, since a write that fails or times
+    // out may well have still reached the EEPROM.
+    total_writes++;
+    job_publish_begin(&bench->job);
+    bench->written++;
+    job_publish_end(&bench->job);
+
+    uint32_t elapsed_us = 0;
+    int result = maplewd_eeprom_write(data, MAPLEWD_DEFAULT_DEADLINE, &elapsed_us);
+    eeprombench_record(bench, &bench->writes, result, elapsed_us);
+    return result;
+}
+
+void eeprombench_set_state(eeprom_bench_t *bench, unsigned int state)
+{
+    job_publish_begin(&bench->job);
+    bench->state = state;
+    job_publish_end(&bench->job);
+}
+
+int eeprombench_poll(eeprom_bench_t *bench)
+{
+    if (bench->poll != NULL && bench->poll(bench->pollparam))
+    {
+        job_publish_begin(&bench->job);
+        bench->exit = 1;
+        job_publish_end(&bench->job);
+    }
+
+    return bench->exit || job_cancelled(&bench->job);
+}
+
+unsigned int eeprombench_restore(eeprom_bench_t *bench, uint8_t *original)
+{
+    uint8_t readback[MAPLEWD_EEPROM_SIZE];
+
+    for (int attempt = 0; attempt < EEPROMBENCH_RESTORE_ATTEMPTS; attempt++)
+    {
+        if (eeprombench_write(bench, original) != MAPLEWD_OK)
+        {
+            continue;
+        }
+        if (eeprombench_read(bench, readback) != MAPLEWD_OK)
+        {
+            continue;
+        }
+
+        uint32_t crc = crc_update(0, readback, MAPLEWD_EEPROM_SIZE);
+        job_publish_begin(&bench->job);
+        bench->crcafter = crc;
+        job_publish_end(&bench->job);
+
+        if (crc == bench->crcbefore)
+        {
+            return EEPROMBENCH_RESTORE_OK;
+        }
+    }
+
+    return EEPROMBENCH_RESTORE_FAILED;
+}
+
+unsigned int eeprombench_thread(void *param)
+{
+    eeprom_bench_t *bench = (eeprom_bench_t *)param;
+    uint8_t original[MAPLEWD_EEPROM_SIZE];
+    uint8_t pattern[MAPLEWD_EEPROM_SIZE];
+    uint8_t readback[MAPLEWD_EEPROM_SIZE];
+
+    /* First, get a copy of the original contents we can trust, by reading
+       it twice and making sure both agree. */
+    eeprombench_set_state(bench, EEPROMBENCH_STATE_READING);
+    if (
+        eeprombench_read(bench, original) != MAPLEWD_OK ||
+        eeprombench_read(bench, readback) != MAPLEWD_OK ||
+        memcmp(original, readback, MAPLEWD_EEPROM_SIZE) != 0
+    ) {
+        job_publish_begin(&bench->job);
+        bench->state = EEPROMBENCH_STATE_NO_ORIGINAL;
+        bench->restore = EEPROMBENCH_RESTORE_UNTOUCHED;
+        job_publish_end(&bench->job);
+        return JOB_FAILED;
+    }
+
+    uint32_t crc = crc_update(0, original, MAPLEWD_EEPROM_SIZE);
+    unsigned int cycles = min(bench->cycles, eeprombench_cycles_left());
+    job_publish_begin(&bench->job);
+    bench->crcbefore = crc;
+    bench->cycles = cycles;
+    if (cycles == 0)
+    {
+        bench->state = EEPROMBENCH_STATE_NO_WRITES_LEFT;
+        bench->restore = EEPROMBENCH_RESTORE_UNTOUCHED;
+    }
+    job_publish_end(&bench->job);
+
+    if (cycles == 0)
+    {
+        return JOB_FAILED;
+    }
+
+    /* Now, write and read back each pattern in turn, stopping early if we
+       are asked to or the bus stops answering. */
+    eeprombench_set_state(bench, EEPROMBENCH_STATE_CYCLING);
+    for (unsigned int cycle = 0; cycle < cycles; cycle++)
+    {
+        if (eeprombench_poll(bench) || bench->timeouts > 0)
+        {
+            break;
+        }
+
+        // There's no point reading back a pattern that never made it out,
+        // the failure or timeout has already been counted.
+        eeprombench_pattern(cycle % EEPROMBENCH_PATTERNS, pattern);
+        if (eeprombench_write(bench, pattern) != MAPLEWD_OK)
+        {
+            continue;
+        }
+
+        for (int read = 0; read < EEPROMBENCH_READS_PER_CYCLE; read++)
+        {
+            if (eeprombench_read(bench, readback) == MAPLEWD_OK && memcmp(pattern, readback, MAPLEWD_EEPROM_SIZE) != 0)
+            {
+                job_publish_begin(&bench->job);
+                bench->mismatches++;
+                job_publish_end(&bench->job);
+            }
+        }
+
+        job_progress(&bench->job, cycle + 1, cycles);
+    }
+
+    /* Next, wait for any write we gave up on to actually finish, since it
+       could otherwise land on top of the original once we put it back. */
+    eeprombench_set_state(bench, EEPROMBENCH_STATE_SETTLING);
+    unsigned int restore = EEPROMBENCH_RESTORE_UNVERIFIED;
+    if (maplewd_wait_idle(EEPROMBENCH_SETTLE_US))
+    {
+        /* Finally, always put back what we found, whether or not we finished. */
+        eeprombench_set_state(bench, EEPROMBENCH_STATE_RESTORING);
+        restore = eeprombench_restore(bench, original);
+    }
+
+    job_publish_begin(&bench->job);
+    bench->state = EEPROMBENCH_STATE_FINISHED;
+    bench->restore = restore;
+    job_publish_end(&bench->job);
+
+    return restore == EEPROMBENCH_RESTORE_OK ? JOB_FINISHED : JOB_FAILED;
+}
+
+eeprom_bench_t *start_eeprom_bench(unsigned int cycles, eeprombench_poll_t poll, void *pollparam)
+{
+    eeprom_bench_t *bench = malloc(sizeof(eeprom_bench_t));
+    if (bench == NULL)
+    {
+        return NULL;
+    }
+    memset(bench, 0, sizeof(eeprom_bench_t));
+    bench->cycles = cycles;
+    bench->poll = poll;
+    bench->pollparam = pollparam;
+    bench->state = EEPROMBENCH_STATE_READING;
+    bench->restore = EEPROMBENCH_RESTORE_PENDING;
+    job_start(&bench->job, eeprombench_thread, bench, JOB_NO_TIMEOUT);
+    return bench;
+}
+
+void end_eeprom_bench(eeprom_bench_t *bench)
+{
+    // The worker only stops in between cycles, and then waits out stuck
+    // requests and puts back the original contents, which can take seconds.
+    // The screen waits for the job to report that it is done before calling
+    // this, so that it never sits here waiting on the maple bus.
+    job_end(&bench->job);
+    free(bench);
+}
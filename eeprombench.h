@@ -0,0 +1,126 @@
+#ifndef __EEPROMBENCH_H
+#define __EEPROMBENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "jobs.h"
+#include "maplewd.h"
+
+// Every cycle writes one pattern and reads it back this many times. Reads
+// don't wear the EEPROM, so we take more of them.
+#define EEPROMBENCH_READS_PER_CYCLE 2
+
+// The patterns we cycle through: a checkerboard and its inverse, then a
+// single set bit and a single clear bit walking through every byte.
+#define EEPROMBENCH_PATTERNS 18
+
+// The EEPROM wears out with writes, so we cap how many we will make since
+// boot. A restore always fits, since we set aside room for it up front.
+#define EEPROMBENCH_MAX_WRITES 1024
+#define EEPROMBENCH_RESTORE_ATTEMPTS 3
+
+// How long, in microseconds, we wait for a request that timed out to finish
+// before putting the original back. A pattern write could still land after
+// the restore and overwrite it, so we can't call a restore good until then.
+#define EEPROMBENCH_SETTLE_US (5 * MAPLEWD_DEFAULT_DEADLINE)
+
+// Latency histogram buckets. The first holds everything under the base,
+// each one after covers double the range of the last, and the final one
+// holds everything else.
+#define EEPROMBENCH_BUCKETS 12
+#define EEPROMBENCH_BUCKET_BASE_US 500
+
+// Worst case latencies past which we flag the IO board as slow. A healthy
+// board is well under both.
+#define EEPROMBENCH_SLOW_READ_US 50000
+#define EEPROMBENCH_SLOW_WRITE_US 200000
+
+// Where the benchmark is.
+#define EEPROMBENCH_STATE_READING 0
+#define EEPROMBENCH_STATE_CYCLING 1
+#define EEPROMBENCH_STATE_RESTORING 2
+#define EEPROMBENCH_STATE_FINISHED 3
+#define EEPROMBENCH_STATE_NO_ORIGINAL 4
+#define EEPROMBENCH_STATE_NO_WRITES_LEFT 5
+#define EEPROMBENCH_STATE_SETTLING 6
+
+// How putting back the original contents went.
+#define EEPROMBENCH_RESTORE_PENDING 0
+#define EEPROMBENCH_RESTORE_OK 1
+#define EEPROMBENCH_RESTORE_FAILED 2
+#define EEPROMBENCH_RESTORE_UNTOUCHED 3
+#define EEPROMBENCH_RESTORE_UNVERIFIED 4
+
+// Called in between requests, since nothing else may use the maple bus
+// while we run. Returns nonzero if the user wants to stop.
+typedef int (*eeprombench_poll_t)(void *param);
+
+typedef struct
+{
+    unsigned int buckets[EEPROMBENCH_BUCKETS];
+    unsigned int count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} eeprombench_histogram_t;
+
+typedef struct
+{
+    unsigned int cycles;
+    eeprombench_poll_t poll;
+    void *pollparam;
+
+    // The worker running the benchmark. Its progress counts cycles.
+    job_t job;
+
+    // Where we are, and whether the user asked to stop.
+    unsigned int state;
+    unsigned int exit;
+
+    // How long every read and write took.
+    eeprombench_histogram_t reads;
+    eeprombench_histogram_t writes;
+
+    // Patterns that read back wrong, requests that failed outright and
+    // requests that never came back or never went out because an earlier
+    // one was still stuck on the bus.
+    unsigned int mismatches;
+    unsigned int failures;
+    unsigned int timeouts;
+
+    // Writes made by this run, including putting back the original.
+    unsigned int written;
+
+    // Checksums of the original contents, and of what we read back after
+    // putting them back.
+    uint32_t crcbefore;
+    uint32_t crcafter;
+    unsigned int restore;
+} eeprom_bench_t;
+
+// Fill data with one of the test patterns.
+void eeprombench_pattern(unsigned int pattern, uint8_t *data);
+
+// Which histogram bucket a latency falls in.
+unsigned int eeprombench_bucket(uint32_t us);
+
+// How many EEPROM writes have been made since boot, by every run.
+unsigned int eeprombench_total_writes();
+
+// How many cycles a run can have without going over the write cap.
+unsigned int eeprombench_cycles_left();
+
+// Returns NULL if there's no memory for the run. A run stops early once the
+// poll callback asks it to, but only after putting the original contents
+// back, so wait for the job to be done before ending it from the UI.
+eeprom_bench_t *start_eeprom_bench(unsigned int cycles, eeprombench_poll_t poll, void *pollparam);
+void end_eeprom_bench(eeprom_bench_t *bench);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <naomi/timer.h>
+#include <naomi/thread.h>
+#include "jobs.h"
+
+// Keeps the compiler from moving memory accesses across a sequence update.
+// We only ever run on the one CPU, so nothing stronger is needed.
+#define JOB_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+void *job_thread(void *param)
+{
+    job_t *job = (job_t *)param;
+
+    job->state = JOB_RUNNING;
+    unsigned int result = job->func(job->param);
+
+    // A job that ran out of time has already been reported as timed out, so
+    // it stays that way however it ended. Anything else reports how it
+    // actually ended even if we asked it to stop.
+    if (job->timedout)
+    {
+        result = JOB_TIMED_OUT;
+    }
+    job->state = result;
+    job->done = 1;
+
+    return NULL;
+}
+
+void job_start(job_t *job, job_func_t func, void *param, uint32_t timeout_us)
+{
+    job->func = func;
+    job->param = param;
+    job->state = JOB_PENDING;
+    job->done = 0;
+    job->cancel = 0;
+    job->timedout = 0;
+    job->timer = timeout_us != JOB_NO_TIMEOUT ? timer_start(timeout_us) : -1;
+    job->progress = 0;
+    job->total = 0;
+    job->sequence = 0;
+    job->requests = 0;
+    pthread_create(&job->thread, NULL, job_thread, job);
+}
+
+void job_end(job_t *job)
+{
+    job->cancel = 1;
+    pthread_join(job->thread, NULL);
+
+    if (job->timer >= 0)
+    {
+        timer_stop(job->timer);
+        job->timer = -1;
+    }
+}
+
+void job_abandon(job_t *job)
+{
+    job->cancel = 1;
+    pthread_detach(job->thread);
+
+    if (job->timer >= 0)
+    {
+        timer_stop(job->timer);
+        job->timer = -1;
+    }
+}
+
+int job_cancelled(job_t *job)
+{
+    if (!job->cancel && job->timer >= 0 && timer_left(job->timer) == 0)
+    {
+        job->timedout = 1;
+        job->cancel = 1;
+    }
+
+    return job->cancel;
+}
+
+unsigned int job_state(job_t *job)
+{
+    // Time a job out even if it is stuck somewhere it can't check.
+    unsigned int state = job->state;
+    if ((state == JOB_PENDING || state == JOB_RUNNING) && job_cancelled(job) && job->timedout)
+    {
+        // It may have only just returned, in which case it says how it went.
+        state = job->state;
+        if (state == JOB_PENDING || state == JOB_RUNNING)
+        {
+            return JOB_TIMED_OUT;
+        }
+    }
+
+    return state;
+}
+
+int job_done(job_t *job)
+{
+    return job->done;
+}
+
+void job_progress(job_t *job, uint32_t progress, uint32_t total)
+{
+    job->total = total;
+    job->progress = progress;
+}
+
+static void sequence_begin(volatile uint32_t *sequence)
+{
+    (*sequence)++;
+    JOB_BARRIER();
+}
+
+static void sequence_end(volatile uint32_t *sequence)
+{
+    JOB_BARRIER();
+    (*sequence)++;
+}
+
+static void sequence_read(volatile uint32_t *sequence, void *dest, const void *src, unsigned int size)
+{
+    uint32_t before;
+    do
+    {
+        // If the writer was interrupted partway through an update, let it finish.
+        while ((before = *sequence) & 1)
+        {
+            thread_yield();
+        }
+
+        JOB_BARRIER();
+        memcpy(dest, src, size);
+        JOB_BARRIER();
+    } while (*sequence != before);
+}
+
+void job_publish_begin(job_t *job)
+{
+    sequence_begin(&job->sequence);
+}
+
+void job_publish_end(job_t *job)
+{
+    sequence_end(&job->sequence);
+}
+
+void job_read(job_t *job, void *dest, const void *src, unsigned int size)
+{
+    sequence_read(&job->sequence, dest, src, size);
+}
+
+void job_request_begin(job_t *job)
+{
+    sequence_begin(&job->requests);
+}
+
+void job_request_end(job_t *job)
+{
+    sequence_end(&job->requests);
+}
+
+void job_read_request(job_t *job, void *dest, const void *src, unsigned int size)
+{
+    sequence_read(&job->requests, dest, src, size);
+}
@@ -0,0 +1,103 @@
+#ifndef __JOBS_H
+#define __JOBS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <pthread.h>
+
+// Where a job is in its life. A job only ever moves forward through these.
+#define JOB_PENDING 0
+#define JOB_RUNNING 1
+#define JOB_FINISHED 2
+#define JOB_FAILED 3
+#define JOB_CANCELLED 4
+#define JOB_TIMED_OUT 5
+
+// Passed to job_start() for a job that may take as long as it likes.
+#define JOB_NO_TIMEOUT 0
+
+// Does the work and returns the state it ended in, JOB_FINISHED or
+// JOB_FAILED. Long running work should check job_cancelled() often and
+// return JOB_CANCELLED as soon as it is set, which becomes JOB_TIMED_OUT if
+// the job ran out of time.
+typedef unsigned int (*job_func_t)(void *param);
+
+typedef struct
+{
+    pthread_t thread;
+    job_func_t func;
+    void *param;
+
+    // One of the job states above.
+    volatile unsigned int state;
+
+    // Set once func has returned and the thread is done with the job.
+    volatile unsigned int done;
+
+    // Set when the UI wants the job to stop, or when it has run out of time.
+    // The job is never cancelled outright, it has to notice and return.
+    volatile unsigned int cancel;
+    volatile unsigned int timedout;
+
+    // Timer counting down to the timeout, or -1 if there isn't one.
+    int timer;
+
+    // How far along the job is, in whatever units it likes. These are
+    // updated on their own, so they may be a moment out of step.
+    volatile uint32_t progress;
+    volatile uint32_t total;
+
+    // Bumped before and after every update to the job's results, so that it
+    // is odd whenever an update is underway.
+    volatile uint32_t sequence;
+
+    // The same again for settings the UI hands to the job while it runs.
+    volatile uint32_t requests;
+} job_t;
+
+// Start running func on a background thread. The job is usually embedded in
+// the structure that holds its results, which is passed in as param.
+void job_start(job_t *job, job_func_t func, void *param, uint32_t timeout_us);
+
+// Ask the job to stop, and wait until it has.
+void job_end(job_t *job);
+
+// Give up on a job that is stuck somewhere it can't check for cancellation.
+// It is left to finish on its own, so the job and anything it uses must not
+// be freed until job_done() says it has.
+void job_abandon(job_t *job);
+
+// Polled by the job to see if it should stop, and by the UI for its state.
+// A job that runs past its timeout reports JOB_TIMED_OUT straight away,
+// even while it is still stuck running.
+int job_cancelled(job_t *job);
+unsigned int job_state(job_t *job);
+
+// Whether the job's thread has actually returned, which job_state() can't
+// say for a job that has timed out.
+int job_done(job_t *job);
+void job_progress(job_t *job, uint32_t progress, uint32_t total);
+
+// Wrap every update the job makes to its results.
+void job_publish_begin(job_t *job);
+void job_publish_end(job_t *job);
+
+// Copy size bytes of a job's results from src to dest, as they stood between
+// two updates. This never blocks the job, it just tries again if an update
+// happened partway through the copy.
+void job_read(job_t *job, void *dest, const void *src, unsigned int size);
+
+// The other way around, for the UI to change what a running job is doing.
+// The UI wraps its updates and the job reads them, with the same guarantees.
+void job_request_begin(job_t *job);
+void job_request_end(job_t *job);
+void job_read_request(job_t *job, void *dest, const void *src, unsigned int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
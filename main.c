@@ -1,83 +1,70 @@
 #include <stdint.h>
+#include <string.h>
 #include <naomi/video.h>
 #include <naomi/ta.h>
 #include <naomi/eeprom.h>
 #include <naomi/timer.h>
-#include <naomi/audio.h>
 #include <naomi/font.h>
 #include "common.h"
 #include "state.h"
 #include "screens.h"
-
-// Sounds compiled in from Makefile.
-extern uint8_t *scroll_raw_data;
-extern unsigned int scroll_raw_len;
-extern uint8_t *scale_raw_data;
-extern unsigned int scale_raw_len;
-
-// Sprites, compiled in from Makefile.
-extern unsigned int up_png_width;
-extern unsigned int up_png_height;
-extern void *up_png_data;
-extern unsigned int dn_png_width;
-extern unsigned int dn_png_height;
-extern void *dn_png_data;
-extern unsigned int cursor_png_width;
-extern unsigned int cursor_png_height;
-extern void *cursor_png_data;
-extern unsigned int pswoff_png_width;
-extern unsigned int pswoff_png_height;
-extern void *pswoff_png_data;
-extern unsigned int pswon_png_width;
-extern unsigned int pswon_png_height;
-extern void *pswon_png_data;
-extern unsigned int buttonmask_png_width;
-extern unsigned int buttonmask_png_height;
-extern void *buttonmask_png_data;
+#include "sounds.h"
+#include "assets.h"
+#include "pack.h"
+#include "boottrace.h"
 
 void main()
 {
+    // Time every step from here until the first menu frame is on screen.
+    boottrace_begin();
+
     // Grab the system configuration for monitor rotation/etc.
     eeprom_t settings;
+    int step = boottrace_start("eeprom_read");
     eeprom_read(&settings);
+    boottrace_end(step);
 
     // Init the screen for full range of color for video test subsystem.
+    step = boottrace_start("video_init");
     video_init(VIDEO_COLOR_8888);
     ta_set_background_color(rgb(0, 0, 0));
-
-    // Init audio system for audio test subsystem.
-    audio_init();
+    boottrace_end(step);
 
     // Create global state for the menu.
     state_t state;
     state.settings = &settings;
 
-    // Initialize some system sounds.
-    state.sounds.scroll = audio_register_sound(AUDIO_FORMAT_16BIT, 44100, scroll_raw_data, scroll_raw_len / 2);
-    state.sounds.scale = audio_register_sound(AUDIO_FORMAT_16BIT, 11025, scale_raw_data, scale_raw_len / 2);
-    audio_set_registered_sound_loop(state.sounds.scale, 0);
+    // Init audio system and system sounds for audio test subsystem.
+    sounds_init(&state.sounds);
+
+    // Verify any SRAM retention pattern left for us before we last lost power.
+    step = boottrace_start("retention_check");
+    retention_check(&state.retention);
+    boottrace_end(step);
 
-    // Attach our menu/system fonts
-    extern uint8_t *dejavusans_ttf_data;
-    extern unsigned int dejavusans_ttf_len;
+    // Attach our menu/system fonts. FreeType reads the font data for as long
+    // as the font is around, so these stay allocated.
+    unsigned int dejavusans_ttf_len = 0;
+    step = boottrace_start("inflate dejavusans.ttf");
+    uint8_t *dejavusans_ttf_data = pack_load("dejavusans.ttf", &dejavusans_ttf_len);
+    boottrace_end(step);
+
+    step = boottrace_start("font_add 18pt");
     state.font_18pt = font_add(dejavusans_ttf_data, dejavusans_ttf_len);
+    boottrace_end(step);
+    step = boottrace_start("font_set_size 18pt");
     font_set_size(state.font_18pt, 18);
+    boottrace_end(step);
+    step = boottrace_start("font_add 12pt");
     state.font_12pt = font_add(dejavusans_ttf_data, dejavusans_ttf_len);
+    boottrace_end(step);
+    step = boottrace_start("font_set_size 12pt");
     font_set_size(state.font_12pt, 12);
+    boottrace_end(step);
 
-    // Attach our input test font
-    extern uint8_t *dejavumono_ttf_data;
-    extern unsigned int dejavumono_ttf_len;
-    state.font_mono = font_add(dejavumono_ttf_data, dejavumono_ttf_len);
-    font_set_size(state.font_mono, 12);
-
-    // Attach our sprites
-    state.sprites.up = ta_texture_desc_malloc_direct(up_png_width, up_png_data, TA_TEXTUREMODE_ARGB1555);
-    state.sprites.down = ta_texture_desc_malloc_direct(dn_png_width, dn_png_data, TA_TEXTUREMODE_ARGB1555);
-    state.sprites.cursor = ta_texture_desc_malloc_direct(cursor_png_width, cursor_png_data, TA_TEXTUREMODE_ARGB1555);
-    state.sprites.pswoff = ta_texture_desc_malloc_direct(pswoff_png_width, pswoff_png_data, TA_TEXTUREMODE_ARGB1555);
-    state.sprites.pswon = ta_texture_desc_malloc_direct(pswon_png_width, pswon_png_data, TA_TEXTUREMODE_ARGB1555);
-    state.sprites.buttonmask = ta_texture_desc_malloc_direct(buttonmask_png_width, buttonmask_png_data, TA_TEXTUREMODE_ARGB1555);
+    // Everything else is loaded by each screen the first time it is shown.
+    memset(&state.sprites, 0, sizeof(state.sprites));
+    state.font_mono = NULL;
 
     // FPS calculation for debugging.
     double fps_value = 60.0;
@@ -102,12 +89,19 @@ void main()
         ta_render();
         uint32_t draw_time = profile_end(profile);
 
+        // The first menu frame is drawn, so we're done booting.
+        boottrace_finish();
+
         // Display some debugging info.
         if (DEBUG_ENABLED)
         {
             video_draw_debug_text((video_width() / 2) - (18 * 4), video_height() - 40, rgb(0, 200, 255), "uS full draw: %d", draw_time);
             video_draw_debug_text((video_width() / 2) - (18 * 4), video_height() - 32, rgb(0, 200, 255), "FPS: %.01f, %dx%d", fps_value, video_width(), video_height());
             video_draw_debug_text((video_width() / 2) - (28 * 4), video_height() - 24, rgb(0, 200, 255), "CPU draw time consume: %.01f%%", (draw_time * fps_value) / 10000.00);
+
+            pack_stats_t stats = pack_get_stats();
+            video_draw_debug_text((video_width() / 2) - (28 * 4), video_height() - 16, rgb(0, 200, 255), "Boot: %dms, %dKB inflated from %dKB in %dms", boottrace_current()->total_us / 1000, stats.inflated / 1024, stats.compressed / 1024, stats.inflate_us / 1000);
+            video_draw_debug_text((video_width() / 2) - (28 * 4), video_height() - 8, rgb(0, 200, 255), "Assets: %02X loaded, %dKB resident", assets_loaded(), assets_resident_bytes() / 1024);
         }
 
         // Actually draw the buffer.
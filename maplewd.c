@@ -0,0 +1,162 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <naomi/maple.h>
+#include <naomi/timer.h>
+#include <naomi/thread.h>
+#include "jobs.h"
+#include "maplewd.h"
+
+// How long we sleep in between checking on an outstanding request.
+#define MAPLEWD_POLL_US 1000
+
+typedef struct
+{
+    // The request itself, run as a job so that we can walk away from it.
+    job_t job;
+    int write;
+    uint8_t data[MAPLEWD_EEPROM_SIZE];
+} maplewd_request_t;
+
+static unsigned int abandoned = 0;
+
+// The last request we gave up on, until we have seen it finish. The reset
+// that follows a timeout is the only thing we put on the bus while it is
+// outstanding, since that is what knocks it loose. Everything else waits
+// for it, so that two requests never fight over the bus.
+static maplewd_request_t *stuck = NULL;
+static pthread_mutex_t stuck_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int maplewd_reap()
+{
+    // Returns nonzero if the bus is free. A stuck request that has finished
+    // is done with its memory, so it can finally be freed.
+    pthread_mutex_lock(&stuck_mutex);
+    if (stuck != NULL)
+    {
+        if (job_done(&stuck->job))
+        {
+            free(stuck);
+            stuck = NULL;
+        }
+    }
+
+    int idle = stuck == NULL;
+    pthread_mutex_unlock(&stuck_mutex);
+    return idle;
+}
+
+int maplewd_busy()
+{
+    return !maplewd_reap();
+}
+
+int maplewd_wait_idle(uint32_t wait_us)
+{
+    uint32_t waited = 0;
+    while (!maplewd_reap())
+    {
+        if (waited >= wait_us)
+        {
+            return 0;
+        }
+
+        thread_sleep(MAPLEWD_POLL_US);
+        waited += MAPLEWD_POLL_US;
+    }
+
+    return 1;
+}
+
+unsigned int maplewd_thread(void *param)
+{
+    maplewd_request_t *request = (maplewd_request_t *)param;
+    int result;
+
+    if (request->write)
+    {
+        result = MAPLEWD_EEPROM_WRITE(request->data);
+    }
+    else
+    {
+        result = MAPLEWD_EEPROM_READ(request->data);
+    }
+
+    return result == 0 ? JOB_FINISHED : JOB_FAILED;
+}
+
+int maplewd_request(int write, uint8_t *data, uint32_t deadline_us, uint32_t *elapsed_us)
+{
+    // Give a request we walked away from earlier the same deadline to get
+    // off the bus, and don't send anything if it still hasn't.
+    int profile = profile_start();
+    if (!maplewd_wait_idle(deadline_us))
+    {
+        *elapsed_us = profile_end(profile);
+        return MAPLEWD_BUSY;
+    }
+
+    maplewd_request_t *request = malloc(sizeof(maplewd_request_t));
+    if (request == NULL)
+    {
+        *elapsed_us = profile_end(profile);
+        return MAPLEWD_FAILED;
+    }
+    request->write = write;
+    if (write)
+    {
+        memcpy(request->data, data, MAPLEWD_EEPROM_SIZE);
+    }
+
+    job_start(&request->job, maplewd_thread, request, deadline_us);
+
+    unsigned int state;
+    while ((state = job_state(&request->job)) == JOB_PENDING || state == JOB_RUNNING)
+    {
+        thread_sleep(MAPLEWD_POLL_US);
+    }
+
+    *elapsed_us = profile_end(profile);
+    if (state == JOB_TIMED_OUT)
+    {
+        // The request is stuck somewhere it will never notice being
+        // cancelled. Leave it be, since it still owns the request, and
+        // kick the bus so that it has a chance of coming back. Until it
+        // does, later requests wait for it rather than joining it.
+        job_abandon(&request->job);
+        abandoned++;
+
+        pthread_mutex_lock(&stuck_mutex);
+        stuck = request;
+        pthread_mutex_unlock(&stuck_mutex);
+
+        MAPLEWD_RESET();
+        return MAPLEWD_TIMED_OUT;
+    }
+
+    job_end(&request->job);
+
+    if (!write && state == JOB_FINISHED)
+    {
+        memcpy(data, request->data, MAPLEWD_EEPROM_SIZE);
+    }
+    free(request);
+
+    return state == JOB_FINISHED ? MAPLEWD_OK : MAPLEWD_FAILED;
+}
+
+int maplewd_eeprom_read(uint8_t *data, uint32_t deadline_us, uint32_t *elapsed_us)
+{
+    return maplewd_request(0, data, deadline_us, elapsed_us);
+}
+
+int maplewd_eeprom_write(const uint8_t *data, uint32_t deadline_us, uint32_t *elapsed_us)
+{
+    return maplewd_request(1, (uint8_t *)data, deadline_us, elapsed_us);
+}
+
+unsigned int maplewd_abandoned()
+{
+    return abandoned;
+}
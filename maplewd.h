@@ -0,0 +1,58 @@
+#ifndef __MAPLEWD_H
+#define __MAPLEWD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Every maple request the watchdog makes goes through these. A build can
+// define them ahead of time to point at something other than the real bus,
+// such as a stand-in backend that stalls on purpose.
+#ifndef MAPLEWD_EEPROM_READ
+#define MAPLEWD_EEPROM_READ(data) maple_request_eeprom_read(data)
+#define MAPLEWD_EEPROM_WRITE(data) maple_request_eeprom_write(data)
+#define MAPLEWD_RESET() maple_request_reset()
+#endif
+
+// The size of the EEPROM on the IO board.
+#define MAPLEWD_EEPROM_SIZE 128
+
+// How long, in microseconds, a single request gets by default. A healthy IO
+// board answers in a few milliseconds.
+#define MAPLEWD_DEFAULT_DEADLINE 1000000
+
+// How a request ended.
+#define MAPLEWD_OK 0
+#define MAPLEWD_FAILED 1
+#define MAPLEWD_TIMED_OUT 2
+#define MAPLEWD_BUSY 3
+
+// Make a single EEPROM request, giving up on it if it hasn't come back by
+// the deadline. A request that times out is left to finish on its own and
+// the bus is reset to knock it loose. Nothing else goes out on the bus until
+// it has finished, so a later request first waits up to its own deadline for
+// that and returns MAPLEWD_BUSY without sending anything if it is still
+// stuck. The time the request took, including any wait, is stored in
+// elapsed_us in microseconds.
+int maplewd_eeprom_read(uint8_t *data, uint32_t deadline_us, uint32_t *elapsed_us);
+int maplewd_eeprom_write(const uint8_t *data, uint32_t deadline_us, uint32_t *elapsed_us);
+
+// How many requests have been given up on since boot.
+unsigned int maplewd_abandoned();
+
+// Whether a request we gave up on is still outstanding. Anything else that
+// talks on the maple bus, such as polling the controls, should leave it
+// alone until this returns zero.
+int maplewd_busy();
+
+// Wait up to wait_us microseconds for any request we gave up on to finish.
+// Returns nonzero once the bus is free, or zero if it still isn't.
+int maplewd_wait_idle(uint32_t wait_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1079 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <naomi/system.h>
+#include <naomi/timer.h>
+#include "common.h"
+#include "memtest.h"
+#include "crc.h"
+#include "jobs.h"
+
+// How long the last request to stop a memory test took to be honored.
+static uint32_t exit_latency = 0;
+
+void record_fault_lanes(memory_test_t *memtest, unsigned int addr, uint8_t xormask, uint32_t lanes)
+{
+    memtest_faults_t *faults = &memtest->faults;
+
+    job_publish_begin(&memtest->job);
+
+    // First, account for which data lines were wrong.
+    faults->total++;
+    for (int bit = 0; bit < MEMTEST_LANES; bit++)
+    {
+        if (lanes & (1U << bit))
+        {
+            faults->lanes[bit]++;
+        }
+    }
+
+    // Now, mark where in the region this happened.
+    unsigned int cell = (addr - memtest->startaddr) / faults->cellsize;
+    if (cell < MEMTEST_MAP_CELLS && faults->map[cell] < 0xFFFF)
+    {
+        faults->map[cell]++;
+    }
+
+    // Finally, fold this into an existing run if it touches one, since
+    // failures tend to come in long stretches.
+    for (unsigned int i = 0; i < faults->runcount; i++)
+    {
+        memtest_fault_run_t *run = &faults->runs[i];
+        if (addr >= run->addr && addr <= run->addr + run->length)
+        {
+            if (addr == run->addr + run->length)
+            {
+                run->length++;
+            }
+            run->xormask |= xormask;
+
+            job_publish_end(&memtest->job);
+            return;
+        }
+    }
+
+    if (faults->runcount < MEMTEST_MAX_FAULT_RUNS)
+    {
+        faults->runs[faults->runcount].addr = addr;
+        faults->runs[faults->runcount].length = 1;
+        faults->runs[faults->runcount].xormask = xormask;
+        faults->runcount++;
+    }
+    else
+    {
+        faults->overflow++;
+    }
+
+    job_publish_end(&memtest->job);
+}
+
+void record_fault(memory_test_t *memtest, unsigned int addr, uint8_t expected, uint8_t actual)
+{
+    // On a byte-wide bus, each bit of the byte is its own data line.
+    record_fault_lanes(memtest, addr, expected ^ actual, expected ^ actual);
+}
+
+uint32_t xorshift32(uint32_t x)
+{
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+void record_word_fault(memory_test_t *memtest, unsigned int addr, uint32_t expected, uint32_t actual)
+{
+    // Faults are mapped per byte so that they line up with the byte-wide
+    // tests, so split the word up the same way the SH-4 lays it out. Each
+    // byte still counts against its own lanes of the 32-bit bus, so that a
+    // bad data line or chip can be told apart from the others.
+    for (int byte = 0; byte < 4; byte++)
+    {
+        uint8_t xormask = ((expected ^ actual) >> (byte * 8)) & 0xFF;
+        if (xormask)
+        {
+            record_fault_lanes(memtest, addr + byte, xormask, (uint32_t)xormask << (byte * 8));
+        }
+    }
+}
+
+void word_write(memory_test_t *memtest, unsigned int addr, uint32_t value)
+{
+    if (memtest->flags & MEMTEST_FLAG_G2)
+    {
+        // The G2 FIFO only holds so many writes, so let it drain before each
+        // batch instead of stalling the bus by overrunning it.
+        if (memtest->g2pending == 0)
+        {
+            MEMTEST_G2_WAIT();
+        }
+        memtest->g2pending = (memtest->g2pending + 1) % MEMTEST_G2_BATCH;
+    }
+
+    MEMTEST_WRITE32(addr, value);
+}
+
+void save_chunk(uint32_t *dest, unsigned int src, unsigned int len)
+{
+    // The backup buffer lives in cached main RAM, so we copy into it with
+    // the CPU instead of the store queues to keep the cache coherent.
+    if (((src | len) & 3) == 0)
+    {
+        for (unsigned int i = 0; i < len / 4; i++)
+        {
+            dest[i] = MEMTEST_READ32(src + (i * 4));
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < len; i++)
+        {
+            ((uint8_t *)dest)[i] = MEMTEST_READ8(src + i);
+        }
+    }
+}
+
+void restore_chunk(memory_test_t *memtest, unsigned int dest, uint32_t *src, unsigned int len)
+{
+#if MEMTEST_DIRECT_ACCESS
+    if (((dest | (uint32_t)src | len) & 31) == 0 && !(memtest->flags & MEMTEST_FLAG_G2))
+    {
+        // Everything lines up, so let the store queues do the work.
+        hw_memcpy((void *)dest, src, len);
+        return;
+    }
+#endif
+
+    if (((dest | len) & 3) == 0)
+    {
+        for (unsigned int i = 0; i < len / 4; i++)
+        {
+            word_write(memtest, dest + (i * 4), src[i]);
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < len; i++)
+        {
+            MEMTEST_WRITE8(dest + i, ((uint8_t *)src)[i]);
+        }
+    }
+}
+
+int chunk_begin(memory_test_t *memtest, unsigned int addr, unsigned int len, int *profile)
+{
+    if (job_cancelled(&memtest->job))
+    {
+        // We've been asked to stop, don't start another chunk.
+        return -1;
+    }
+
+    // Other things hold profile slots too, so this can come back negative
+    // when they run out. That only costs us the chunk timing, so carry on.
+    *profile = profile_start();
+    if (memtest->flags & MEMTEST_FLAG_PRESERVE)
+    {
+        save_chunk(memtest->backup, addr, len);
+    }
+
+    return 0;
+}
+
+void chunk_end(memory_test_t *memtest, int profile, unsigned int addr, unsigned int len)
+{
+    if (memtest->flags & MEMTEST_FLAG_PRESERVE)
+    {
+        // Put the original contents back and make sure they stuck before
+        // we move on, since this is the only copy of them.
+        restore_chunk(memtest, addr, memtest->backup, len);
+
+        unsigned int step = (memtest->flags & MEMTEST_FLAG_WIDE) ? 4 : 1;
+        for (unsigned int i = 0; i < len; i += step)
+        {
+            if (memtest->flags & MEMTEST_FLAG_WIDE)
+            {
+                uint32_t expected = memtest->backup[i / 4];
+                uint32_t actual = MEMTEST_READ32(addr + i);
+                if (actual == expected)
+                {
+                    continue;
+                }
+
+                record_word_fault(memtest, addr + i, expected, actual);
+            }
+            else
+            {
+                uint8_t expected = ((uint8_t *)memtest->backup)[i];
+                uint8_t actual = MEMTEST_READ8(addr + i);
+                if (actual == expected)
+                {
+                    continue;
+                }
+
+                record_fault(memtest, addr + i, expected, actual);
+            }
+
+            job_publish_begin(&memtest->job);
+            if (memtest->restoreaddr == MEMTEST_RUNNING)
+            {
+                memtest->restoreaddr = addr + i;
+            }
+            memtest->restorecount++;
+            job_publish_end(&memtest->job);
+        }
+    }
+
+    if (profile < 0)
+    {
+        // No profile slot was free when this chunk started.
+        return;
+    }
+
+    uint32_t elapsed = profile_end(profile);
+
+    job_publish_begin(&memtest->job);
+    if (elapsed > memtest->max_chunk_us)
+    {
+        memtest->max_chunk_us = elapsed;
+    }
+    job_publish_end(&memtest->job);
+}
+
+unsigned int walking_bits(memory_test_t *memtest, unsigned int startaddr, unsigned int size, uint32_t invert)
+{
+    // Check for stuck data bits, remembering the first failure but
+    // continuing on so that we can map all of them. Word-wide regions walk
+    // all 32 bits of each word so that every data line gets exercised.
+    unsigned int failure = 0;
+    unsigned int wide = memtest->flags & MEMTEST_FLAG_WIDE;
+    unsigned int bits = wide ? 32 : 8;
+
+    for (unsigned int chunk = startaddr; chunk < startaddr + size; chunk += MEMTEST_CHUNK_SIZE)
+    {
+        unsigned int end = min(chunk + MEMTEST_CHUNK_SIZE, startaddr + size);
+        int profile;
+        if (chunk_begin(memtest, chunk, end - chunk, &profile) != 0)
+        {
+            return MEMTEST_CANCELLED;
+        }
+
+        for (unsigned int addr = chunk; addr < end; addr += bits / 8)
+        {
+            for (int i = 0; i < bits; i++)
+            {
+                if (wide)
+                {
+                    uint32_t pattern = (1U << i) ^ invert;
+                    word_write(memtest, addr, pattern);
+
+                    uint32_t actual = MEMTEST_READ32(addr);
+                    if (actual != pattern)
+                    {
+                        record_word_fault(memtest, addr, pattern, actual);
+                        if (failure == 0)
+                        {
+                            failure = addr;
+                        }
+                    }
+                }
+                else
+                {
+                    uint8_t pattern = ((1U << i) ^ invert) & 0xFF;
+                    MEMTEST_WRITE8(addr, pattern);
+
+                    uint8_t actual = MEMTEST_READ8(addr);
+                    if (actual != pattern)
+                    {
+                        record_fault(memtest, addr, pattern, actual);
+                        if (failure == 0)
+                        {
+                            failure = addr;
+                        }
+                    }
+                }
+            }
+        }
+
+        chunk_end(memtest, profile, chunk, end - chunk);
+    }
+
+    return failure;
+}
+
+unsigned int walking_0s(memory_test_t *memtest, unsigned int startaddr, unsigned int size)
+{
+    // A single zero bit walked through a field of ones, such as 0xFE, 0xFD...
+    return walking_bits(memtest, startaddr, size, 0xFFFFFFFF);
+}
+
+unsigned int walking_1s(memory_test_t *memtest, unsigned int startaddr, unsigned int size)
+{
+    // A single one bit walked through a field of zeros, such as 0x01, 0x02...
+    return walking_bits(memtest, startaddr, size, 0x00000000);
+}
+
+uint32_t device_word(uint8_t *pattern)
+{
+    // Pack the next four bytes of the pattern the way the SH-4 lays out a
+    // word, so word-wide regions end up holding exactly the same bytes.
+    uint32_t word = 0;
+    for (int byte = 0; byte < 4; byte++)
+    {
+        word |= (uint32_t)(*pattern) << (byte * 8);
+        (*pattern)++;
+    }
+
+    return word;
+}
+
+uint8_t device_fill(memory_test_t *memtest, unsigned int addr, unsigned int end, uint8_t pattern)
+{
+    if (memtest->flags & MEMTEST_FLAG_WIDE)
+    {
+        for (; addr < end; addr += 4)
+        {
+            word_write(memtest, addr, device_word(&pattern));
+        }
+
+        return pattern;
+    }
+
+    for (; addr < end; addr++)
+    {
+        MEMTEST_WRITE8(addr, pattern);
+        pattern++;
+    }
+
+    return pattern;
+}
+
+uint8_t device_verify(memory_test_t *memtest, unsigned int addr, unsigned int end, uint8_t pattern, unsigned int *failure)
+{
+    if (memtest->flags & MEMTEST_FLAG_WIDE)
+    {
+        for (; addr < end; addr += 4)
+        {
+            uint32_t expected = device_word(&pattern);
+            uint32_t actual = MEMTEST_READ32(addr);
+            if (actual != expected)
+            {
+                record_word_fault(memtest, addr, expected, actual);
+                if (*failure == 0)
+                {
+                    *failure = addr;
+                }
+            }
+        }
+
+        return pattern;
+    }
+
+    for (; addr < end; addr++)
+    {
+        uint8_t actual = MEMTEST_READ8(addr);
+        if (actual != pattern)
+        {
+            record_fault(memtest, addr, pattern, actual);
+            if (*failure == 0)
+            {
+                *failure = addr;
+            }
+        }
+        pattern++;
+    }
+
+    return pattern;
+}
+
+unsigned int device_test(memory_test_t *memtest, unsigned int startaddr, unsigned int size)
+{
+    // Check to make sure something can be stored in each byte. The pattern
+    // is carried across chunks so that it is identical to doing the whole
+    // region in one go.
+    unsigned int failure = 0;
+    uint8_t pattern = 5;
+
+    if (memtest->flags & MEMTEST_FLAG_PRESERVE)
+    {
+        // Each chunk gets put back as soon as we finish with it, so we have
+        // to verify a chunk before moving on to the next one.
+        uint8_t verify = 5;
+        for (unsigned int chunk = startaddr; chunk < startaddr + size; chunk += MEMTEST_CHUNK_SIZE)
+        {
+            unsigned int end = min(chunk + MEMTEST_CHUNK_SIZE, startaddr + size);
+            int profile;
+            if (chunk_begin(memtest, chunk, end - chunk, &profile) != 0)
+            {
+                return MEMTEST_CANCELLED;
+            }
+
+            pattern = device_fill(memtest, chunk, end, pattern);
+            verify = device_verify(memtest, chunk, end, verify, &failure);
+
+            chunk_end(memtest, profile, chunk, end - chunk);
+        }
+
+        return failure;
+    }
+
+    for (unsigned int chunk = startaddr; chunk < startaddr + size; chunk += MEMTEST_CHUNK_SIZE)
+    {
+        unsigned int end = min(chunk + MEMTEST_CHUNK_SIZE, startaddr + size);
+        int profile;
+        if (chunk_begin(memtest, chunk, end - chunk, &profile) != 0)
+        {
+            return MEMTEST_CANCELLED;
+        }
+
+        pattern = device_fill(memtest, chunk, end, pattern);
+
+        chunk_end(memtest, profile, chunk, end - chunk);
+    }
+
+    pattern = 5;
+    for (unsigned int chunk = startaddr; chunk < startaddr + size; chunk += MEMTEST_CHUNK_SIZE)
+    {
+        unsigned int end = min(chunk + MEMTEST_CHUNK_SIZE, startaddr + size);
+        int profile;
+        if (chunk_begin(memtest, chunk, end - chunk, &profile) != 0)
+        {
+            return MEMTEST_CANCELLED;
+        }
+
+        pattern = device_verify(memtest, chunk, end, pattern, &failure);
+
+        chunk_end(memtest, profile, chunk, end - chunk);
+    }
+
+    return failure;
+}
+
+uint32_t random_fill(memory_test_t *memtest, unsigned int addr, unsigned int end, uint32_t seed)
+{
+    for (; addr < end; addr += 4)
+    {
+        seed = xorshift32(seed);
+        word_write(memtest, addr, seed);
+    }
+
+    return seed;
+}
+
+uint32_t random_verify(memory_test_t *memtest, unsigned int addr, unsigned int end, uint32_t seed, unsigned int *failure)
+{
+    for (; addr < end; addr += 4)
+    {
+        seed = xorshift32(seed);
+
+        uint32_t actual = MEMTEST_READ32(addr);
+        if (actual != seed)
+        {
+            record_word_fault(memtest, addr, seed, actual);
+            if (*failure == 0)
+            {
+                *failure = addr;
+            }
+        }
+    }
+
+    return seed;
+}
+
+unsigned int random_test(memory_test_t *memtest, unsigned int startaddr, unsigned int size)
+{
+    // Fill the region with a pseudo-random stream that doesn't repeat over
+    // any period we care about, then regenerate the stream to verify it so
+    // that we never need to store it. This works on whole words, so any
+    // trailing bytes that don't make up a full word are skipped.
+    uint32_t seeds[MEMTEST_RANDOM_SEEDS] = { 0x2545F491, 0x9E3779B9, 0xDEADBEEF, 0x6A09E667 };
+    unsigned int failure = 0;
+    size &= ~3;
+
+    for (int i = 0; i < MEMTEST_RANDOM_SEEDS; i++)
+    {
+        uint32_t seed = seeds[i];
+
+        if (memtest->flags & MEMTEST_FLAG_PRESERVE)
+        {
+            // Each chunk gets put back as soon as we finish with it, so we have
+            // to verify a chunk before moving on to the next one.
+            uint32_t verify = seeds[i];
+            for (unsigned int chunk = startaddr; chunk < startaddr + size; chunk += MEMTEST_CHUNK_SIZE)
+            {
+                unsigned int end = min(chunk + MEMTEST_CHUNK_SIZE, startaddr + size);
+                int profile;
+                if (chunk_begin(memtest, chunk, end - chunk, &profile) != 0)
+                {
+                    return MEMTEST_CANCELLED;
+                }
+
+                seed = random_fill(memtest, chunk, end, seed);
+                verify = random_verify(memtest, chunk, end, verify, &failure);
+
+                chunk_end(memtest, profile, chunk, end - chunk);
+            }
+
+            continue;
+        }
+
+        for (unsigned int chunk = startaddr; chunk < startaddr + size; chunk += MEMTEST_CHUNK_SIZE)
+        {
+            unsigned int end = min(chunk + MEMTEST_CHUNK_SIZE, startaddr + size);
+            int profile;
+            if (chunk_begin(memtest, chunk, end - chunk, &profile) != 0)
+            {
+                return MEMTEST_CANCELLED;
+            }
+
+            seed = random_fill(memtest, chunk, end, seed);
+
+            chunk_end(memtest, profile, chunk, end - chunk);
+        }
+
+        seed = seeds[i];
+        for (unsigned int chunk = startaddr; chunk < startaddr + size; chunk += MEMTEST_CHUNK_SIZE)
+        {
+            unsigned int end = min(chunk + MEMTEST_CHUNK_SIZE, startaddr + size);
+            int profile;
+            if (chunk_begin(memtest, chunk, end - chunk, &profile) != 0)
+            {
+                return MEMTEST_CANCELLED;
+            }
+
+            seed = random_verify(memtest, chunk, end, seed, &failure);
+
+            chunk_end(memtest, profile, chunk, end - chunk);
+        }
+    }
+
+    return failure;
+}
+
+// Whether the probe saw the cell at offset a read back what was written to b, or vice versa.
+#define ALIASED(mask, a, b) ((mask) & ((1 << ((a) * 4 + (b))) | (1 << ((b) * 4 + (a)))))
+
+uint32_t address_probe(unsigned int startaddr, unsigned int *offsets, int count, unsigned int flags, unsigned int *dataerrors)
+{
+    // Unique tags that are at least four bits apart from each other so that
+    // a bad data line can't turn one into another. Word-wide regions get
+    // the tag repeated in every byte.
+    uint32_t tags[4] = { 0x3C, 0xA5, 0x5A, 0xC3 };
+    uint32_t saved[4];
+    uint32_t mask = 0;
+    unsigned int wide = flags & MEMTEST_FLAG_WIDE;
+
+    if (wide)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            tags[k] *= 0x01010101;
+        }
+    }
+
+    // Save everything before we write anything, so that if two of these
+    // alias each other we still put back the real original value.
+    for (int k = 0; k < count; k++)
+    {
+        saved[k] = wide ? MEMTEST_READ32(startaddr + offsets[k]) : MEMTEST_READ8(startaddr + offsets[k]);
+    }
+
+    // We never write more than a batch at once here, so one wait is enough.
+    if (flags & MEMTEST_FLAG_G2)
+    {
+        MEMTEST_G2_WAIT();
+    }
+
+    for (int k = 0; k < count; k++)
+    {
+        if (wide)
+        {
+            MEMTEST_WRITE32(startaddr + offsets[k], tags[k]);
+        }
+        else
+        {
+            MEMTEST_WRITE8(startaddr + offsets[k], tags[k]);
+        }
+    }
+
+    // Any location that reads back another location's tag shares a cell with it.
+    for (int k = 0; k < count; k++)
+    {
+        uint32_t actual = wide ? MEMTEST_READ32(startaddr + offsets[k]) : MEMTEST_READ8(startaddr + offsets[k]);
+        if (actual == tags[k])
+        {
+            continue;
+        }
+
+        int found = 0;
+        for (int m = 0; m < count; m++)
+        {
+            if (actual == tags[m])
+            {
+                mask |= 1 << (k * 4 + m);
+                found = 1;
+            }
+        }
+
+        if (!found)
+        {
+            (*dataerrors)++;
+        }
+    }
+
+    if (flags & MEMTEST_FLAG_G2)
+    {
+        MEMTEST_G2_WAIT();
+    }
+
+    for (int k = count - 1; k >= 0; k--)
+    {
+        if (wide)
+        {
+            MEMTEST_WRITE32(startaddr + offsets[k], saved[k]);
+        }
+        else
+        {
+            MEMTEST_WRITE8(startaddr + offsets[k], saved[k]);
+        }
+    }
+
+    return mask;
+}
+
+int address_line_anchor(unsigned int startaddr, unsigned int size, uint32_t lines, unsigned int *anchor)
+{
+    // Find the lowest address in the region with every one of the given
+    // lines low, so that flipping any of them on their own or together
+    // lands on another address in the region. Probing relative to this
+    // instead of the start of the region means line i really is address
+    // bit i even when the region isn't aligned to its own size.
+    unsigned int addr = startaddr;
+    while (addr & lines)
+    {
+        // Carry past the lowest line that is set, and start over from the
+        // bottom of the block that gets us to.
+        uint32_t lowest = addr & lines & -(addr & lines);
+        addr = (addr + lowest) & ~((lowest << 1) - 1);
+        if (addr < startaddr)
+        {
+            // Wrapped around the top of the address space.
+            return -1;
+        }
+    }
+
+    if ((addr | lines) - startaddr >= size)
+    {
+        return -1;
+    }
+
+    *anchor = addr;
+    return 0;
+}
+
+int address_lines_analyze(unsigned int startaddr, unsigned int size, unsigned int flags, volatile unsigned int *cancel, address_lines_t *result)
+{
+    // Lines that select the same cell whichever way they are driven.
+    uint32_t alias0 = 0;
+    // For each line, the other lines it was seen to decode properly alongside.
+    uint32_t decodes[32] = { 0 };
+    // For each line, the other lines whose single-bit address it aliased.
+    uint32_t shorts[32] = { 0 };
+
+    // Every address bit that changes somewhere in the region is a line we
+    // can drive both ways.
+    memset(result, 0, sizeof(*result));
+    uint32_t spanned = size > 1 ? startaddr ^ (startaddr + size - 1) : 0;
+    while (result->lines < 32 && (spanned >> result->lines) != 0)
+    {
+        result->lines++;
+    }
+
+    // Whole-word accesses never drive A0 or A1 to anything but zero.
+    if (flags & (MEMTEST_FLAG_WIDE | MEMTEST_FLAG_G2))
+    {
+        result->firstline = min(2, result->lines);
+    }
+
+    // First, each line on its own. This is all we can do if the region only
+    // spans one line.
+    for (unsigned int i = result->firstline; i < result->lines; i++)
+    {
+        unsigned int anchor;
+        if (address_line_anchor(startaddr, size, 1U << i, &anchor) != 0)
+        {
+            continue;
+        }
+
+        unsigned int offsets[2] = { 0, 1U << i };
+        uint32_t mask = address_probe(anchor, offsets, 2, flags, &result->dataerrors);
+        if (ALIASED(mask, 0, 1))
+        {
+            alias0 |= 1U << i;
+        }
+    }
+
+    // Now, every pair of lines. A stuck line i makes 2^j and 2^i + 2^j land
+    // on the same cell, while lines shorted together make 2^i and 2^j land on
+    // the same cell regardless of which way the short pulls them.
+    for (unsigned int i = result->firstline; i < result->lines; i++)
+    {
+        if (cancel != NULL && *cancel)
+        {
+            return -1;
+        }
+
+        for (unsigned int j = i + 1; j < result->lines; j++)
+        {
+            unsigned int anchor;
+            if (address_line_anchor(startaddr, size, (1U << i) | (1U << j), &anchor) != 0)
+            {
+                // Region doesn't hold all four combinations, so this pair
+                // can't be checked.
+                continue;
+            }
+
+            unsigned int offsets[4] = { 0, 1U << i, 1U << j, (1U << i) | (1U << j) };
+            uint32_t mask = address_probe(anchor, offsets, 4, flags, &result->dataerrors);
+
+            if (!ALIASED(mask, 2, 3))
+            {
+                decodes[i] |= 1U << j;
+            }
+            if (!ALIASED(mask, 1, 3))
+            {
+                decodes[j] |= 1U << i;
+            }
+            if (ALIASED(mask, 1, 2))
+            {
+                shorts[i] |= 1U << j;
+                shorts[j] |= 1U << i;
+            }
+        }
+    }
+
+    // A line is stuck if it never selects a different cell on its own, and
+    // never made a difference when paired with any other line.
+    for (unsigned int i = result->firstline; i < result->lines; i++)
+    {
+        if ((alias0 & (1U << i)) && decodes[i] == 0)
+        {
+            result->stuck |= 1U << i;
+        }
+    }
+
+    // Two stuck lines also alias each other, but that's not a short.
+    for (unsigned int i = 0; i < result->lines; i++)
+    {
+        if (!(result->stuck & (1U << i)))
+        {
+            result->shorted[i] = shorts[i] & ~result->stuck;
+        }
+    }
+
+    return 0;
+}
+
+unsigned int address_test(memory_test_t *memtest, unsigned int startaddr, unsigned int size)
+{
+    // This only touches a handful of bytes per pair of address lines and
+    // puts them back itself, so the whole thing counts as a single chunk.
+    unsigned int failure = 0;
+    int profile;
+    if (chunk_begin(memtest, startaddr, 0, &profile) != 0)
+    {
+        return MEMTEST_CANCELLED;
+    }
+
+    address_lines_t addrlines;
+    if (address_lines_analyze(startaddr, size, memtest->flags, &memtest->job.cancel, &addrlines) != 0)
+    {
+        chunk_end(memtest, profile, startaddr, 0);
+        return MEMTEST_CANCELLED;
+    }
+
+    // Map each bad line at an address that drives it high. There's no
+    // particular data bit at fault here, so these don't count against any lane.
+    for (unsigned int i = 0; i < addrlines.lines; i++)
+    {
+        unsigned int anchor;
+        if (((addrlines.stuck & (1U << i)) || addrlines.shorted[i]) && address_line_anchor(startaddr, size, 1U << i, &anchor) == 0)
+        {
+            record_fault(memtest, anchor | (1U << i), 0, 0);
+            if (failure == 0)
+            {
+                failure = anchor | (1U << i);
+            }
+        }
+    }
+
+    job_publish_begin(&memtest->job);
+    memcpy(&memtest->addrlines, &addrlines, sizeof(addrlines));
+    job_publish_end(&memtest->job);
+
+    chunk_end(memtest, profile, startaddr, 0);
+    return failure;
+}
+
+void restore_snapshot(memory_test_t *memtest)
+{
+    if (memtest->snapshot == NULL)
+    {
+        // Region was too big to snapshot, nothing we can do.
+        return;
+    }
+
+    if (memtest->flags & MEMTEST_FLAG_WIDE)
+    {
+        for (unsigned int i = 0; i < memtest->size; i += 4)
+        {
+            word_write(memtest, memtest->startaddr + i, *((uint32_t *)(memtest->snapshot + i)));
+        }
+
+        return;
+    }
+
+    for (unsigned int i = 0; i < memtest->size; i++)
+    {
+        MEMTEST_WRITE8(memtest->startaddr + i, memtest->snapshot[i]);
+    }
+}
+
+int region_crc(memory_test_t *memtest, unsigned int startaddr, unsigned int size, uint32_t *crc)
+{
+    // Pull the region through the backup buffer a chunk at a time so that
+    // we can still be cancelled partway through.
+    *crc = 0;
+    for (unsigned int chunk = startaddr; chunk < startaddr + size; chunk += MEMTEST_CHUNK_SIZE)
+    {
+        if (job_cancelled(&memtest->job))
+        {
+            return -1;
+        }
+
+        unsigned int end = min(chunk + MEMTEST_CHUNK_SIZE, startaddr + size);
+        save_chunk(memtest->backup, chunk, end - chunk);
+        *crc = crc_update(*crc, memtest->backup, end - chunk);
+    }
+
+    return 0;
+}
+
+unsigned int memtest_cancelled(memory_test_t *memtest, int profile, int restore)
+{
+    // Every early exit comes through here, so that the profile slot we hold
+    // for the whole run is always given back.
+    if (restore)
+    {
+        restore_snapshot(memtest);
+    }
+    if (profile >= 0)
+    {
+        profile_end(profile);
+    }
+
+    return JOB_CANCELLED;
+}
+
+unsigned int memtest_thread(void *param)
+{
+    memory_test_t *memtest = (memory_test_t *)param;
+    unsigned int result;
+    unsigned int before;
+    int kernel;
+
+    /* First, grab our range. */
+    unsigned int startaddr = memtest->startaddr;
+    unsigned int size = memtest->size;
+
+    /* Remember what was there so we can put it back if we leave early. */
+    int profile = profile_start();
+    if (memtest->snapshot != NULL)
+    {
+        if (memtest->flags & MEMTEST_FLAG_WIDE)
+        {
+            save_chunk((uint32_t *)memtest->snapshot, startaddr, size);
+        }
+        else
+        {
+            for (unsigned int i = 0; i < size; i++)
+            {
+                memtest->snapshot[i] = MEMTEST_READ8(startaddr + i);
+            }
+        }
+    }
+
+    /* If we're preserving memory, checksum it so we can prove it was put back. */
+    if (memtest->flags & MEMTEST_FLAG_PRESERVE)
+    {
+        uint32_t crc;
+        if (region_crc(memtest, startaddr, size, &crc) != 0) { return memtest_cancelled(memtest, profile, 0); }
+
+        job_publish_begin(&memtest->job);
+        memtest->crcbefore = crc;
+        job_publish_end(&memtest->job);
+    }
+
+    /* Now, run the memory tests, stopping early if asked to. */
+    before = memtest->faults.total;
+    kernel = profile_start();
+    result = walking_1s(memtest, startaddr, size);
+    job_publish_begin(&memtest->job);
+    memtest->w1saddr = result;
+    memtest->w1scount = memtest->faults.total - before;
+    memtest->w1sus = profile_end(kernel);
+    job_publish_end(&memtest->job);
+    if (result == MEMTEST_CANCELLED) { return memtest_cancelled(memtest, profile, 1); }
+
+    before = memtest->faults.total;
+    kernel = profile_start();
+    result = walking_0s(memtest, startaddr, size);
+    job_publish_begin(&memtest->job);
+    memtest->w0saddr = result;
+    memtest->w0scount = memtest->faults.total - before;
+    memtest->w0sus = profile_end(kernel);
+    job_publish_end(&memtest->job);
+    if (result == MEMTEST_CANCELLED) { return memtest_cancelled(memtest, profile, 1); }
+
+    before = memtest->faults.total;
+    kernel = profile_start();
+    result = address_test(memtest, startaddr, size);
+    job_publish_begin(&memtest->job);
+    memtest->addraddr = result;
+    memtest->addrcount = memtest->faults.total - before;
+    memtest->addrus = profile_end(kernel);
+    job_publish_end(&memtest->job);
+    if (result == MEMTEST_CANCELLED) { return memtest_cancelled(memtest, profile, 1); }
+
+    before = memtest->faults.total;
+    kernel = profile_start();
+    result = device_test(memtest, startaddr, size);
+    job_publish_begin(&memtest->job);
+    memtest->dataaddr = result;
+    memtest->datacount = memtest->faults.total - before;
+    memtest->dataus = profile_end(kernel);
+    job_publish_end(&memtest->job);
+    if (result == MEMTEST_CANCELLED) { return memtest_cancelled(memtest, profile, 1); }
+
+    before = memtest->faults.total;
+    kernel = profile_start();
+    result = random_test(memtest, startaddr, size);
+    job_publish_begin(&memtest->job);
+    memtest->randaddr = result;
+    memtest->randcount = memtest->faults.total - before;
+    memtest->randus = profile_end(kernel);
+    job_publish_end(&memtest->job);
+    if (result == MEMTEST_CANCELLED) { return memtest_cancelled(memtest, profile, 1); }
+
+    /* Finally, verify that the region as a whole matches what we started with. */
+    if (memtest->flags & MEMTEST_FLAG_PRESERVE)
+    {
+        uint32_t crc;
+        if (region_crc(memtest, startaddr, size, &crc) != 0) { return memtest_cancelled(memtest, profile, 0); }
+
+        job_publish_begin(&memtest->job);
+        memtest->crcafter = crc;
+        if (memtest->restoreaddr == MEMTEST_RUNNING)
+        {
+            // Every chunk verified, so the only way the checksum can differ
+            // is if something outside of a chunk got changed underneath us.
+            memtest->restoreaddr = crc == memtest->crcbefore ? MEMTEST_PASSED : startaddr;
+        }
+        job_publish_end(&memtest->job);
+    }
+
+    job_publish_begin(&memtest->job);
+    memtest->elapsed_us = profile_end(profile);
+    job_publish_end(&memtest->job);
+
+    return JOB_FINISHED;
+}
+
+memory_test_t *start_memory_test(unsigned int startaddr, unsigned int size, unsigned int flags)
+{
+    memory_test_t *memtest = malloc(sizeof(memory_test_t));
+    if (memtest == NULL)
+    {
+        return NULL;
+    }
+    memtest->startaddr = startaddr;
+    memtest->size = size;
+    memtest->flags = (flags & (MEMTEST_FLAG_G2 | MEMTEST_FLAG_NO_NARROW)) ? (flags | MEMTEST_FLAG_WIDE) : flags;
+    memtest->g2pending = 0;
+
+    if (memtest->flags & MEMTEST_FLAG_PRESERVE)
+    {
+        // Every chunk is put back as we go, so there is nothing to snapshot.
+        // The buffer is aligned so restores can use the store queues.
+        memtest->snapshot = NULL;
+        memtest->backup = memalign(32, MEMTEST_CHUNK_SIZE);
+    }
+    else
+    {
+        memtest->snapshot = size <= MEMTEST_SNAPSHOT_MAX ? memalign(4, size) : NULL;
+        memtest->backup = NULL;
+    }
+
+    // The chunk save and restore write straight through these, so there is
+    // no running without them.
+    if (
+        ((memtest->flags & MEMTEST_FLAG_PRESERVE) && memtest->backup == NULL) ||
+        (!(memtest->flags & MEMTEST_FLAG_PRESERVE) && size <= MEMTEST_SNAPSHOT_MAX && memtest->snapshot == NULL)
+    )
+    {
+        free(memtest->snapshot);
+        free(memtest->backup);
+        free(memtest);
+        return NULL;
+    }
+    memtest->w1saddr = MEMTEST_RUNNING;
+    memtest->w0saddr = MEMTEST_RUNNING;
+    memtest->addraddr = MEMTEST_RUNNING;
+    memtest->dataaddr = MEMTEST_RUNNING;
+    memtest->randaddr = MEMTEST_RUNNING;
+    memtest->restoreaddr = MEMTEST_RUNNING;
+    memtest->w1scount = 0;
+    memtest->w0scount = 0;
+    memtest->addrcount = 0;
+    memtest->datacount = 0;
+    memtest->randcount = 0;
+    memtest->restorecount = 0;
+    memtest->w1sus = 0;
+    memtest->w0sus = 0;
+    memtest->addrus = 0;
+    memtest->dataus = 0;
+    memtest->randus = 0;
+    memtest->crcbefore = 0;
+    memtest->crcafter = 0;
+    memset(&memtest->faults, 0, sizeof(memtest->faults));
+    memset(&memtest->addrlines, 0, sizeof(memtest->addrlines));
+    memtest->faults.cellsize = max(1, (size + (MEMTEST_MAP_CELLS - 1)) / MEMTEST_MAP_CELLS);
+    memtest->max_chunk_us = 0;
+    memtest->elapsed_us = 0;
+    job_start(&memtest->job, memtest_thread, memtest, JOB_NO_TIMEOUT);
+    return memtest;
+}
+
+void end_memory_test(memory_test_t *memtest)
+{
+    // Ask the worker to stop at the next chunk boundary and wait for it to
+    // put memory back the way it found it.
+    int profile = profile_start();
+    job_end(&memtest->job);
+    exit_latency = profile_end(profile);
+
+    if (memtest->snapshot != NULL)
+    {
+        free(memtest->snapshot);
+    }
+    if (memtest->backup != NULL)
+    {
+        free(memtest->backup);
+    }
+    free(memtest);
+}
+
+uint32_t memory_test_exit_latency()
+{
+    return exit_latency;
+}
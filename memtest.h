@@ -0,0 +1,196 @@
+#ifndef __MEMTEST_H
+#define __MEMTEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "jobs.h"
+
+// Every access the test kernels make to the memory under test goes through
+// these. A build can define them ahead of time to point the kernels at
+// something other than the real bus, such as a simulated device.
+#ifndef MEMTEST_READ8
+#define MEMTEST_DIRECT_ACCESS 1
+#define MEMTEST_READ8(addr) (*((volatile uint8_t *)(addr)))
+#define MEMTEST_WRITE8(addr, val) (*((volatile uint8_t *)(addr)) = (val))
+#define MEMTEST_READ32(addr) (*((volatile uint32_t *)(addr)))
+#define MEMTEST_WRITE32(addr, val) (*((volatile uint32_t *)(addr)) = (val))
+#else
+#define MEMTEST_DIRECT_ACCESS 0
+#endif
+
+// Waits for the G2 bus FIFO to drain. Simulated devices have no FIFO, so a
+// build that overrides the accessors can define this to nothing.
+#ifndef MEMTEST_G2_WAIT
+#define MEMTEST_G2_WAIT() while ((*((volatile uint32_t *)0xA05F688C)) & 0x11) { ; }
+#endif
+
+// The number of bytes each memory test kernel works on before checking to
+// see if it has been asked to stop. This should stay small enough that a
+// single chunk on the slowest bus we test finishes well within a frame.
+#define MEMTEST_CHUNK_SIZE 1024
+
+// The largest region that we will snapshot so that it can be put back if
+// the test is cancelled before it finishes.
+#define MEMTEST_SNAPSHOT_MAX (64 * 1024)
+
+// The number of data bits we track failures for individually. Byte-wide
+// regions only ever use the first 8, word-wide regions use all of them.
+#define MEMTEST_LANES 32
+
+// The most distinct runs of failing addresses that we remember. Failures
+// past this are still counted and mapped, just not listed.
+#define MEMTEST_MAX_FAULT_RUNS 32
+
+// The number of cells the tested region is split into for the fault map.
+#define MEMTEST_MAP_CELLS 512
+
+// The number of different pseudo-random streams the random test writes.
+#define MEMTEST_RANDOM_SEEDS 4
+
+// The most writes we queue up on the G2 bus before waiting for it to drain.
+#define MEMTEST_G2_BATCH 8
+
+// Flags that can be given to start_memory_test().
+#define MEMTEST_FLAG_PRESERVE 0x1
+// Only ever access the region a whole aligned 32-bit word at a time.
+#define MEMTEST_FLAG_WIDE 0x2
+// The region is behind the G2 bus, so writes are batched around FIFO waits.
+// This implies MEMTEST_FLAG_WIDE, since G2 memory can't take byte writes.
+#define MEMTEST_FLAG_G2 0x4
+// The region can't take byte or halfword accesses at all, so nothing that
+// uses these flags should ever try them. This also implies MEMTEST_FLAG_WIDE.
+#define MEMTEST_FLAG_NO_NARROW 0x8
+
+// Special result values for each test. Anything else is a failing address.
+#define MEMTEST_PASSED 0x0
+#define MEMTEST_CANCELLED 0xFFFFFFFE
+#define MEMTEST_RUNNING 0xFFFFFFFF
+
+typedef struct
+{
+    // The number of address lines the analyzed region spans, and the first
+    // one we could check. Line numbers are bits of the real address, not of
+    // the offset into the region. Word-wide regions can't tell apart A0 and A1.
+    unsigned int lines;
+    unsigned int firstline;
+    // Address lines that have no effect on which cell is accessed.
+    uint32_t stuck;
+    // For each address line, the other lines that it is shorted to.
+    uint32_t shorted[32];
+    // Reads that matched nothing we wrote, meaning the data lines are also
+    // bad and the above can't be fully trusted.
+    unsigned int dataerrors;
+} address_lines_t;
+
+typedef struct
+{
+    // First failing address in this run.
+    unsigned int addr;
+    // Number of consecutive failing bytes starting at addr.
+    unsigned int length;
+    // Every bit that has been seen to fail anywhere in this run.
+    uint32_t xormask;
+} memtest_fault_run_t;
+
+typedef struct
+{
+    // Total number of failing accesses across every test.
+    unsigned int total;
+    // Number of failing accesses that had each data bit wrong.
+    unsigned int lanes[MEMTEST_LANES];
+
+    // Runs of consecutive failing addresses, and how many we had no room for.
+    unsigned int runcount;
+    unsigned int overflow;
+    memtest_fault_run_t runs[MEMTEST_MAX_FAULT_RUNS];
+
+    // Number of bytes covered by each cell, and failures seen in each cell.
+    unsigned int cellsize;
+    uint16_t map[MEMTEST_MAP_CELLS];
+} memtest_faults_t;
+
+typedef struct
+{
+    unsigned int startaddr;
+    unsigned int size;
+    unsigned int flags;
+
+    // The worker running the test. Each kernel checks for cancellation in
+    // between chunks, and every result below is published through it.
+    job_t job;
+
+    // Original contents of the region, written back if we are cancelled.
+    uint8_t *snapshot;
+
+    // Original contents of the chunk currently being tested, used when we
+    // are preserving memory so each chunk can be put back as we go.
+    uint32_t *backup;
+
+    // Writes issued since we last waited for the G2 FIFO to drain.
+    unsigned int g2pending;
+
+    unsigned int w1saddr;
+    unsigned int w0saddr;
+    unsigned int addraddr;
+    unsigned int dataaddr;
+    unsigned int randaddr;
+    unsigned int restoreaddr;
+
+    // How many failing accesses each of the above tests found.
+    unsigned int w1scount;
+    unsigned int w0scount;
+    unsigned int addrcount;
+    unsigned int datacount;
+    unsigned int randcount;
+    unsigned int restorecount;
+
+    // How long each of the above tests took, in microseconds.
+    uint32_t w1sus;
+    uint32_t w0sus;
+    uint32_t addrus;
+    uint32_t dataus;
+    uint32_t randus;
+
+    // Checksum of the region before and after testing when preserving it.
+    uint32_t crcbefore;
+    uint32_t crcafter;
+
+    // Every failure seen so far, so we can tell where they cluster.
+    memtest_faults_t faults;
+
+    // Exactly which address lines are bad, from the address bus test.
+    address_lines_t addrlines;
+
+    // The longest time, in microseconds, that any one chunk has taken.
+    uint32_t max_chunk_us;
+
+    // How long the whole test took, in microseconds, once it is finished.
+    uint32_t elapsed_us;
+} memory_test_t;
+
+// Step a 32-bit xorshift generator, used wherever we need a pattern that
+// can be regenerated instead of stored.
+uint32_t xorshift32(uint32_t x);
+
+// Find stuck and shorted address lines in any region, touching only
+// O(log^2 N) bytes and putting them back afterwards. The region doesn't
+// need to be aligned, but lines it can't drive both ways go unchecked. Only MEMTEST_FLAG_WIDE
+// and MEMTEST_FLAG_G2 are looked at in flags. Returns nonzero if cancel was
+// set before the analysis finished.
+int address_lines_analyze(unsigned int startaddr, unsigned int size, unsigned int flags, volatile unsigned int *cancel, address_lines_t *result);
+
+// Returns NULL if there isn't enough free memory to back up the region.
+memory_test_t *start_memory_test(unsigned int startaddr, unsigned int size, unsigned int flags);
+void end_memory_test(memory_test_t *memtest);
+
+// How long, in microseconds, the most recent end_memory_test() call took.
+uint32_t memory_test_exit_latency();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include <naomi/timer.h>
+#include "common.h"
+#include "pack.h"
+
+// The asset pack, built by tools/mkpack.py and compiled in from Makefile.
+extern uint8_t *assets_pack_data;
+extern unsigned int assets_pack_len;
+
+// How much we inflate at once when streaming an asset somewhere zlib can't
+// write to directly.
+#define PACK_STREAM_CHUNK 4096
+
+static pack_stats_t stats;
+
+const pack_entry_t *pack_find(const char *name)
+{
+    pack_header_t *header = (pack_header_t *)assets_pack_data;
+    if (memcmp(header->magic, "NDPK", 4) != 0)
+    {
+        return NULL;
+    }
+
+    pack_entry_t *entries = (pack_entry_t *)(assets_pack_data + sizeof(pack_header_t));
+    for (unsigned int i = 0; i < header->count; i++)
+    {
+        if (strncmp(entries[i].name, name, PACK_NAME_LENGTH) == 0)
+        {
+            return &entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+int pack_inflate(const pack_entry_t *entry, uint8_t *dest, unsigned int len, pack_sink_t sink, void *param)
+{
+    int profile = profile_start();
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit(&stream) != Z_OK)
+    {
+        // Give the profile slot back, there are only so many.
+        profile_end(profile);
+        return -1;
+    }
+
+    stream.next_in = assets_pack_data + entry->offset;
+    stream.avail_in = entry->compressed;
+
+    unsigned int written = 0;
+    int result = Z_OK;
+    while (result == Z_OK)
+    {
+        // Either fill the caller's buffer in one go, or fill our chunk and
+        // hand it off before going around again.
+        stream.next_out = dest + (sink ? 0 : written);
+        stream.avail_out = sink ? len : (entry->size - written);
+        result = inflate(&stream, Z_FINISH);
+        if (result == Z_BUF_ERROR && stream.avail_out == 0)
+        {
+            // Only ran out of room in our chunk, not data.
+            result = Z_OK;
+        }
+
+        unsigned int produced = (sink ? len : (entry->size - written)) - stream.avail_out;
+        if (sink && produced > 0)
+        {
+            sink(param, written, dest, produced);
+        }
+        written += produced;
+
+        if (result == Z_OK && produced == 0)
+        {
+            // The asset is bigger than the pack says it should be.
+            result = Z_DATA_ERROR;
+        }
+    }
+    inflateEnd(&stream);
+
+    stats.compressed += entry->compressed;
+    stats.inflated += written;
+    stats.inflate_us += profile_end(profile);
+
+    return (result == Z_STREAM_END && written == entry->size) ? 0 : -1;
+}
+
+void *pack_load(const char *name, unsigned int *len)
+{
+    const pack_entry_t *entry = pack_find(name);
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+
+    void *data = malloc(entry->size);
+    if (data == NULL)
+    {
+        return NULL;
+    }
+    if (pack_inflate(entry, data, entry->size, NULL, NULL) != 0)
+    {
+        free(data);
+        return NULL;
+    }
+
+    if (len != NULL)
+    {
+        *len = entry->size;
+    }
+    return data;
+}
+
+int pack_stream(const pack_entry_t *entry, pack_sink_t sink, void *param)
+{
+    // Aligned so the sink can hand it straight to the store queues.
+    static uint32_t chunk[PACK_STREAM_CHUNK / 4] __attribute__((aligned(32)));
+    return pack_inflate(entry, (uint8_t *)chunk, PACK_STREAM_CHUNK, sink, param);
+}
+
+pack_stats_t pack_get_stats()
+{
+    return stats;
+}
@@ -0,0 +1,70 @@
+#ifndef __PACK_H
+#define __PACK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// The longest asset name, including its terminator, that fits in the pack.
+#define PACK_NAME_LENGTH 24
+
+// How a sound is stored in the pack. These are the pack's own values rather
+// than libnaomi's, so sounds.c maps them onto whatever AUDIO_FORMAT_ the
+// driver uses for each.
+#define PACK_SOUND_PCM16 0
+#define PACK_SOUND_ADPCM 1
+
+// These must match the layout written by tools/mkpack.py.
+typedef struct
+{
+    char magic[4];
+    uint32_t count;
+} pack_header_t;
+
+typedef struct
+{
+    char name[PACK_NAME_LENGTH];
+    // Where the compressed data starts, from the beginning of the pack.
+    uint32_t offset;
+    uint32_t compressed;
+    uint32_t size;
+    // For sprites, the texture's size and SPRITE_FORMAT_ layout. For sounds,
+    // the number of samples and the PACK_SOUND_ format they are stored in.
+    uint32_t width;
+    uint32_t format;
+} pack_entry_t;
+
+typedef struct
+{
+    // Bytes of compressed data read and bytes inflated from it so far.
+    unsigned int compressed;
+    unsigned int inflated;
+    // Time spent inflating so far, in microseconds.
+    uint32_t inflate_us;
+} pack_stats_t;
+
+// Receives each piece of an asset as it is inflated. Every piece is a
+// multiple of 4 bytes long, apart from possibly the last one.
+typedef void (*pack_sink_t)(void *param, unsigned int offset, uint8_t *data, unsigned int len);
+
+// Look up an asset by name, returning NULL if it isn't in the pack.
+const pack_entry_t *pack_find(const char *name);
+
+// Inflate an asset straight into a newly allocated buffer. Returns NULL if
+// the asset is missing or corrupt, or there is no room for it.
+void *pack_load(const char *name, unsigned int *len);
+
+// Inflate an asset a piece at a time, for destinations that can't be given
+// to zlib directly. Returns nonzero if the asset is missing or corrupt.
+int pack_stream(const pack_entry_t *entry, pack_sink_t sink, void *param);
+
+// How much has been inflated since boot.
+pack_stats_t pack_get_stats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+#include <stdint.h>
+#include <string.h>
+#include <naomi/system.h>
+#include <naomi/timer.h>
+#include "common.h"
+#include "memtest.h"
+#include "crc.h"
+#include "retention.h"
+
+// Marks a valid retention pattern header, "RTST" when viewed in a hex dump.
+#define RETENTION_MAGIC 0x54535452
+
+// The header sits at the start of SRAM, padded out so the pattern after it
+// stays word aligned.
+#define RETENTION_HEADER_SIZE 32
+
+// How many words we read or write at once while streaming the pattern.
+#define RETENTION_CHUNK_WORDS 256
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seed;
+    uint32_t size;
+    uint32_t crc;
+    uint32_t headercrc;
+} retention_header_t;
+
+void retention_arm(uint32_t seed)
+{
+    unsigned int start = SRAM_BASE + RETENTION_HEADER_SIZE;
+    unsigned int size = (SRAM_SIZE - RETENTION_HEADER_SIZE) & ~3;
+    uint32_t chunk[RETENTION_CHUNK_WORDS];
+
+    // Invalidate any old header first, so that losing power partway through
+    // arming can never leave a header that describes a half-written pattern.
+    volatile uint32_t *sramheader = (volatile uint32_t *)SRAM_BASE;
+    sramheader[0] = 0;
+
+    // An all-zero seed would make xorshift produce nothing but zeros.
+    if (seed == 0)
+    {
+        seed = 0x6A09E667;
+    }
+
+    uint32_t state = seed;
+    uint32_t crc = 0;
+    for (unsigned int addr = start; addr < start + size; addr += RETENTION_CHUNK_WORDS * 4)
+    {
+        unsigned int words = min(RETENTION_CHUNK_WORDS, ((start + size) - addr) / 4);
+        for (unsigned int i = 0; i < words; i++)
+        {
+            state = xorshift32(state);
+            chunk[i] = state;
+            ((volatile uint32_t *)addr)[i] = state;
+        }
+
+        crc = crc_update(crc, chunk, words * 4);
+    }
+
+    // Now that the pattern is fully in place, write the header describing it.
+    retention_header_t header;
+    header.magic = RETENTION_MAGIC;
+    header.seed = seed;
+    header.size = size;
+    header.crc = crc;
+    header.headercrc = crc_update(0, &header, sizeof(header) - sizeof(header.headercrc));
+
+    for (unsigned int i = 0; i < sizeof(header) / 4; i++)
+    {
+        sramheader[i] = ((uint32_t *)&header)[i];
+    }
+}
+
+int retention_check(retention_result_t *result)
+{
+    int profile = profile_start();
+    memset(result, 0, sizeof(*result));
+
+    // First, see if there's a valid header waiting for us.
+    retention_header_t header;
+    volatile uint32_t *sramheader = (volatile uint32_t *)SRAM_BASE;
+    for (unsigned int i = 0; i < sizeof(header) / 4; i++)
+    {
+        ((uint32_t *)&header)[i] = sramheader[i];
+    }
+
+    if (
+        header.magic != RETENTION_MAGIC ||
+        header.headercrc != crc_update(0, &header, sizeof(header) - sizeof(header.headercrc)) ||
+        header.size > (SRAM_SIZE - RETENTION_HEADER_SIZE)
+    ) {
+        // Nothing armed, which is the normal case, so get out quickly.
+        profile_end(profile);
+        return 0;
+    }
+
+    // Now, stream through the pattern once, regenerating it as we go and
+    // checksumming what we actually read.
+    unsigned int start = SRAM_BASE + RETENTION_HEADER_SIZE;
+    uint32_t chunk[RETENTION_CHUNK_WORDS];
+    uint32_t state = header.seed;
+    uint32_t crc = 0;
+
+    result->found = 1;
+    result->seed = header.seed;
+    result->size = header.size;
+
+    for (unsigned int addr = start; addr < start + header.size; addr += RETENTION_CHUNK_WORDS * 4)
+    {
+        unsigned int words = min(RETENTION_CHUNK_WORDS, ((start + header.size) - addr) / 4);
+        for (unsigned int i = 0; i < words; i++)
+        {
+            chunk[i] = ((volatile uint32_t *)addr)[i];
+        }
+
+        crc = crc_update(crc, chunk, words * 4);
+
+        for (unsigned int i = 0; i < words; i++)
+        {
+            state = xorshift32(state);
+            if (chunk[i] == state)
+            {
+                continue;
+            }
+
+            // Work out exactly which bytes decayed, and in which direction.
+            for (int byte = 0; byte < 4; byte++)
+            {
+                uint8_t expected = (state >> (byte * 8)) & 0xFF;
+                uint8_t actual = (chunk[i] >> (byte * 8)) & 0xFF;
+                if (expected == actual)
+                {
+                    continue;
+                }
+
+                unsigned int badaddr = addr + (i * 4) + byte;
+                if (result->decayed == 0)
+                {
+                    result->firstaddr = badaddr;
+                }
+                result->lastaddr = badaddr;
+                result->decayed++;
+                result->fellmask |= expected & ~actual;
+                result->rosemask |= actual & ~expected;
+            }
+        }
+    }
+
+    result->crcmatched = crc == header.crc;
+
+    // Make sure we only ever report on this pattern once.
+    sramheader[0] = 0;
+
+    result->elapsed_us = profile_end(profile);
+    return 1;
+}
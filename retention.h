@@ -0,0 +1,48 @@
+#ifndef __RETENTION_H
+#define __RETENTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef struct
+{
+    // Whether a retention pattern was found in SRAM when we booted.
+    unsigned int found;
+
+    // The seed the pattern was written with, and how many bytes it covered.
+    uint32_t seed;
+    unsigned int size;
+
+    // How many bytes no longer matched, and where the first and last were.
+    unsigned int decayed;
+    unsigned int firstaddr;
+    unsigned int lastaddr;
+
+    // Bits that flipped from 1 to 0 and from 0 to 1 anywhere in the pattern.
+    uint8_t fellmask;
+    uint8_t rosemask;
+
+    // Whether the checksum stored alongside the pattern still matched.
+    unsigned int crcmatched;
+
+    // How long verification took at boot, in microseconds.
+    uint32_t elapsed_us;
+} retention_result_t;
+
+// Fill SRAM with a pattern derived from seed, plus a header describing it,
+// so that it can be verified after the cabinet is power-cycled.
+void retention_arm(uint32_t seed);
+
+// Check for a pattern left by retention_arm() and verify it in a single
+// pass, filling in result. The header is cleared afterwards so that a
+// pattern is only ever reported on once. Returns nonzero if one was found.
+int retention_check(retention_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,18 +2,33 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
-#include <pthread.h>
+#include <malloc.h>
 #include <naomi/video.h>
 #include <naomi/ta.h>
 #include <naomi/audio.h>
 #include <naomi/maple.h>
 #include <naomi/system.h>
+#include <naomi/timer.h>
 #include <naomi/font.h>
 #include <naomi/sprite/sprite.h>
 #include "common.h"
 #include "state.h"
 #include "screens.h"
 #include "controls.h"
+#include "memtest.h"
+#include "crc.h"
+#include "bench.h"
+#include "stress.h"
+#include "upload.h"
+#include "sounds.h"
+#include "sprites.h"
+#include "assets.h"
+#include "boottrace.h"
+#include "synth.h"
+#include "avsync.h"
+#include "jobs.h"
+#include "maplewd.h"
+#include "eeprombench.h"
 
 // The possible screens that we can have in this diagnostics rom.
 #define SCREEN_MAIN_MENU 0
@@ -21,9 +36,20 @@
 #define SCREEN_AUDIO_TESTS 2
 #define SCREEN_INPUT_TESTS 3
 #define SCREEN_EEPROM_TESTS 4
-#define SCREEN_SRAM_TESTS 5
+#define SCREEN_MEMORY_TESTS 5
 #define SCREEN_DIP_TESTS 6
 #define SCREEN_ANALOG_TESTS 7
+#define SCREEN_CRC_TESTS 8
+#define SCREEN_RETENTION_TESTS 9
+#define SCREEN_BENCH_TESTS 10
+#define SCREEN_STRESS_TESTS 11
+#define SCREEN_GPU_TESTS 12
+#define SCREEN_UPLOAD_TESTS 13
+#define SCREEN_BOOT_TRACE 14
+#define SCREEN_SYNTH_TESTS 15
+#define SCREEN_PHASE_TESTS 16
+#define SCREEN_AVSYNC_TESTS 17
+#define SCREEN_EEPROM_BENCH 18
 
 // These aren't really screens, but its easiest if we just add the
 // action functionality into screens themselves.
@@ -38,11 +64,17 @@
 // is preserved when exiting a diagnostic screen.
 static unsigned int main_selected_entry = 0;
 
+// The assets the current screen needs, so that anything else can be thrown
+// out when a test needs the memory.
+static unsigned int screen_assets = 0;
+
 typedef struct
 {
     char *name;
     unsigned int screen;
     unsigned int (*func)(state_t *state, int reinit);
+    // The assets this screen needs loaded before it is first drawn.
+    unsigned int assets;
 } entry_t;
 
 // Forward definitions for various displays.
@@ -52,7 +84,18 @@ unsigned int input_tests(state_t *state, int reinit);
 unsigned int analog_tests(state_t *state, int reinit);
 unsigned int dip_tests(state_t *state, int reinit);
 unsigned int eeprom_tests(state_t *state, int reinit);
-unsigned int sram_tests(state_t *state, int reinit);
+unsigned int memory_tests(state_t *state, int reinit);
+unsigned int crc_tests(state_t *state, int reinit);
+unsigned int retention_tests(state_t *state, int reinit);
+unsigned int bench_tests(state_t *state, int reinit);
+unsigned int stress_tests(state_t *state, int reinit);
+unsigned int gpu_tests(state_t *state, int reinit);
+unsigned int upload_tests(state_t *state, int reinit);
+unsigned int boot_trace(state_t *state, int reinit);
+unsigned int synth_tests(state_t *state, int reinit);
+unsigned int phase_tests(state_t *state, int reinit);
+unsigned int avsync_tests(state_t *state, int reinit);
+unsigned int eeprom_bench_tests(state_t *state, int reinit);
 unsigned int system_menu(state_t *state, int reinit);
 unsigned int reboot_system(state_t *state, int reinit);
 
@@ -62,68 +105,131 @@ entry_t entries[] = {
         "Monitor Tests",
         SCREEN_MONITOR_TESTS,
         monitor_tests,
+        0,
     },
     {
         "Audio Tests",
         SCREEN_AUDIO_TESTS,
         audio_tests,
+        0,
     },
     {
         "JVS Digital Input Tests",
         SCREEN_INPUT_TESTS,
         input_tests,
+        ASSET_SPRITE_BUTTONMASK | ASSET_FONT_MONO,
     },
     {
         "JVS Analog Input Tests",
         SCREEN_ANALOG_TESTS,
         analog_tests,
+        0,
     },
     {
         "Filter Board Input Tests",
         SCREEN_DIP_TESTS,
         dip_tests,
+        ASSET_SPRITE_PSWOFF | ASSET_SPRITE_PSWON,
     },
     {
         "EEPROM Tests",
         SCREEN_EEPROM_TESTS,
         eeprom_tests,
+        0,
+    },
+    {
+        "Memory Tests",
+        SCREEN_MEMORY_TESTS,
+        memory_tests,
+        ASSET_FONT_MONO,
+    },
+    {
+        "SRAM Retention Test",
+        SCREEN_RETENTION_TESTS,
+        retention_tests,
+        0,
+    },
+    {
+        "Memory Signatures",
+        SCREEN_CRC_TESTS,
+        crc_tests,
+        0,
+    },
+    {
+        "Memory Bandwidth",
+        SCREEN_BENCH_TESTS,
+        bench_tests,
+        0,
+    },
+    {
+        "CPU Stress Test",
+        SCREEN_STRESS_TESTS,
+        stress_tests,
+        0,
+    },
+    {
+        "GPU Stress Test",
+        SCREEN_GPU_TESTS,
+        gpu_tests,
+        ASSET_SPRITE_BUTTONMASK,
+    },
+    {
+        "Texture Upload Test",
+        SCREEN_UPLOAD_TESTS,
+        upload_tests,
+        0,
+    },
+    {
+        "Boot Trace",
+        SCREEN_BOOT_TRACE,
+        boot_trace,
+        0,
+    },
+    {
+        "Tone Generator",
+        SCREEN_SYNTH_TESTS,
+        synth_tests,
+        0,
+    },
+    {
+        "Speaker Phase Test",
+        SCREEN_PHASE_TESTS,
+        phase_tests,
+        0,
+    },
+    {
+        "A/V Sync Test",
+        SCREEN_AVSYNC_TESTS,
+        avsync_tests,
+        0,
     },
     {
-        "SRAM Tests",
-        SCREEN_SRAM_TESTS,
-        sram_tests,
+        "EEPROM Benchmark",
+        SCREEN_EEPROM_BENCH,
+        eeprom_bench_tests,
+        0,
     },
     /* An empty entry. */
     {
         "",
         0,
         NULL,
+        0,
     },
     {
         "System Test Menu",
         SCREEN_SYSTEM_MENU,
         system_menu,
+        0,
     },
     {
         "Reboot Naomi",
         SCREEN_REBOOT_SYSTEM,
         reboot_system,
+        0,
     }
 };
 
-pthread_t spawn_background_task(void *(*task)(void * param), void *param)
-{
-    pthread_t thread;
-    pthread_create(&thread, NULL, task, param);
-    return thread;
-}
-
-void despawn_background_task(pthread_t thread)
-{
-    pthread_cancel(thread);
-    pthread_join(thread, NULL);
-}
-
 unsigned int main_menu(state_t *state, int reinit)
 {
     // Grab our configuration.
@@ -1274,10 +1380,22 @@ typedef struct
     unsigned int exit;
     state_t *sysstate;
 
-    pthread_t thread;
-    pthread_mutex_t mutex;
+    // How long the requests for each step took, in microseconds.
+    uint32_t elapsed_us[4];
+
+    // Whether a failed step left us putting the original contents back,
+    // and how that went.
+    unsigned int restore;
+
+    // The worker running the test. It only stops in between requests, and
+    // once it has written to the EEPROM, every way out of it writes the
+    // original contents back first.
+    job_t job;
 } eeprom_test_t;
 
+// How long each EEPROM request gets before we give up on it.
+#define EEPROM_TEST_DEADLINE MAPLEWD_DEFAULT_DEADLINE
+
 #define EEPROM_TEST_STATE_INITIAL_READ 0
 #define EEPROM_TEST_STATE_INITIAL_WRITEBACK 1
 #define EEPROM_TEST_STATE_SECOND_READ 2
@@ -1289,53 +1407,144 @@ typedef struct
 #define EEPROM_TEST_STATE_FAILED_SECOND_READ 1002
 #define EEPROM_TEST_STATE_FAILED_SECOND_WRITEBACK 1003
 
-void *eeprom_test_thread(void *param)
-{
-    eeprom_test_t *eeprom_test = (eeprom_test_t *)param;
+#define EEPROM_TEST_STATE_TIMED_OUT_INITIAL_READ 2000
+#define EEPROM_TEST_STATE_TIMED_OUT_INITIAL_WRITEBACK 2001
+#define EEPROM_TEST_STATE_TIMED_OUT_SECOND_READ 2002
+#define EEPROM_TEST_STATE_TIMED_OUT_SECOND_WRITEBACK 2003
+
+#define EEPROM_TEST_RESTORE_NONE 0
+#define EEPROM_TEST_RESTORE_RUNNING 1
+#define EEPROM_TEST_RESTORE_PASSED 2
+#define EEPROM_TEST_RESTORE_FAILED 3
 
+void eeprom_test_step(eeprom_test_t *eeprom_test, unsigned int state, int reinit)
+{
     // We manually interleave control checks here since we cannot
     // have an outstanding EEPROM read/write request and also try
     // to read controls. The maple bus handles both and cannot do
     // simultaneous outstanding requests.
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&eeprom_test->mutex);
-    controls_t controls = get_controls(eeprom_test->sysstate, 1, COMBINED_CONTROLS);
+    controls_t controls = get_controls(eeprom_test->sysstate, reinit, COMBINED_CONTROLS);
+
+    job_publish_begin(&eeprom_test->job);
+    eeprom_test->state = state;
     if (controls.test_pressed || controls.start_pressed)
     {
         eeprom_test->exit = 1;
     }
-    pthread_mutex_unlock(&eeprom_test->mutex);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+    job_publish_end(&eeprom_test->job);
+}
+
+int eeprom_test_request(eeprom_test_t *eeprom_test, unsigned int step, int write, uint8_t *data)
+{
+    uint32_t elapsed_us = 0;
+    int result;
+    if (write)
+    {
+        result = maplewd_eeprom_write(data, EEPROM_TEST_DEADLINE, &elapsed_us);
+    }
+    else
+    {
+        result = maplewd_eeprom_read(data, EEPROM_TEST_DEADLINE, &elapsed_us);
+    }
+
+    // The final step makes two requests, so this shows the total for both.
+    job_publish_begin(&eeprom_test->job);
+    eeprom_test->elapsed_us[step] += elapsed_us;
+    job_publish_end(&eeprom_test->job);
+
+    return result;
+}
+
+void eeprom_test_restore(eeprom_test_t *eeprom_test, uint8_t *original)
+{
+    job_publish_begin(&eeprom_test->job);
+    eeprom_test->restore = EEPROM_TEST_RESTORE_RUNNING;
+    job_publish_end(&eeprom_test->job);
+
+    // Write the original contents back and read them again to be sure,
+    // since the step that failed may have left anything at all behind.
+    uint8_t readback[128];
+    uint32_t elapsed_us;
+    unsigned int restore = EEPROM_TEST_RESTORE_FAILED;
+    if (
+        maplewd_eeprom_write(original, EEPROM_TEST_DEADLINE, &elapsed_us) == MAPLEWD_OK &&
+        maplewd_eeprom_read(readback, EEPROM_TEST_DEADLINE, &elapsed_us) == MAPLEWD_OK &&
+        memcmp(original, readback, 128) == 0
+    )
+    {
+        restore = EEPROM_TEST_RESTORE_PASSED;
+    }
+
+    job_publish_begin(&eeprom_test->job);
+    eeprom_test->restore = restore;
+    job_publish_end(&eeprom_test->job);
+}
+
+unsigned int eeprom_test_fail(eeprom_test_t *eeprom_test, unsigned int step, int result, uint8_t *original)
+{
+    if (result == MAPLEWD_TIMED_OUT)
+    {
+        eeprom_test_step(eeprom_test, EEPROM_TEST_STATE_TIMED_OUT_INITIAL_READ + step, 0);
+    }
+    else
+    {
+        eeprom_test_step(eeprom_test, EEPROM_TEST_STATE_FAILED_INITIAL_READ + step, 0);
+    }
+
+    // Once we have started writing, the EEPROM may not hold what it did.
+    if (original != NULL)
+    {
+        eeprom_test_restore(eeprom_test, original);
+    }
+
+    return JOB_FAILED;
+}
+
+unsigned int eeprom_test_stop(eeprom_test_t *eeprom_test, uint8_t *original)
+{
+    // Only stop once the EEPROM holds what it did when we started.
+    if (original != NULL)
+    {
+        eeprom_test_restore(eeprom_test, original);
+    }
+
+    return JOB_CANCELLED;
+}
+
+int eeprom_test_stopping(eeprom_test_t *eeprom_test)
+{
+    // Checked after every step, since the user can ask to leave during any
+    // of them and the UI waits for us to finish before it does.
+    return eeprom_test->exit || job_cancelled(&eeprom_test->job);
+}
+
+unsigned int eeprom_test_thread(void *param)
+{
+    eeprom_test_t *eeprom_test = (eeprom_test_t *)param;
+    int result;
 
     // First, try to read, bail out of it fails.
+    eeprom_test_step(eeprom_test, EEPROM_TEST_STATE_INITIAL_READ, 1);
+
     uint8_t eeprom[128];
-    if(maple_request_eeprom_read(eeprom) != 0)
+    result = eeprom_test_request(eeprom_test, EEPROM_TEST_STATE_INITIAL_READ, 0, eeprom);
+    if (result != MAPLEWD_OK)
     {
-        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-        pthread_mutex_lock(&eeprom_test->mutex);
-        eeprom_test->state = EEPROM_TEST_STATE_FAILED_INITIAL_READ;
-        controls = get_controls(eeprom_test->sysstate, 0, COMBINED_CONTROLS);
-        if (controls.test_pressed || controls.start_pressed)
-        {
-            eeprom_test->exit = 1;
-        }
-        pthread_mutex_unlock(&eeprom_test->mutex);
-        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+        return eeprom_test_fail(eeprom_test, EEPROM_TEST_STATE_INITIAL_READ, result, NULL);
+    }
 
-        return NULL;
+    // Nothing has been written yet, so we can stop without restoring.
+    if (eeprom_test_stopping(eeprom_test))
+    {
+        return eeprom_test_stop(eeprom_test, NULL);
     }
 
     // Now, invert the whole thing and write it back.
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&eeprom_test->mutex);
-    eeprom_test->state = EEPROM_TEST_STATE_INITIAL_WRITEBACK;
-    controls = get_controls(eeprom_test->sysstate, 0, COMBINED_CONTROLS);
-    if (controls.test_pressed || controls.start_pressed)
+    eeprom_test_step(eeprom_test, EEPROM_TEST_STATE_INITIAL_WRITEBACK, 0);
+    if (eeprom_test_stopping(eeprom_test))
     {
-        eeprom_test->exit = 1;
+        return eeprom_test_stop(eeprom_test, NULL);
     }
-    pthread_mutex_unlock(&eeprom_test->mutex);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 
     uint8_t inveeprom[128];
     for (int i = 0; i < 128; i++)
@@ -1343,114 +1552,78 @@ void *eeprom_test_thread(void *param)
         inveeprom[i] = ~eeprom[i];
     }
 
-    if(maple_request_eeprom_write(inveeprom) != 0)
+    // Even a write that failed or timed out may have got partway, so from
+    // here on every failure puts the original contents back.
+    result = eeprom_test_request(eeprom_test, EEPROM_TEST_STATE_INITIAL_WRITEBACK, 1, inveeprom);
+    if (result != MAPLEWD_OK)
     {
-        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-        pthread_mutex_lock(&eeprom_test->mutex);
-        eeprom_test->state = EEPROM_TEST_STATE_FAILED_INITIAL_WRITEBACK;
-        controls = get_controls(eeprom_test->sysstate, 0, COMBINED_CONTROLS);
-        if (controls.test_pressed || controls.start_pressed)
-        {
-            eeprom_test->exit = 1;
-        }
-        pthread_mutex_unlock(&eeprom_test->mutex);
-        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-
-        return NULL;
+        return eeprom_test_fail(eeprom_test, EEPROM_TEST_STATE_INITIAL_WRITEBACK, result, eeprom);
     }
 
-    // Now, try to read back that just written eeprom.
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&eeprom_test->mutex);
-    eeprom_test->state = EEPROM_TEST_STATE_SECOND_READ;
-    controls = get_controls(eeprom_test->sysstate, 0, COMBINED_CONTROLS);
-    if (controls.test_pressed || controls.start_pressed)
+    // Now, try to read back that just written eeprom. From here on,
+    // stopping early means putting the original contents back first.
+    eeprom_test_step(eeprom_test, EEPROM_TEST_STATE_SECOND_READ, 0);
+    if (eeprom_test_stopping(eeprom_test))
     {
-        eeprom_test->exit = 1;
+        return eeprom_test_stop(eeprom_test, eeprom);
     }
-    pthread_mutex_unlock(&eeprom_test->mutex);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 
     uint8_t neweeprom[128];
-    if(maple_request_eeprom_read(neweeprom) != 0 || memcmp(inveeprom, neweeprom, 128) != 0)
+    result = eeprom_test_request(eeprom_test, EEPROM_TEST_STATE_SECOND_READ, 0, neweeprom);
+    if (result == MAPLEWD_OK && memcmp(inveeprom, neweeprom, 128) != 0)
     {
-        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-        pthread_mutex_lock(&eeprom_test->mutex);
-        eeprom_test->state = EEPROM_TEST_STATE_FAILED_SECOND_READ;
-        controls = get_controls(eeprom_test->sysstate, 0, COMBINED_CONTROLS);
-        if (controls.test_pressed || controls.start_pressed)
-        {
-            eeprom_test->exit = 1;
-        }
-        pthread_mutex_unlock(&eeprom_test->mutex);
-        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-
-        return NULL;
+        result = MAPLEWD_FAILED;
+    }
+    if (result != MAPLEWD_OK)
+    {
+        return eeprom_test_fail(eeprom_test, EEPROM_TEST_STATE_SECOND_READ, result, eeprom);
     }
 
     // Now, try to write back the inverse of the inverse.
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&eeprom_test->mutex);
-    eeprom_test->state = EEPROM_TEST_STATE_SECOND_WRITEBACK;
-    controls = get_controls(eeprom_test->sysstate, 0, COMBINED_CONTROLS);
-    if (controls.test_pressed || controls.start_pressed)
+    eeprom_test_step(eeprom_test, EEPROM_TEST_STATE_SECOND_WRITEBACK, 0);
+    if (eeprom_test_stopping(eeprom_test))
     {
-        eeprom_test->exit = 1;
+        return eeprom_test_stop(eeprom_test, eeprom);
     }
-    pthread_mutex_unlock(&eeprom_test->mutex);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 
     for (int i = 0; i < 128; i++)
     {
         inveeprom[i] = ~inveeprom[i];
     }
 
-    if(maple_request_eeprom_write(inveeprom) != 0)
+    result = eeprom_test_request(eeprom_test, EEPROM_TEST_STATE_SECOND_WRITEBACK, 1, inveeprom);
+    if (result != MAPLEWD_OK)
     {
-        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-        pthread_mutex_lock(&eeprom_test->mutex);
-        eeprom_test->state = EEPROM_TEST_STATE_FAILED_SECOND_WRITEBACK;
-        controls = get_controls(eeprom_test->sysstate, 0, COMBINED_CONTROLS);
-        if (controls.test_pressed || controls.start_pressed)
-        {
-            eeprom_test->exit = 1;
-        }
-        pthread_mutex_unlock(&eeprom_test->mutex);
-        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+        return eeprom_test_fail(eeprom_test, EEPROM_TEST_STATE_SECOND_WRITEBACK, result, eeprom);
+    }
 
-        return NULL;
+    // The original contents are back, so there is nothing left to undo.
+    if (eeprom_test_stopping(eeprom_test))
+    {
+        return eeprom_test_stop(eeprom_test, NULL);
     }
 
     // Include a second verify (even though we know we read properly) just for kicks.
-    if(maple_request_eeprom_read(neweeprom) != 0 || memcmp(eeprom, neweeprom, 128) != 0)
+    // A read that fails outright is still a pass, but one that times out or
+    // comes back with anything other than the original contents gets another
+    // go at putting them back.
+    result = eeprom_test_request(eeprom_test, EEPROM_TEST_STATE_SECOND_WRITEBACK, 0, neweeprom);
+    if (result == MAPLEWD_OK && memcmp(eeprom, neweeprom, 128) != 0)
     {
-        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-        pthread_mutex_lock(&eeprom_test->mutex);
-        eeprom_test->state = EEPROM_TEST_STATE_FINISHED;
-        controls = get_controls(eeprom_test->sysstate, 0, COMBINED_CONTROLS);
-        if (controls.test_pressed || controls.start_pressed)
-        {
-            eeprom_test->exit = 1;
-        }
-        pthread_mutex_unlock(&eeprom_test->mutex);
-        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-
-        return NULL;
-    };
-
-    // We passed!
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&eeprom_test->mutex);
-    eeprom_test->state = EEPROM_TEST_STATE_FINISHED;
-    controls = get_controls(eeprom_test->sysstate, 0, COMBINED_CONTROLS);
-    if (controls.test_pressed || controls.start_pressed)
+        result = MAPLEWD_FAILED;
+    }
+    else if (result == MAPLEWD_FAILED)
     {
-        eeprom_test->exit = 1;
+        result = MAPLEWD_OK;
+    }
+    if (result != MAPLEWD_OK)
+    {
+        return eeprom_test_fail(eeprom_test, EEPROM_TEST_STATE_SECOND_WRITEBACK, result, eeprom);
     }
-    pthread_mutex_unlock(&eeprom_test->mutex);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 
-    return NULL;
+    // We passed!
+    eeprom_test_step(eeprom_test, EEPROM_TEST_STATE_FINISHED, 0);
+    return JOB_FINISHED;
 }
 
 eeprom_test_t *start_eeprom_test(state_t *state)
@@ -1459,15 +1632,17 @@ eeprom_test_t *start_eeprom_test(state_t *state)
     eeprom_test->state = EEPROM_TEST_STATE_INITIAL_READ;
     eeprom_test->exit = 0;
     eeprom_test->sysstate = state;
-    pthread_mutex_init(&eeprom_test->mutex, NULL);
-    eeprom_test->thread = spawn_background_task(eeprom_test_thread, eeprom_test);
+    memset(eeprom_test->elapsed_us, 0, sizeof(eeprom_test->elapsed_us));
+    eeprom_test->restore = EEPROM_TEST_RESTORE_NONE;
+    job_start(&eeprom_test->job, eeprom_test_thread, eeprom_test, JOB_NO_TIMEOUT);
     return eeprom_test;
 }
 
 void end_eeprom_test(eeprom_test_t *eeprom_test)
 {
-    despawn_background_task(eeprom_test->thread);
-    pthread_mutex_destroy(&eeprom_test->mutex);
+    // The screen only calls this once the worker is done, so that it never
+    // sits here waiting on the maple bus.
+    job_end(&eeprom_test->job);
     free(eeprom_test);
 }
 
@@ -1502,99 +1677,102 @@ unsigned int eeprom_tests(state_t *state, int reinit)
         ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
     }
 
-    pthread_mutex_lock(&test->mutex);
-    unsigned int eepromstate = test->state;
-    unsigned int exitstate = test->exit;
-    pthread_mutex_unlock(&test->mutex);
+    eeprom_test_t published;
+    unsigned int jobstate = job_state(&test->job);
+    job_read(&test->job, &published, test, sizeof(published));
+    unsigned int eepromstate = published.state;
+    unsigned int exitstate = published.exit;
 
-    if (
-        eepromstate == EEPROM_TEST_STATE_FINISHED ||
-        eepromstate == EEPROM_TEST_STATE_FAILED_SECOND_WRITEBACK ||
-        eepromstate == EEPROM_TEST_STATE_FAILED_SECOND_READ ||
-        eepromstate == EEPROM_TEST_STATE_FAILED_INITIAL_WRITEBACK ||
-        eepromstate == EEPROM_TEST_STATE_FAILED_INITIAL_READ
-    ) {
+    if (jobstate != JOB_PENDING && jobstate != JOB_RUNNING)
+    {
         controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
 
-        if (controls.test_pressed || controls.start_pressed)
+        if (exitstate || controls.test_pressed || controls.start_pressed)
         {
-            // Exit out of the EEPROM test screen.
+            // Exit out of the EEPROM test screen, including when we were
+            // asked to partway through and the worker has now stopped.
             new_screen = SCREEN_MAIN_MENU;
         }
     }
     else if (exitstate)
     {
-        // Exit out of the EEPROM test screen.
-        new_screen = SCREEN_MAIN_MENU;
+        // The worker saw the request to leave and is stopping, putting the
+        // original contents back first if it needs to. Keep drawing until it
+        // has, rather than waiting on it here.
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 152, state->font_12pt, rgb(255, 255, 0), "Stopping, leaving once the EEPROM is back the way it was...");
+    }
+
+    // Work out how far we got, and how the last step we reached went.
+    unsigned int reached = eepromstate;
+    char *outcome = NULL;
+    if (eepromstate >= EEPROM_TEST_STATE_TIMED_OUT_INITIAL_READ)
+    {
+        reached = eepromstate - EEPROM_TEST_STATE_TIMED_OUT_INITIAL_READ;
+        outcome = "TIMED OUT";
+    }
+    else if (eepromstate >= EEPROM_TEST_STATE_FAILED_INITIAL_READ)
+    {
+        reached = eepromstate - EEPROM_TEST_STATE_FAILED_INITIAL_READ;
+        outcome = "FAILED";
     }
 
-    switch(eepromstate)
+    char *steps[4] = {
+        "Performing initial read...",
+        "Performing inverted writeback...",
+        "Performing second read...",
+        "Performing final writeback...",
+    };
+
+    for (unsigned int step = 0; step < 4 && step <= reached; step++)
     {
-        case EEPROM_TEST_STATE_FINISHED:
+        int top = CONTENT_VOFFSET + (24 * step);
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), steps[step]);
+
+        if (step == reached && outcome != NULL)
         {
-            /* This is just a fallthrough to the next chunk of states. */
+            ta_draw_text(CONTENT_HOFFSET + 315, top, state->font_18pt, rgb(255, 0, 0), outcome);
         }
-        case EEPROM_TEST_STATE_SECOND_WRITEBACK:
-        case EEPROM_TEST_STATE_FAILED_SECOND_WRITEBACK:
+        else if (step == reached)
         {
-            ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 72, state->font_18pt, rgb(255, 255, 255), "Performing final writeback...");
-            if (eepromstate == EEPROM_TEST_STATE_FAILED_SECOND_WRITEBACK)
-            {
-                ta_draw_text(CONTENT_HOFFSET + 315, CONTENT_VOFFSET + 72, state->font_18pt, rgb(255, 0, 0), "FAILED");
-            }
-            else if (eepromstate != EEPROM_TEST_STATE_SECOND_WRITEBACK)
-            {
-                ta_draw_text(CONTENT_HOFFSET + 315, CONTENT_VOFFSET + 72, state->font_18pt, rgb(0, 255, 0), "PASSED");
-            }
-
-            // Fallthrough to display the previous state.
+            // Still waiting on this one.
+            continue;
         }
-        case EEPROM_TEST_STATE_SECOND_READ:
-        case EEPROM_TEST_STATE_FAILED_SECOND_READ:
+        else
         {
-            ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 48, state->font_18pt, rgb(255, 255, 255), "Performing second read...");
-            if (eepromstate == EEPROM_TEST_STATE_FAILED_SECOND_READ)
-            {
-                ta_draw_text(CONTENT_HOFFSET + 315, CONTENT_VOFFSET + 48, state->font_18pt, rgb(255, 0, 0), "FAILED");
-            }
-            else if (eepromstate != EEPROM_TEST_STATE_SECOND_READ)
-            {
-                ta_draw_text(CONTENT_HOFFSET + 315, CONTENT_VOFFSET + 48, state->font_18pt, rgb(0, 255, 0), "PASSED");
-            }
-
-            // Fallthrough to display the previous state.
+            ta_draw_text(CONTENT_HOFFSET + 315, top, state->font_18pt, rgb(0, 255, 0), "PASSED");
         }
-        case EEPROM_TEST_STATE_INITIAL_WRITEBACK:
-        case EEPROM_TEST_STATE_FAILED_INITIAL_WRITEBACK:
-        {
-            ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 24, state->font_18pt, rgb(255, 255, 255), "Performing inverted writeback...");
-            if (eepromstate == EEPROM_TEST_STATE_FAILED_INITIAL_WRITEBACK)
-            {
-                ta_draw_text(CONTENT_HOFFSET + 315, CONTENT_VOFFSET + 24, state->font_18pt, rgb(255, 0, 0), "FAILED");
-            }
-            else if (eepromstate != EEPROM_TEST_STATE_INITIAL_WRITEBACK)
-            {
-                ta_draw_text(CONTENT_HOFFSET + 315, CONTENT_VOFFSET + 24, state->font_18pt, rgb(0, 255, 0), "PASSED");
-            }
 
-            // Fallthrough to display the previous state.
-        }
-        case EEPROM_TEST_STATE_INITIAL_READ:
-        case EEPROM_TEST_STATE_FAILED_INITIAL_READ:
-        {
-            ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_18pt, rgb(255, 255, 255), "Performing initial read...");
-            if (eepromstate == EEPROM_TEST_STATE_FAILED_INITIAL_READ)
-            {
-                ta_draw_text(CONTENT_HOFFSET + 315, CONTENT_VOFFSET, state->font_18pt, rgb(255, 0, 0), "FAILED");
-            }
-            else if (eepromstate != EEPROM_TEST_STATE_INITIAL_READ)
-            {
-                ta_draw_text(CONTENT_HOFFSET + 315, CONTENT_VOFFSET, state->font_18pt, rgb(0, 255, 0), "PASSED");
-            }
+        ta_draw_text(CONTENT_HOFFSET + 430, top + 4, state->font_12pt, rgb(128, 128, 128), "%.02fms", (double)published.elapsed_us[step] / 1000.0);
+    }
 
-            // No more states to display.
-            break;
-        }
+    if (published.restore == EEPROM_TEST_RESTORE_RUNNING)
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 108, state->font_12pt, rgb(255, 255, 255), "Writing the original contents back...");
+    }
+    else if (published.restore == EEPROM_TEST_RESTORE_PASSED)
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 108, state->font_12pt, rgb(0, 255, 0), "The original contents were written back and verified.");
+    }
+    else if (published.restore == EEPROM_TEST_RESTORE_FAILED)
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 108, state->font_12pt, rgb(255, 0, 0), "Could not write the original contents back, settings may be lost!");
+    }
+
+    if (maplewd_abandoned() > 0)
+    {
+        ta_draw_text(
+            CONTENT_HOFFSET,
+            CONTENT_VOFFSET + 124,
+            state->font_12pt,
+            rgb(128, 128, 128),
+            "%d stuck maple request(s) abandoned and the bus reset since boot.",
+            maplewd_abandoned()
+        );
+    }
+
+    if (maplewd_busy())
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 138, state->font_12pt, rgb(255, 255, 0), "Waiting for a stuck request to get off the bus, controls are paused.");
     }
 
     if (new_screen != SCREEN_EEPROM_TESTS)
@@ -1606,234 +1784,2178 @@ unsigned int eeprom_tests(state_t *state, int reinit)
     return new_screen;
 }
 
-unsigned int walking_0s(unsigned int startaddr, unsigned int size)
+// The layout of the fault map drawn on memory test screens.
+#define FAULT_MAP_COLUMNS 32
+#define FAULT_MAP_CELL 8
+
+void draw_fault_map(state_t *state, int x, int y, memtest_faults_t *faults)
 {
-    // Check for stuck data bits.
-    uint8_t patterns[8] = { 0xFE, 0xFD, 0xFB, 0xF7, 0xEF, 0xDF, 0xBF, 0x7F };
+    int rows = MEMTEST_MAP_CELLS / FAULT_MAP_COLUMNS;
+
+    // Draw a border so an all-good map is still visible.
+    sprite_draw_box(x - 1, y - 1, x + (FAULT_MAP_COLUMNS * FAULT_MAP_CELL) + 1, y + (rows * FAULT_MAP_CELL) + 1, rgb(128, 128, 128));
 
-    for (unsigned int addr = startaddr; addr < startaddr + size; addr++)
+    for (int cell = 0; cell < MEMTEST_MAP_CELLS; cell++)
     {
-        volatile uint8_t *loc = (volatile uint8_t *)addr;
+        int left = x + ((cell % FAULT_MAP_COLUMNS) * FAULT_MAP_CELL);
+        int top = y + ((cell / FAULT_MAP_COLUMNS) * FAULT_MAP_CELL);
 
-        for (int i = 0; i < 8; i++)
+        // Clean cells are dark green, failing cells get brighter the more
+        // failures there are so clusters stand out.
+        color_t color = rgb(0, 64, 0);
+        if (faults->map[cell] > 0)
         {
-            *loc = patterns[i];
-            if ((*loc) != patterns[i])
-            {
-                return addr;
-            }
+            color = rgb(min(255, 128 + faults->map[cell]), 0, 0);
         }
-    }
 
-    return 0;
+        sprite_draw_box(left, top, left + FAULT_MAP_CELL, top + FAULT_MAP_CELL, color);
+    }
 }
 
-unsigned int walking_1s(unsigned int startaddr, unsigned int size)
+void describe_address_lines(char *buf, unsigned int len, address_lines_t *addrlines)
 {
-    // Check for stuck data bits.
-    uint8_t patterns[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+    // Summarize as many bad lines as we have room for, such as "A3 stuck, A4/A7 short".
+    unsigned int used = 0;
+    buf[0] = 0;
 
-    for (unsigned int addr = startaddr; addr < startaddr + size; addr++)
+    for (unsigned int i = 0; i < addrlines->lines && used < len; i++)
     {
-        volatile uint8_t *loc = (volatile uint8_t *)addr;
+        if (addrlines->stuck & (1U << i))
+        {
+            used += snprintf(buf + used, len - used, "%sA%d stuck", used ? ", " : "", i);
+        }
 
-        for (int i = 0; i < 8; i++)
+        for (unsigned int j = i + 1; j < addrlines->lines && used < len; j++)
         {
-            *loc = patterns[i];
-            if ((*loc) != patterns[i])
+            if (addrlines->shorted[i] & (1U << j))
             {
-                return addr;
+                used += snprintf(buf + used, len - used, "%sA%d/A%d short", used ? ", " : "", i, j);
             }
         }
     }
-
-    return 0;
 }
 
-unsigned int device_test(unsigned int startaddr, unsigned int size)
+void describe_data_lanes(char *buf, unsigned int len, memtest_faults_t *faults)
 {
-    // Check to make sure something can be stored in each byte.
-    uint8_t pattern = 5;
-    for (unsigned int addr = startaddr; addr < startaddr + size; addr++)
-    {
-        volatile uint8_t *loc = (volatile uint8_t *)addr;
-        *loc = pattern;
-        pattern++;
-    }
+    // List every data line that was ever wrong, such as "D3:120, D17:4".
+    unsigned int used = 0;
+    buf[0] = 0;
 
-    pattern = 5;
-    for (unsigned int addr = startaddr; addr < startaddr + size; addr++)
+    for (unsigned int lane = 0; lane < MEMTEST_LANES && used < len; lane++)
     {
-        volatile uint8_t *loc = (volatile uint8_t *)addr;
-        if (*loc != pattern)
+        if (faults->lanes[lane])
         {
-            return addr;
+            used += snprintf(buf + used, len - used, "%sD%d:%d", used ? ", " : "", lane, faults->lanes[lane]);
         }
-        pattern++;
     }
+}
 
-    return 0;
+// Sound RAM as seen from the SH-4, uncached.
+#ifndef SOUNDRAM_BASE
+#define SOUNDRAM_BASE 0xA0800000
+#endif
+#ifndef SOUNDRAM_SIZE
+#define SOUNDRAM_SIZE 0x800000
+#endif
+
+// libnaomi loads its AICA driver, along with the driver's stack and the
+// mailbox we talk to it through, at the bottom of sound RAM. We leave this
+// alone so that a bad test can never corrupt the driver we reload after.
+#define SOUNDRAM_DRIVER_SIZE 0x40000
+
+// Main system RAM, as seen from the SH-4 through the cache.
+#ifndef MAINRAM_BASE
+#define MAINRAM_BASE 0x8C000000
+#endif
+#ifndef MAINRAM_SIZE
+#define MAINRAM_SIZE 0x2000000
+#endif
+
+// How finely we search for the largest block of main RAM we can reserve,
+// and how much we hand back afterwards so the test and the menu can still
+// allocate what they need while it runs.
+#define MAINRAM_RESERVE_STEP (64 * 1024)
+#define MAINRAM_HEADROOM (1024 * 1024)
+
+// PowerVR VRAM, and the size of each texture we reserve to cover it.
+#define VRAM_SIZE 0x800000
+#define VRAM_BLOCK_UVSIZE 1024
+#define VRAM_BLOCK_BITSIZE 4
+#define VRAM_BLOCK_SIZE ((VRAM_BLOCK_UVSIZE * VRAM_BLOCK_UVSIZE * VRAM_BLOCK_BITSIZE) / 8)
+#define VRAM_MAX_BLOCKS (VRAM_SIZE / VRAM_BLOCK_SIZE)
+
+// The same memory as addr, but bypassing the cache.
+#define UNCACHED(addr) (((addr) & 0x1FFFFFFF) | 0xA0000000)
+
+typedef struct memory_region
+{
+    char *name;
+    unsigned int base;
+    unsigned int size;
+    unsigned int flags;
+
+    // How big the memory behind this region really is, and what is using
+    // whatever part of it we don't get to test.
+    unsigned int total;
+    char *excluded;
+
+    // Whether the test should keep the region's contents unless asked not
+    // to. Regions that only test memory reserved just for the test have
+    // nothing worth keeping, so preserving it would only slow them down.
+    unsigned int preserve;
+
+    // Called before a test of this region starts and after it is stopped,
+    // to move anything else that uses the region out of the way. Regions
+    // that can only test whatever is free fill in base and size here, and
+    // leave size at zero if nothing could be reserved.
+    void (*prepare)(state_t *state, struct memory_region *region);
+    void (*finish)(state_t *state, struct memory_region *region);
+} memory_region_t;
+
+void soundram_prepare(state_t *state, memory_region_t *region)
+{
+    sounds_suspend(&state->sounds);
+}
+
+void soundram_finish(state_t *state, memory_region_t *region)
+{
+    sounds_resume(&state->sounds);
 }
 
-unsigned int address_test(unsigned int startaddr, unsigned int size)
+void purge_dcache(unsigned int addr, unsigned int size)
 {
-    // Check for address bits stuck low.
-    for (unsigned int offset = 1; offset < size; offset <<= 1)
+    // Write back and drop every cache line covering the range, so that a
+    // stale line can't be written back over a pattern we put there uncached.
+    for (unsigned int line = addr & ~31; line < addr + size; line += 32)
     {
-        volatile uint8_t *loc = (volatile uint8_t *)(startaddr + offset);
-        *loc = 0xAA;
+        __asm__ volatile ("ocbp @%0" : : "r" (line) : "memory");
     }
+}
 
-    // Set the low address to a sentinel, so we can walk up and set values
-    // at each address line high to another and compare against this value.
-    volatile uint8_t *lowloc = (volatile uint8_t *)startaddr;
-    *lowloc = 0xAA;
+// The block of main RAM we have reserved for testing.
+static void *mainram_block = NULL;
 
-    for (unsigned int offset = 1; offset < size; offset <<= 1)
-    {
-        volatile uint8_t *loc = (volatile uint8_t *)(startaddr + offset);
-        *loc = 0x55;
+void mainram_prepare(state_t *state, memory_region_t *region)
+{
+    // Throw out anything loaded for other screens first, then find the
+    // largest block the heap can give us and test that. Our code, data,
+    // stack and anything else already allocated can't go anywhere.
+    assets_release(state, ASSET_ALL & ~screen_assets);
 
-        if (*lowloc != 0xAA)
+    unsigned int size = MAINRAM_SIZE;
+    while (size > MAINRAM_HEADROOM)
+    {
+        void *block = memalign(32, size);
+        if (block != NULL)
         {
-            return startaddr + offset;
+            free(block);
+            break;
         }
+
+        size -= MAINRAM_RESERVE_STEP;
     }
 
-    // Check for address bits stuck high.
-    for (unsigned int offset = 1; offset < size; offset <<= 1)
+    region->base = 0;
+    region->size = 0;
+    if (size <= MAINRAM_HEADROOM)
     {
-        volatile uint8_t *loc = (volatile uint8_t *)(startaddr + offset);
-        *loc = 0xAA;
+        return;
     }
 
-    // Set the low address to a sentinel, so we can walk up and get values
-    // at each address line high to another and compare against this value.
-    *lowloc = 0x55;
-
-    for (unsigned int offset = 1; offset < size; offset <<= 1)
+    mainram_block = memalign(32, size - MAINRAM_HEADROOM);
+    if (mainram_block == NULL)
     {
-        volatile uint8_t *loc = (volatile uint8_t *)(startaddr + offset);
-        if (*loc != 0xAA)
-        {
-            return startaddr + offset;
-        }
+        return;
     }
 
-    return 0;
+    // Test through the uncached mirror so that we hit the chips themselves.
+    purge_dcache((unsigned int)mainram_block, size - MAINRAM_HEADROOM);
+    region->base = UNCACHED((unsigned int)mainram_block);
+    region->size = size - MAINRAM_HEADROOM;
 }
 
-typedef struct
-{
-    unsigned int startaddr;
-    unsigned int size;
-
-    pthread_t thread;
-    pthread_mutex_t mutex;
-
-    unsigned int w1saddr;
-    unsigned int w0saddr;
-    unsigned int addraddr;
-    unsigned int dataaddr;
-} memory_test_t;
-
-void *memtest_thread(void *param)
+void mainram_finish(state_t *state, memory_region_t *region)
 {
-    memory_test_t *memtest = (memory_test_t *)param;
-    unsigned int result;
-
-    /* First, grab our range. */
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&memtest->mutex);
-    unsigned int startaddr = memtest->startaddr;
-    unsigned int size = memtest->size;
-    pthread_mutex_unlock(&memtest->mutex);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-
-    /* Now, run the four memory tests. */
-    result = walking_1s(startaddr, size);
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&memtest->mutex);
-    memtest->w1saddr = result;
-    pthread_mutex_unlock(&memtest->mutex);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-
-    result = walking_0s(startaddr, size);
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&memtest->mutex);
-    memtest->w0saddr = result;
-    pthread_mutex_unlock(&memtest->mutex);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-
-    result = address_test(startaddr, size);
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&memtest->mutex);
-    memtest->addraddr = result;
-    pthread_mutex_unlock(&memtest->mutex);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-
-    result = device_test(startaddr, size);
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&memtest->mutex);
-    memtest->dataaddr = result;
-    pthread_mutex_unlock(&memtest->mutex);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-
-    return NULL;
-}
-
-memory_test_t *start_memory_test(unsigned int startaddr, unsigned int size)
-{
-    memory_test_t *memtest = malloc(sizeof(memory_test_t));
-    memtest->startaddr = startaddr;
-    memtest->size = size;
-    memtest->w1saddr = 0xFFFFFFFF;
-    memtest->w0saddr = 0xFFFFFFFF;
-    memtest->addraddr = 0xFFFFFFFF;
-    memtest->dataaddr = 0xFFFFFFFF;
-    pthread_mutex_init(&memtest->mutex, NULL);
-    memtest->thread = spawn_background_task(memtest_thread, memtest);
-    return memtest;
+    if (mainram_block != NULL)
+    {
+        free(mainram_block);
+        mainram_block = NULL;
+    }
 }
 
-void end_memory_test(memory_test_t *memtest)
-{
-    despawn_background_task(memtest->thread);
-    pthread_mutex_destroy(&memtest->mutex);
-    free(memtest);
-}
+// The blocks of VRAM we have reserved for testing, in address order.
+static void *vram_blocks[VRAM_MAX_BLOCKS];
+static unsigned int vram_block_count = 0;
 
-unsigned int sram_tests(state_t *state, int reinit)
+void vram_prepare(state_t *state, memory_region_t *region)
 {
-    // The test we are currently running.
-    static memory_test_t *test = NULL;
-
-    // Re-initialize the test;
-    if (reinit)
+    // The framebuffers, TA buffers and font glyphs are in use the whole time,
+    // but anything this screen doesn't draw can be thrown out of the way. It
+    // gets loaded again by whichever screen needs it next.
+    assets_release(state, ASSET_ALL & ~screen_assets);
+
+    // Soak up every free texture block we can get, kept sorted by address.
+    vram_block_count = 0;
+    while (vram_block_count < VRAM_MAX_BLOCKS)
     {
-        if (test != NULL)
+        void *block = ta_texture_malloc(VRAM_BLOCK_UVSIZE, VRAM_BLOCK_BITSIZE);
+        if (block == NULL)
         {
-            end_memory_test(test);
+            break;
         }
 
-        test = start_memory_test(SRAM_BASE, SRAM_SIZE);
+        unsigned int pos = vram_block_count;
+        while (pos > 0 && vram_blocks[pos - 1] > block)
+        {
+            vram_blocks[pos] = vram_blocks[pos - 1];
+            pos--;
+        }
+        vram_blocks[pos] = block;
+        vram_block_count++;
     }
 
-    // If we need to switch screens.
-    unsigned int new_screen = SCREEN_SRAM_TESTS;
+    // Find the longest run of blocks that sit right next to each other,
+    // since a test has to cover one contiguous range.
+    unsigned int beststart = 0;
+    unsigned int bestlength = 0;
+    for (unsigned int start = 0; start < vram_block_count;)
+    {
+        unsigned int length = 1;
+        while (
+            start + length < vram_block_count &&
+            (unsigned int)vram_blocks[start + length] == (unsigned int)vram_blocks[start + length - 1] + VRAM_BLOCK_SIZE
+        ) {
+            length++;
+        }
 
-    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+        if (length > bestlength)
+        {
+            beststart = start;
+            bestlength = length;
+        }
+        start += length;
+    }
 
-    if (controls.test_pressed || controls.start_pressed)
+    // Give back everything we aren't going to test.
+    for (unsigned int i = 0; i < vram_block_count; i++)
     {
-        // Exit out of the SRAM test screen.
-        new_screen = SCREEN_MAIN_MENU;
+        if (i < beststart || i >= beststart + bestlength)
+        {
+            ta_texture_free(vram_blocks[i]);
+        }
     }
+    memmove(vram_blocks, vram_blocks + beststart, sizeof(vram_blocks[0]) * bestlength);
+    vram_block_count = bestlength;
 
-    // Display instructions.
-    char *instructions[] = {
-        "Press either start or test to exit.",
-    };
+    region->base = bestlength ? UNCACHED((unsigned int)vram_blocks[0]) : 0;
+    region->size = bestlength * VRAM_BLOCK_SIZE;
+}
+
+void vram_finish(state_t *state, memory_region_t *region)
+{
+    for (unsigned int i = 0; i < vram_block_count; i++)
+    {
+        ta_texture_free(vram_blocks[i]);
+    }
+    vram_block_count = 0;
+}
+
+memory_region_t memory_regions[] = {
+    {
+        "SRAM",
+        SRAM_BASE,
+        SRAM_SIZE,
+        0,
+        SRAM_SIZE,
+        NULL,
+        1,
+        NULL,
+        NULL,
+    },
+    {
+        "Main RAM",
+        0,
+        0,
+        MEMTEST_FLAG_WIDE,
+        MAINRAM_SIZE,
+        "code, data, stack and heap in use",
+        0,
+        mainram_prepare,
+        mainram_finish,
+    },
+    {
+        "VRAM",
+        0,
+        0,
+        MEMTEST_FLAG_WIDE | MEMTEST_FLAG_NO_NARROW,
+        VRAM_SIZE,
+        "framebuffers, TA buffers and fonts",
+        0,
+        vram_prepare,
+        vram_finish,
+    },
+    {
+        "Sound RAM",
+        SOUNDRAM_BASE + SOUNDRAM_DRIVER_SIZE,
+        SOUNDRAM_SIZE - SOUNDRAM_DRIVER_SIZE,
+        MEMTEST_FLAG_G2,
+        SOUNDRAM_SIZE,
+        "the audio driver",
+        1,
+        soundram_prepare,
+        soundram_finish,
+    },
+};
+
+int prepare_region(state_t *state, memory_region_t *region)
+{
+    if (region->prepare != NULL)
+    {
+        region->prepare(state, region);
+    }
+
+    // Zero means we couldn't get any of this region to ourselves.
+    return region->size;
+}
+
+void finish_region(state_t *state, memory_region_t *region)
+{
+    if (region->finish != NULL)
+    {
+        region->finish(state, region);
+    }
+}
+
+memory_test_t *start_region_test(state_t *state, memory_region_t *region, unsigned int preserve, unsigned int *reserved)
+{
+    *reserved = prepare_region(state, region);
+    if (!*reserved)
+    {
+        return NULL;
+    }
+
+    // This can still fail if there's no room to back the region up, which
+    // leaves it prepared for end_region_test() to give back as usual.
+    return start_memory_test(region->base, region->size, region->flags | (preserve ? MEMTEST_FLAG_PRESERVE : 0));
+}
+
+void end_region_test(state_t *state, memory_region_t *region, memory_test_t *test)
+{
+    if (test != NULL)
+    {
+        end_memory_test(test);
+    }
+
+    finish_region(state, region);
+}
+
+unsigned int memory_tests(state_t *state, int reinit)
+{
+    // The test we are currently running, and which region it is for.
+    static memory_test_t *test = NULL;
+    static int region = 0;
+    int regions = sizeof(memory_regions) / sizeof(memory_regions[0]);
+
+    // Whether we put the contents of the region back after testing it.
+    static unsigned int preserve = 1;
+
+    // Whether we got the region, so a missing test means we ran out of RAM.
+    static unsigned int reserved = 0;
+
+    // Re-initialize the test;
+    if (reinit)
+    {
+        if (test != NULL)
+        {
+            end_region_test(state, &memory_regions[region], test);
+        }
+
+        // Always default to leaving game saves alone.
+        region = 0;
+        preserve = memory_regions[region].preserve;
+        test = start_region_test(state, &memory_regions[region], preserve, &reserved);
+    }
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_MEMORY_TESTS;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the memory test screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if (controls.service_pressed || controls.left_pressed || controls.right_pressed)
+    {
+        // Switch test modes or regions, restarting the test from scratch.
+        // The region might have needed sound RAM, so only play our sound
+        // once it has been given back.
+        end_region_test(state, &memory_regions[region], test);
+        audio_play_registered_sound(state->sounds.scroll, SPEAKER_LEFT | SPEAKER_RIGHT, 1.0);
+
+        if (controls.service_pressed)
+        {
+            preserve = !preserve;
+        }
+        else
+        {
+            region += controls.left_pressed ? -1 : 1;
+            if (region < 0) { region = regions - 1; }
+            if (region >= regions) { region = 0; }
+            preserve = memory_regions[region].preserve;
+        }
+
+        test = start_region_test(state, &memory_regions[region], preserve, &reserved);
+    }
+
+    // Display instructions.
+    char *instructions[] = {
+        "Use digital joystick left/right to change region.",
+        "Press service to change test mode.",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    memory_region_t *current = &memory_regions[region];
+    if (test == NULL)
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_18pt, rgb(255, 255, 255), "Region: %s", current->name);
+        if (reserved)
+        {
+            ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 21, state->font_18pt, rgb(255, 0, 0), "Not enough free main RAM to back up this region!");
+        }
+        else
+        {
+            ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 21, state->font_18pt, rgb(255, 0, 0), "Unable to reserve any of this region for testing!");
+        }
+
+        if (new_screen != SCREEN_MEMORY_TESTS)
+        {
+            end_region_test(state, current, test);
+        }
+
+        return new_screen;
+    }
+
+    // The fault map is large-ish, so keep our copy of the results off the stack.
+    static memory_test_t published;
+    job_read(&test->job, &published, test, sizeof(published));
+
+    unsigned int results[6] = {published.w1saddr, published.w0saddr, published.addraddr, published.dataaddr, published.randaddr, published.restoreaddr};
+    unsigned int counts[6] = {published.w1scount, published.w0scount, published.addrcount, published.datacount, published.randcount, published.restorecount};
+    uint32_t times[6] = {published.w1sus, published.w0sus, 0, published.dataus, published.randus, 0};
+    char *titles[6] = {"Walking 1s", "Walking 0s", "Address Bus", "Device", "Random Pattern", "Contents Restore"};
+    uint32_t max_chunk_us = published.max_chunk_us;
+    uint32_t elapsed_us = published.elapsed_us;
+    uint32_t crc = published.crcbefore;
+    address_lines_t addrlines = published.addrlines;
+    memtest_faults_t *faults = &published.faults;
+
+    ta_draw_text(
+        CONTENT_HOFFSET,
+        CONTENT_VOFFSET,
+        state->font_18pt,
+        rgb(255, 255, 255),
+        "Region: %s, 0x%08X-0x%08X (%d KB)",
+        current->name,
+        current->base,
+        current->base + current->size - 1,
+        current->size / 1024
+    );
+
+    if (preserve)
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 21, state->font_18pt, rgb(0, 255, 255), "Non-destructive mode, contents are kept.");
+    }
+    else
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 21, state->font_18pt, rgb(255, 128, 0), "Destructive mode, contents will be lost!");
+    }
+
+    // Only the non-destructive mode has anything to restore.
+    int tests = preserve ? 6 : 5;
+    for (int i = 0; i < tests; i++)
+    {
+        int top = CONTENT_VOFFSET + (21 * (i + 2));
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), "%s Test...", titles[i]);
+
+        switch(results[i])
+        {
+            case MEMTEST_PASSED:
+            {
+                if (i == 5)
+                {
+                    ta_draw_text(CONTENT_HOFFSET + 240, top, state->font_18pt, rgb(0, 255, 0), "PASSED (CRC32 %08X)", crc);
+                }
+                else
+                {
+                    ta_draw_text(CONTENT_HOFFSET + 240, top, state->font_18pt, rgb(0, 255, 0), "PASSED");
+                }
+
+                // Display how fast each test that walks the whole region ran.
+                if (times[i] > 0)
+                {
+                    ta_draw_text(
+                        CONTENT_HOFFSET + 330,
+                        top + 4,
+                        state->font_12pt,
+                        rgb(128, 128, 128),
+                        "%d KB/s",
+                        (uint32_t)(((uint64_t)current->size * 1000000) / ((uint64_t)times[i] * 1024))
+                    );
+                }
+                break;
+            }
+            case MEMTEST_RUNNING:
+            {
+                ta_draw_text(CONTENT_HOFFSET + 240, top, state->font_18pt, rgb(255, 255, 0), "RUNNING");
+                break;
+            }
+            default:
+            {
+                if (i == 2)
+                {
+                    // We know exactly which lines are bad, so say that instead.
+                    char desc[40];
+                    describe_address_lines(desc, sizeof(desc), &addrlines);
+                    ta_draw_text(CONTENT_HOFFSET + 240, top, state->font_18pt, rgb(255, 0, 0), "FAILED: %s", desc);
+                }
+                else
+                {
+                    ta_draw_text(CONTENT_HOFFSET + 240, top, state->font_18pt, rgb(255, 0, 0), "FAILED AT 0x%08X (%d)", results[i], counts[i]);
+                }
+                break;
+            }
+        }
+    }
+
+    // Display where in the region the failures are, since a single bad chip
+    // and a bad address line look completely different.
+    int maptop = CONTENT_VOFFSET + (21 * 8) + 12;
+    draw_fault_map(state, CONTENT_HOFFSET, maptop, faults);
+
+    // Display the first few runs of failing addresses next to the map.
+    int runleft = CONTENT_HOFFSET + (FAULT_MAP_COLUMNS * FAULT_MAP_CELL) + 16;
+    for (int i = 0; i < min(faults->runcount, 8); i++)
+    {
+        ta_draw_text(
+            runleft,
+            maptop + (14 * i),
+            state->font_mono,
+            rgb(255, 0, 0),
+            "%08X +%-4d %02X",
+            faults->runs[i].addr,
+            faults->runs[i].length,
+            faults->runs[i].xormask
+        );
+    }
+    if (faults->runcount > 8 || faults->overflow > 0)
+    {
+        ta_draw_text(runleft, maptop + (14 * 8), state->font_mono, rgb(255, 0, 0), "...and more");
+    }
+
+    // Display how often each data bit was wrong, so a single bad lane is obvious.
+    int lanetop = maptop + ((MEMTEST_MAP_CELLS / FAULT_MAP_COLUMNS) * FAULT_MAP_CELL) + 8;
+    if (current->flags & MEMTEST_FLAG_WIDE)
+    {
+        // There are too many lines on a 32-bit bus to list them all, so total
+        // them up a byte at a time, which usually means a chip at a time, and
+        // then name just the lines that were wrong.
+        for (int byte = 0; byte < 4; byte++)
+        {
+            unsigned int total = 0;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                total += faults->lanes[(byte * 8) + bit];
+            }
+
+            ta_draw_text(
+                CONTENT_HOFFSET + (byte * 144),
+                lanetop,
+                state->font_mono,
+                total ? rgb(255, 0, 0) : rgb(0, 255, 0),
+                "D%d-D%d:%d",
+                byte * 8,
+                (byte * 8) + 7,
+                total
+            );
+        }
+
+        char desc[72];
+        describe_data_lanes(desc, sizeof(desc), faults);
+        ta_draw_text(
+            CONTENT_HOFFSET,
+            lanetop + 14,
+            state->font_mono,
+            desc[0] ? rgb(255, 0, 0) : rgb(0, 255, 0),
+            "Bad lines: %s",
+            desc[0] ? desc : "none"
+        );
+    }
+    else
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            int lane = 7 - bit;
+            ta_draw_text(
+                CONTENT_HOFFSET + ((bit % 4) * 96),
+                lanetop + ((bit / 4) * 14),
+                state->font_mono,
+                faults->lanes[lane] ? rgb(255, 0, 0) : rgb(0, 255, 0),
+                "D%d:%d",
+                lane,
+                faults->lanes[lane]
+            );
+        }
+    }
+
+    // Display how responsive the test is to being stopped, so we can verify
+    // that leaving this screen never stalls for more than a frame.
+    ta_draw_text(
+        CONTENT_HOFFSET,
+        lanetop + 36,
+        state->font_12pt,
+        rgb(128, 128, 128),
+        "Elapsed: %d ms, longest chunk: %d us, last exit: %d us",
+        elapsed_us / 1000,
+        max_chunk_us,
+        memory_test_exit_latency()
+    );
+
+    // Display how much of the memory we actually got to, for regions that
+    // share it with something we can't move.
+    if (current->excluded != NULL)
+    {
+        ta_draw_text(
+            CONTENT_HOFFSET,
+            lanetop + 50,
+            state->font_12pt,
+            rgb(128, 128, 128),
+            "Testing %d%% of %d KB, the rest holds %s.",
+            (int)(((uint64_t)current->size * 100) / current->total),
+            current->total / 1024,
+            current->excluded
+        );
+    }
+
+    if (new_screen != SCREEN_MEMORY_TESTS)
+    {
+        end_region_test(state, current, test);
+        test = 0;
+    }
+
+    return new_screen;
+}
+
+typedef struct
+{
+    char *region;
+
+    // The slowest throughput, in KB/s, a healthy board should ever see for
+    // each operation and width, and for store queue writes.
+    uint32_t results[BENCH_OPS][BENCH_WIDTHS];
+    uint32_t sqwrite;
+
+    // The slowest, in ns, a single dependent read should ever take.
+    uint32_t latency;
+} bench_reference_t;
+
+// Reference figures for each memory region, with zero meaning we have no
+// figure for that measurement. These are deliberately conservative floors
+// rather than typical results, so that only a bus with badly wrong wait
+// states or a failing bus interface gets flagged. Tighten them as figures
+// from known good boards come in.
+bench_reference_t bench_references[] = {
+    {
+        "SRAM",
+        {
+            { 1000, 1000, 1000, 1000 },
+            { 1000, 1000, 1000, 1000 },
+            { 500, 500, 500, 500 },
+        },
+        1000,
+        2000,
+    },
+    {
+        "Main RAM",
+        {
+            { 8000, 16000, 30000, 30000 },
+            { 10000, 20000, 40000, 40000 },
+            { 4000, 8000, 15000, 15000 },
+        },
+        60000,
+        400,
+    },
+    {
+        "VRAM",
+        {
+            { 0, 0, 8000, 8000 },
+            { 0, 0, 30000, 30000 },
+            { 0, 0, 5000, 5000 },
+        },
+        50000,
+        800,
+    },
+    {
+        "Sound RAM",
+        {
+            { 0, 0, 1000, 1000 },
+            { 0, 0, 2000, 2000 },
+            { 0, 0, 500, 500 },
+        },
+        0,
+        3000,
+    },
+};
+
+bench_reference_t *find_bench_reference(memory_region_t *region)
+{
+    for (int i = 0; i < sizeof(bench_references) / sizeof(bench_references[0]); i++)
+    {
+        if (strcmp(bench_references[i].region, region->name) == 0)
+        {
+            return &bench_references[i];
+        }
+    }
+
+    return NULL;
+}
+
+void draw_bench_result(state_t *state, int x, int y, uint32_t result, uint32_t reference, int latency)
+{
+    if (result == BENCH_RUNNING)
+    {
+        ta_draw_text(x, y, state->font_18pt, rgb(255, 255, 0), "...");
+    }
+    else if (result == BENCH_UNSUPPORTED)
+    {
+        ta_draw_text(x, y, state->font_18pt, rgb(128, 128, 128), "n/a");
+    }
+    else
+    {
+        // Throughput is bad when it's too low, latency when it's too high.
+        color_t color = rgb(255, 255, 255);
+        if (reference > 0)
+        {
+            int bad = latency ? (result > reference) : (result < reference);
+            color = bad ? rgb(255, 0, 0) : rgb(0, 255, 0);
+        }
+
+        if (latency)
+        {
+            ta_draw_text(x, y, state->font_18pt, color, "%d ns", result);
+        }
+        else
+        {
+            ta_draw_text(x, y, state->font_18pt, color, "%.01f", (double)result / 1024.0);
+        }
+    }
+}
+
+bench_t *start_region_bench(state_t *state, memory_region_t *region, unsigned int *reserved)
+{
+    *reserved = prepare_region(state, region);
+    if (!*reserved)
+    {
+        return NULL;
+    }
+
+    // Like the memory tests, this can still fail for lack of main RAM, and
+    // the region gets given back by finish_region() as usual.
+    return start_bench(region->base, region->size, region->flags);
+}
+
+unsigned int bench_tests(state_t *state, int reinit)
+{
+    // The benchmark we are currently running, and which region it is for.
+    static bench_t *bench = NULL;
+    static int region = 0;
+    int regions = sizeof(memory_regions) / sizeof(memory_regions[0]);
+
+    // Whether we got the region, so a missing benchmark means we ran out of RAM.
+    static unsigned int reserved = 0;
+
+    // Re-initialize the benchmark;
+    if (reinit)
+    {
+        region = 0;
+        bench = start_region_bench(state, &memory_regions[region], &reserved);
+    }
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_BENCH_TESTS;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the benchmark screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if (controls.right_pressed || controls.service_pressed || controls.left_pressed)
+    {
+        // Move to another region, starting its benchmark from scratch. Like
+        // the memory tests, only play our sound once sound RAM is given back.
+        if (bench != NULL)
+        {
+            end_bench(bench);
+        }
+        finish_region(state, &memory_regions[region]);
+        audio_play_registered_sound(state->sounds.scroll, SPEAKER_LEFT | SPEAKER_RIGHT, 1.0);
+
+        region += controls.left_pressed ? -1 : 1;
+        if (region < 0) { region = regions - 1; }
+        if (region >= regions) { region = 0; }
+
+        bench = start_region_bench(state, &memory_regions[region], &reserved);
+    }
+
+    // Display instructions.
+    char *instructions[] = {
+        "Use digital joystick left/right or service to change region.",
+        "",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    memory_region_t *current = &memory_regions[region];
+    ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_18pt, rgb(255, 255, 255), "Region: %s", current->name);
+
+    if (bench == NULL && reserved)
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 21, state->font_18pt, rgb(255, 0, 0), "Not enough free main RAM to benchmark this region!");
+    }
+    else if (bench == NULL)
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 21, state->font_18pt, rgb(255, 0, 0), "Unable to reserve any of this region for testing!");
+    }
+    else
+    {
+        bench_t published;
+        unsigned int done = job_state(&bench->job) == JOB_FINISHED;
+        job_read(&bench->job, &published, bench, sizeof(published));
+        uint32_t (*results)[BENCH_WIDTHS] = published.results;
+        uint32_t sqwrite = published.sqwrite;
+        uint32_t latency = published.latency;
+
+        // Regions we have no figures for are drawn without any judgement.
+        bench_reference_t noreference;
+        memset(&noreference, 0, sizeof(noreference));
+        bench_reference_t *reference = find_bench_reference(current);
+        if (reference == NULL)
+        {
+            reference = &noreference;
+        }
+
+        ta_draw_text(
+            CONTENT_HOFFSET,
+            CONTENT_VOFFSET + 21,
+            state->font_12pt,
+            rgb(128, 128, 128),
+            "Using 0x%08X-0x%08X, which is put back afterwards.",
+            current->base,
+            current->base + min(current->size, BENCH_WINDOW) - 1
+        );
+
+        char *widths[BENCH_WIDTHS] = {"8-bit", "16-bit", "32-bit", "64-bit"};
+        char *ops[BENCH_OPS] = {"Read", "Write", "Copy"};
+
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 42, state->font_18pt, rgb(255, 255, 255), "MB/s");
+        for (int width = 0; width < BENCH_WIDTHS; width++)
+        {
+            ta_draw_text(CONTENT_HOFFSET + 100 + (width * 110), CONTENT_VOFFSET + 42, state->font_18pt, rgb(255, 255, 255), widths[width]);
+        }
+
+        for (int op = 0; op < BENCH_OPS; op++)
+        {
+            int top = CONTENT_VOFFSET + (21 * (op + 3));
+            ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), ops[op]);
+
+            for (int width = 0; width < BENCH_WIDTHS; width++)
+            {
+                draw_bench_result(state, CONTENT_HOFFSET + 100 + (width * 110), top, results[op][width], reference->results[op][width], 0);
+            }
+        }
+
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + (21 * 7), state->font_18pt, rgb(255, 255, 255), "Store queue write MB/s");
+        draw_bench_result(state, CONTENT_HOFFSET + 320, CONTENT_VOFFSET + (21 * 7), sqwrite, reference->sqwrite, 0);
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + (21 * 8), state->font_18pt, rgb(255, 255, 255), "Dependent read latency");
+        draw_bench_result(state, CONTENT_HOFFSET + 320, CONTENT_VOFFSET + (21 * 8), latency, reference->latency, 1);
+
+        if (done)
+        {
+            ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + (21 * 10), state->font_18pt, rgb(0, 255, 0), "Benchmark finished.");
+        }
+        else
+        {
+            ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + (21 * 10), state->font_18pt, rgb(255, 255, 0), "Benchmark running...");
+        }
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + (21 * 11), state->font_12pt, rgb(128, 128, 128), "Figures in red are outside of the expected range for this region.");
+    }
+
+    if (new_screen != SCREEN_BENCH_TESTS)
+    {
+        if (bench != NULL)
+        {
+            end_bench(bench);
+        }
+        finish_region(state, current);
+        bench = NULL;
+    }
+
+    return new_screen;
+}
+
+typedef struct
+{
+    char *name;
+    unsigned int seconds;
+} burnin_length_t;
+
+burnin_length_t burnin_lengths[] = {
+    { "single pass", 0 },
+    { "1 minute", 60 },
+    { "5 minutes", 5 * 60 },
+    { "15 minutes", 15 * 60 },
+    { "1 hour", 60 * 60 },
+    { "8 hours", 8 * 60 * 60 },
+    { "until stopped", STRESS_FOREVER },
+};
+
+// The slowest, in thousands of operations per second, that a healthy SH-4
+// should ever run each kernel while the menu is also being drawn. Like the
+// bandwidth figures, these are conservative floors rather than typical
+// results.
+uint32_t stress_expected_kops[STRESS_KERNELS] = {
+    100000,
+    50000,
+    200000,
+    5000,
+};
+
+unsigned int stress_tests(state_t *state, int reinit)
+{
+    // The test we are currently running, and how long it should run for.
+    static stress_test_t *test = NULL;
+    static int length = 0;
+    int lengths = sizeof(burnin_lengths) / sizeof(burnin_lengths[0]);
+
+    // Re-initialize the test;
+    if (reinit)
+    {
+        if (test != NULL)
+        {
+            end_stress_test(test);
+        }
+
+        length = 0;
+        test = start_stress_test(burnin_lengths[length].seconds);
+    }
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_STRESS_TESTS;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the stress test screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if (controls.service_pressed || controls.left_pressed || controls.right_pressed)
+    {
+        // Change how long to burn in for, restarting the test from scratch.
+        audio_play_registered_sound(state->sounds.scroll, SPEAKER_LEFT | SPEAKER_RIGHT, 1.0);
+
+        length += controls.left_pressed ? -1 : 1;
+        if (length < 0) { length = lengths - 1; }
+        if (length >= lengths) { length = 0; }
+
+        end_stress_test(test);
+        test = start_stress_test(burnin_lengths[length].seconds);
+    }
+
+    // Display instructions.
+    char *instructions[] = {
+        "Use digital joystick left/right or service to change burn-in length.",
+        "",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    stress_test_t published;
+    unsigned int done = job_state(&test->job) == JOB_FINISHED;
+    job_read(&test->job, &published, test, sizeof(published));
+    unsigned int *rounds = published.rounds;
+    unsigned int *errors = published.errors;
+    uint32_t *kops = published.kops;
+    uint64_t elapsed_us = published.elapsed_us;
+
+    char *titles[STRESS_KERNELS] = {"Integer", "FPU", "FIPR/FTRV Vector", "Cache Thrash"};
+    char *units[STRESS_KERNELS] = {"Mops/s", "MFLOPS", "MFLOPS", "Mlines/s"};
+
+    ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_18pt, rgb(255, 255, 255), "Burn-in length: %s", burnin_lengths[length].name);
+
+    for (int i = 0; i < STRESS_KERNELS; i++)
+    {
+        int top = CONTENT_VOFFSET + (21 * (i + 2));
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), "%s Test...", titles[i]);
+
+        if (errors[i] > 0)
+        {
+            ta_draw_text(CONTENT_HOFFSET + 240, top, state->font_18pt, rgb(255, 0, 0), "FAILED (%d)", errors[i]);
+        }
+        else if (rounds[i] == 0 || !done)
+        {
+            ta_draw_text(CONTENT_HOFFSET + 240, top, state->font_18pt, rgb(255, 255, 0), "RUNNING");
+        }
+        else
+        {
+            ta_draw_text(CONTENT_HOFFSET + 240, top, state->font_18pt, rgb(0, 255, 0), "PASSED");
+        }
+
+        // Display how fast the last round went, flagging a slow CPU.
+        if (rounds[i] > 0)
+        {
+            ta_draw_text(
+                CONTENT_HOFFSET + 400,
+                top + 4,
+                state->font_12pt,
+                kops[i] < stress_expected_kops[i] ? rgb(255, 0, 0) : rgb(128, 128, 128),
+                "%.01f %s",
+                (double)kops[i] / 1000.0,
+                units[i]
+            );
+        }
+    }
+
+    // Display how far along the burn-in is.
+    unsigned int seconds = (unsigned int)(elapsed_us / 1000000);
+    int progresstop = CONTENT_VOFFSET + (21 * 7);
+    if (done)
+    {
+        ta_draw_text(CONTENT_HOFFSET, progresstop, state->font_18pt, rgb(0, 255, 0), "Finished after %d:%02d.", seconds / 60, seconds % 60);
+    }
+    else if (burnin_lengths[length].seconds == 0 || burnin_lengths[length].seconds == STRESS_FOREVER)
+    {
+        ta_draw_text(CONTENT_HOFFSET, progresstop, state->font_18pt, rgb(255, 255, 0), "Running for %d:%02d...", seconds / 60, seconds % 60);
+    }
+    else
+    {
+        ta_draw_text(
+            CONTENT_HOFFSET,
+            progresstop,
+            state->font_18pt,
+            rgb(255, 255, 0),
+            "Running for %d:%02d... %d%%",
+            seconds / 60,
+            seconds % 60,
+            (int)(((uint64_t)seconds * 100) / burnin_lengths[length].seconds)
+        );
+    }
+    ta_draw_text(CONTENT_HOFFSET, progresstop + 21, state->font_12pt, rgb(128, 128, 128), "Completed %d rounds of each kernel.", rounds[STRESS_KERNELS - 1]);
+    ta_draw_text(CONTENT_HOFFSET, progresstop + 35, state->font_12pt, rgb(128, 128, 128), "Speeds in red are slower than expected for a healthy SH-4.");
+
+    if (new_screen != SCREEN_STRESS_TESTS)
+    {
+        end_stress_test(test);
+        test = 0;
+    }
+
+    return new_screen;
+}
+
+// PowerVR framebuffer registers, used to find the frame we last displayed.
+#define FB_R_CTRL 0xA05F8044
+#define FB_R_SOF1 0xA05F8050
+#define FB_R_SIZE 0xA05F805C
+#ifndef VRAM_32BIT_BASE
+#define VRAM_32BIT_BASE 0xA5000000
+#endif
+
+// The kinds of quads we ramp up, in the order we ramp them.
+#define GPU_PHASE_OPAQUE 0
+#define GPU_PHASE_TEXTURED 1
+#define GPU_PHASE_TRANSLUCENT 2
+#define GPU_PHASES 3
+
+// How many quads we start with and can go up to, and how big each one is.
+#define GPU_RAMP_START 16
+#define GPU_RAMP_MAX 4096
+#define GPU_QUAD_SIZE 64
+
+// Frames we let go by after changing the quad count before measuring, and
+// how many frames we average over.
+#define GPU_SETTLE_FRAMES 10
+#define GPU_MEASURE_FRAMES 30
+
+// A step is sustained if it keeps within this fraction of the first step.
+#define GPU_SUSTAINED 0.95
+
+// Frames drawn before the one on screen is guaranteed to be one of ours.
+#define GPU_CHECK_SKIP 3
+
+// Where the quads are drawn, and the fixed pattern we checksum every frame.
+#define GPU_FILL_TOP (CONTENT_VOFFSET + 150)
+#define GPU_FILL_WIDTH 320
+#define GPU_FILL_HEIGHT 160
+#define GPU_CHECK_CELLS 8
+#define GPU_CHECK_CELL 8
+#define GPU_CHECK_SIZE (GPU_CHECK_CELLS * GPU_CHECK_CELL)
+
+int framebuffer_crc(int x, int y, int width, int height, uint32_t *crc)
+{
+    // Work out where and how the frame we last displayed is laid out.
+    uint32_t ctrl = *((volatile uint32_t *)FB_R_CTRL);
+    uint32_t offset = *((volatile uint32_t *)FB_R_SOF1) & 0xFFFFFC;
+    uint32_t size = *((volatile uint32_t *)FB_R_SIZE);
+    unsigned int depths[4] = { 2, 2, 3, 4 };
+    unsigned int depth = depths[(ctrl >> 2) & 0x3];
+    unsigned int stride = ((size & 0x3FF) + ((size >> 20) & 0x3FF)) * 4;
+
+    if (((x + width) * depth) > stride)
+    {
+        // Region doesn't fit in the frame, nothing we can check.
+        return -1;
+    }
+
+    *crc = 0;
+    for (int row = y; row < y + height; row++)
+    {
+        *crc = crc_update(*crc, (void *)(VRAM_32BIT_BASE + offset + (row * stride) + (x * depth)), width * depth);
+    }
+
+    return 0;
+}
+
+unsigned int gpu_tests(state_t *state, int reinit)
+{
+    // Where we are in the ramp, and how many quads we're drawing right now.
+    static int phase = 0;
+    static unsigned int count = GPU_RAMP_START;
+    static unsigned int frames = 0;
+    static double fpssum = 0.0;
+    static double baseline = 0.0;
+
+    // The most quads we could draw in each phase without slowing down, how
+    // fast we were going at that point and whether we ran out of room to ramp.
+    static unsigned int best[GPU_PHASES];
+    static double bestfps[GPU_PHASES];
+    static unsigned int capped[GPU_PHASES];
+
+    // Checksum of the fixed pattern the first time we read it back, and how
+    // often it has come back different since.
+    static uint32_t reference = 0;
+    static unsigned int checks = 0;
+    static unsigned int mismatches = 0;
+    static unsigned int drawn = 0;
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_GPU_TESTS;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the GPU stress test screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if (controls.service_pressed || controls.left_pressed || controls.right_pressed)
+    {
+        // Start the ramp over from scratch.
+        audio_play_registered_sound(state->sounds.scroll, SPEAKER_LEFT | SPEAKER_RIGHT, 1.0);
+        reinit = 1;
+    }
+
+    // Re-initialize the test;
+    if (reinit)
+    {
+        phase = 0;
+        count = GPU_RAMP_START;
+        frames = 0;
+        fpssum = 0.0;
+        baseline = 0.0;
+        memset(best, 0, sizeof(best));
+        memset(bestfps, 0, sizeof(bestfps));
+        memset(capped, 0, sizeof(capped));
+        reference = 0;
+        checks = 0;
+        mismatches = 0;
+        drawn = 0;
+    }
+
+    // Measure how the last step went, then move on once we've seen enough.
+    if (phase < GPU_PHASES)
+    {
+        frames++;
+        if (frames > GPU_SETTLE_FRAMES)
+        {
+            fpssum += state->fps;
+        }
+
+        if (frames == GPU_SETTLE_FRAMES + GPU_MEASURE_FRAMES)
+        {
+            double fps = fpssum / GPU_MEASURE_FRAMES;
+            if (baseline == 0.0)
+            {
+                baseline = fps;
+            }
+
+            int sustained = fps >= (baseline * GPU_SUSTAINED);
+            if (sustained)
+            {
+                best[phase] = count;
+                bestfps[phase] = fps;
+            }
+
+            if (sustained && count < GPU_RAMP_MAX)
+            {
+                count = min(GPU_RAMP_MAX, ((count * 5) / 4) + 1);
+            }
+            else
+            {
+                capped[phase] = sustained;
+                count = GPU_RAMP_START;
+                phase++;
+            }
+
+            frames = 0;
+            fpssum = 0.0;
+        }
+    }
+
+    // Draw the quads for this step, scattered over the fill area.
+    if (phase < GPU_PHASES)
+    {
+        float scale = (float)GPU_QUAD_SIZE / (float)state->sprites.buttonmask->width;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            int x = CONTENT_HOFFSET + ((i * 37) % (GPU_FILL_WIDTH - GPU_QUAD_SIZE));
+            int y = GPU_FILL_TOP + ((i * 23) % (GPU_FILL_HEIGHT - GPU_QUAD_SIZE));
+
+            switch(phase)
+            {
+                case GPU_PHASE_OPAQUE:
+                {
+                    sprite_draw_box(x, y, x + GPU_QUAD_SIZE, y + GPU_QUAD_SIZE, rgb((i * 8) & 0xFF, 128, 255 - ((i * 8) & 0xFF)));
+                    break;
+                }
+                case GPU_PHASE_TEXTURED:
+                {
+                    sprite_draw_scaled(x, y, scale, scale, state->sprites.buttonmask);
+                    break;
+                }
+                case GPU_PHASE_TRANSLUCENT:
+                {
+                    sprite_draw_box(x, y, x + GPU_QUAD_SIZE, y + GPU_QUAD_SIZE, rgba(255, (i * 8) & 0xFF, 0, 64));
+                    break;
+                }
+            }
+        }
+    }
+
+    // Draw the fixed pattern well away from everything else, and verify that
+    // the last frame we displayed has it exactly as it had the first time.
+    int checkx = video_width() - CONTENT_HOFFSET - GPU_CHECK_SIZE;
+    for (int cell = 0; cell < GPU_CHECK_CELLS * GPU_CHECK_CELLS; cell++)
+    {
+        int left = checkx + ((cell % GPU_CHECK_CELLS) * GPU_CHECK_CELL);
+        int top = GPU_FILL_TOP + ((cell / GPU_CHECK_CELLS) * GPU_CHECK_CELL);
+        sprite_draw_box(left, top, left + GPU_CHECK_CELL, top + GPU_CHECK_CELL, rgb((cell * 37) & 0xFF, (cell * 91) & 0xFF, (cell * 153) & 0xFF));
+    }
+
+    // The frame on screen lags behind what we're drawing, so wait out the
+    // first few frames before trusting it. Vertical mode rotates the frame,
+    // so we can't find our pattern in it.
+    uint32_t crc;
+    drawn++;
+    if (!video_is_vertical() && drawn > GPU_CHECK_SKIP && framebuffer_crc(checkx, GPU_FILL_TOP, GPU_CHECK_SIZE, GPU_CHECK_SIZE, &crc) == 0)
+    {
+        if (checks == 0)
+        {
+            reference = crc;
+        }
+        else if (crc != reference)
+        {
+            mismatches++;
+        }
+        checks++;
+    }
+
+    // Display instructions.
+    char *instructions[] = {
+        "Use digital joystick left/right or service to restart the ramp.",
+        "",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    char *titles[GPU_PHASES] = {"Opaque", "Textured", "Translucent"};
+    for (int i = 0; i < GPU_PHASES; i++)
+    {
+        int top = CONTENT_VOFFSET + (21 * i);
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), "%s Quads...", titles[i]);
+
+        if (i == phase)
+        {
+            ta_draw_text(CONTENT_HOFFSET + 200, top, state->font_18pt, rgb(255, 255, 0), "RUNNING (%d per frame)", count);
+        }
+        else if (i < phase && best[i] > 0)
+        {
+            double polys = (double)best[i] * bestfps[i];
+            ta_draw_text(
+                CONTENT_HOFFSET + 200,
+                top,
+                state->font_18pt,
+                rgb(0, 255, 0),
+                "%s%.01fK polys/s, %.01fM pixels/s",
+                capped[i] ? ">" : "",
+                polys / 1000.0,
+                (polys * GPU_QUAD_SIZE * GPU_QUAD_SIZE) / 1000000.0
+            );
+        }
+        else if (i < phase)
+        {
+            ta_draw_text(CONTENT_HOFFSET + 200, top, state->font_18pt, rgb(255, 0, 0), "FAILED TO SUSTAIN ANY");
+        }
+    }
+
+    int checktop = CONTENT_VOFFSET + (21 * 4);
+    ta_draw_text(CONTENT_HOFFSET, checktop, state->font_18pt, rgb(255, 255, 255), "Render Checksum...");
+    if (video_is_vertical())
+    {
+        ta_draw_text(CONTENT_HOFFSET + 200, checktop, state->font_18pt, rgb(128, 128, 128), "n/a in vertical mode");
+    }
+    else if (mismatches > 0)
+    {
+        ta_draw_text(CONTENT_HOFFSET + 200, checktop, state->font_18pt, rgb(255, 0, 0), "FAILED %d OF %d FRAMES", mismatches, checks);
+    }
+    else
+    {
+        ta_draw_text(CONTENT_HOFFSET + 200, checktop, state->font_18pt, phase < GPU_PHASES ? rgb(255, 255, 0) : rgb(0, 255, 0), "%s (CRC32 %08X)", phase < GPU_PHASES ? "RUNNING" : "PASSED", reference);
+    }
+
+    return new_screen;
+}
+
+unsigned int retention_tests(state_t *state, int reinit)
+{
+    // Whether the operator has asked once to write the pattern, and whether
+    // we have actually written it.
+    static unsigned int confirming = 0;
+    static unsigned int armed = 0;
+
+    if (reinit)
+    {
+        confirming = 0;
+        armed = 0;
+    }
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_RETENTION_TESTS;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the retention test screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if ((controls.service_pressed || controls.right_pressed) && !armed)
+    {
+        audio_play_registered_sound(state->sounds.scroll, SPEAKER_LEFT | SPEAKER_RIGHT, 1.0);
+
+        if (confirming)
+        {
+            // Seed off of how long we've been running so that a pattern from
+            // an earlier soak can never be mistaken for this one.
+            retention_arm((uint32_t)(state->animation_counter * 1000000.0));
+            armed = 1;
+        }
+        else
+        {
+            confirming = 1;
+        }
+    }
+
+    // Display instructions.
+    char *instructions[] = {
+        "Use digital joystick right or service to write a retention pattern.",
+        "",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    if (armed)
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_18pt, rgb(0, 255, 0), "Retention pattern written to SRAM.");
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 24, state->font_18pt, rgb(255, 255, 255), "Power off the cabinet for as long as you want to");
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 48, state->font_18pt, rgb(255, 255, 255), "soak the battery, then power it back on. Results");
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 72, state->font_18pt, rgb(255, 255, 255), "will be displayed automatically at boot.");
+    }
+    else if (confirming)
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_18pt, rgb(255, 128, 0), "This will overwrite anything saved in SRAM!");
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 24, state->font_18pt, rgb(255, 255, 255), "Press right or service again to continue.");
+    }
+    else if (state->retention.found)
+    {
+        retention_result_t *result = &state->retention;
+
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_18pt, rgb(255, 255, 255), "Retention pattern found at boot.");
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 24, state->font_18pt, rgb(255, 255, 255), "Pattern: %d bytes, seed %08X", result->size, result->seed);
+
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 72, state->font_18pt, rgb(255, 255, 255), "Data Retention...");
+        if (result->decayed == 0 && result->crcmatched)
+        {
+            ta_draw_text(CONTENT_HOFFSET + 240, CONTENT_VOFFSET + 72, state->font_18pt, rgb(0, 255, 0), "PASSED");
+        }
+        else
+        {
+            ta_draw_text(CONTENT_HOFFSET + 240, CONTENT_VOFFSET + 72, state->font_18pt, rgb(255, 0, 0), "FAILED, %d BYTES DECAYED", result->decayed);
+        }
+
+        if (result->decayed > 0)
+        {
+            ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 96, state->font_18pt, rgb(255, 255, 255), "Decayed range: 0x%08X-0x%08X", result->firstaddr, result->lastaddr);
+            ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 120, state->font_18pt, rgb(255, 255, 255), "Bits lost: %02X, bits gained: %02X", result->fellmask, result->rosemask);
+        }
+
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 168, state->font_12pt, rgb(128, 128, 128), "Verified at boot in %d us.", result->elapsed_us);
+    }
+    else
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_18pt, rgb(255, 255, 255), "No retention pattern was found at boot.");
+    }
+
+    return new_screen;
+}
+
+// The BIOS is mapped at the bottom of area 0. We read it uncached so that
+// the signature reflects what is actually on the bus.
+#ifndef BIOS_BASE
+#define BIOS_BASE 0xA0000000
+#endif
+#ifndef BIOS_SIZE
+#define BIOS_SIZE 0x200000
+#endif
+
+// How much we checksum at once before checking if we've been asked to stop.
+#define CRC_CHUNK_SIZE (64 * 1024)
+
+typedef struct
+{
+    char *name;
+    unsigned int base;
+    unsigned int size;
+} crc_region_t;
+
+crc_region_t crc_regions[] = {
+    {
+        "BIOS ROM",
+        BIOS_BASE,
+        BIOS_SIZE,
+    },
+    {
+        "SRAM",
+        SRAM_BASE,
+        SRAM_SIZE,
+    },
+};
+
+typedef struct
+{
+    unsigned int startaddr;
+    unsigned int size;
+
+    // The worker doing the checksum. Its progress counts bytes checksummed.
+    job_t job;
+
+    uint32_t crc;
+    uint32_t elapsed_us;
+} crc_test_t;
+
+unsigned int crc_test_thread(void *param)
+{
+    crc_test_t *crc_test = (crc_test_t *)param;
+
+    /* First, grab our range. */
+    unsigned int startaddr = crc_test->startaddr;
+    unsigned int size = crc_test->size;
+
+    /* Now, checksum it a chunk at a time so we can report progress. */
+    uint32_t crc = 0;
+    uint32_t elapsed_us = 0;
+    for (unsigned int chunk = startaddr; chunk < startaddr + size; chunk += CRC_CHUNK_SIZE)
+    {
+        if (job_cancelled(&crc_test->job))
+        {
+            return JOB_CANCELLED;
+        }
+
+        unsigned int len = min(CRC_CHUNK_SIZE, (startaddr + size) - chunk);
+        int profile = profile_start();
+        crc = crc_update(crc, (void *)chunk, len);
+        elapsed_us += profile_end(profile);
+
+        job_publish_begin(&crc_test->job);
+        crc_test->crc = crc;
+        crc_test->elapsed_us = elapsed_us;
+        job_publish_end(&crc_test->job);
+        job_progress(&crc_test->job, (chunk - startaddr) + len, size);
+    }
+
+    return JOB_FINISHED;
+}
+
+crc_test_t *start_crc_test(unsigned int startaddr, unsigned int size)
+{
+    crc_test_t *crc_test = malloc(sizeof(crc_test_t));
+    crc_test->startaddr = startaddr;
+    crc_test->size = size;
+    crc_test->crc = 0;
+    crc_test->elapsed_us = 0;
+    job_start(&crc_test->job, crc_test_thread, crc_test, JOB_NO_TIMEOUT);
+    return crc_test;
+}
+
+void end_crc_test(crc_test_t *crc_test)
+{
+    job_end(&crc_test->job);
+    free(crc_test);
+}
+
+unsigned int crc_tests(state_t *state, int reinit)
+{
+    // The signature we are currently calculating, and which region it is for.
+    static crc_test_t *test = NULL;
+    static int region = 0;
+    int regions = sizeof(crc_regions) / sizeof(crc_regions[0]);
+
+    // Re-initialize the test;
+    if (reinit)
+    {
+        if (test != NULL)
+        {
+            end_crc_test(test);
+        }
+
+        region = 0;
+        test = start_crc_test(crc_regions[region].base, crc_regions[region].size);
+    }
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_CRC_TESTS;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the signature screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if (controls.right_pressed || controls.service_pressed || controls.left_pressed)
+    {
+        // Move to another region, starting its signature from scratch.
+        audio_play_registered_sound(state->sounds.scroll, SPEAKER_LEFT | SPEAKER_RIGHT, 1.0);
+
+        region += controls.left_pressed ? -1 : 1;
+        if (region < 0) { region = regions - 1; }
+        if (region >= regions) { region = 0; }
+
+        end_crc_test(test);
+        test = start_crc_test(crc_regions[region].base, crc_regions[region].size);
+    }
+
+    // Display instructions.
+    char *instructions[] = {
+        "Use digital joystick left/right or service to change region.",
+        "",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    crc_test_t published;
+    unsigned int finished = job_state(&test->job) == JOB_FINISHED;
+    unsigned int done = test->job.progress;
+    job_read(&test->job, &published, test, sizeof(published));
+    uint32_t crc = published.crc;
+    uint32_t elapsed_us = published.elapsed_us;
+
+    ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_18pt, rgb(255, 255, 255), "Region: %s", crc_regions[region].name);
+    ta_draw_text(
+        CONTENT_HOFFSET,
+        CONTENT_VOFFSET + 24,
+        state->font_18pt,
+        rgb(255, 255, 255),
+        "Range: 0x%08X-0x%08X (%d KB)",
+        crc_regions[region].base,
+        crc_regions[region].base + crc_regions[region].size - 1,
+        crc_regions[region].size / 1024
+    );
+
+    if (!finished)
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 72, state->font_18pt, rgb(255, 255, 0), "Calculating... %d%%", (int)(((uint64_t)done * 100) / crc_regions[region].size));
+    }
+    else
+    {
+        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + 72, state->font_18pt, rgb(0, 255, 0), "CRC32: %08X", crc);
+    }
+
+    if (elapsed_us > 0)
+    {
+        ta_draw_text(
+            CONTENT_HOFFSET,
+            CONTENT_VOFFSET + 96,
+            state->font_18pt,
+            rgb(255, 255, 255),
+            "Throughput: %.02f MB/s",
+            ((double)done / (double)elapsed_us) * (1000000.0 / (1024.0 * 1024.0))
+        );
+    }
+
+    if (new_screen != SCREEN_CRC_TESTS)
+    {
+        end_crc_test(test);
+        test = 0;
+    }
+
+    return new_screen;
+}
+
+unsigned int upload_tests(state_t *state, int reinit)
+{
+    // The upload test we are currently running.
+    static upload_test_t *upload = NULL;
+
+    // Re-initialize the test, making as much room in VRAM as we can first.
+    if (reinit)
+    {
+        assets_release(state, ASSET_ALL & ~screen_assets);
+        upload = start_upload_test();
+    }
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_UPLOAD_TESTS;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the texture upload screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if (controls.service_pressed || controls.left_pressed || controls.right_pressed)
+    {
+        // Run every upload again from scratch.
+        audio_play_registered_sound(state->sounds.scroll, SPEAKER_LEFT | SPEAKER_RIGHT, 1.0);
+        end_upload_test(upload);
+        upload = start_upload_test();
+    }
+
+    // Display instructions.
+    char *instructions[] = {
+        "Press service to run the test again.",
+        "",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    upload_test_t published;
+    unsigned int jobstate = job_state(&upload->job);
+    unsigned int done = jobstate == JOB_FINISHED;
+    job_read(&upload->job, &published, upload, sizeof(published));
+    uint32_t (*results)[UPLOAD_METHODS][UPLOAD_SIZES] = published.results;
+    unsigned int (*errors)[UPLOAD_METHODS][UPLOAD_SIZES] = published.errors;
+
+    char *formats[UPLOAD_FORMATS] = {"1555", "4444", "8888", "4bpp pal", "8bpp pal", "1555 twid"};
+    char *methods[UPLOAD_METHODS] = {"CPU", "SQ"};
+
+    ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_18pt, rgb(255, 255, 255), "MB/s");
+    for (int sizeidx = 0; sizeidx < UPLOAD_SIZES; sizeidx++)
+    {
+        ta_draw_text(CONTENT_HOFFSET + 140 + (sizeidx * 90), CONTENT_VOFFSET, state->font_18pt, rgb(255, 255, 255), "%d", UPLOAD_MIN_UVSIZE << sizeidx);
+    }
+
+    unsigned int failures = 0;
+    for (int format = 0; format < UPLOAD_FORMATS; format++)
+    {
+        for (int method = 0; method < UPLOAD_METHODS; method++)
+        {
+            int top = CONTENT_VOFFSET + (21 * (1 + (format * UPLOAD_METHODS) + method));
+            ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), "%s %s", formats[format], methods[method]);
+
+            for (int sizeidx = 0; sizeidx < UPLOAD_SIZES; sizeidx++)
+            {
+                int x = CONTENT_HOFFSET + 140 + (sizeidx * 90);
+                uint32_t result = results[format][method][sizeidx];
+
+                if (result == UPLOAD_RUNNING)
+                {
+                    ta_draw_text(x, top, state->font_18pt, rgb(255, 255, 0), "...");
+                }
+                else if (result == UPLOAD_NO_ROOM)
+                {
+                    ta_draw_text(x, top, state->font_18pt, rgb(128, 128, 128), "n/a");
+                }
+                else
+                {
+                    color_t color = errors[format][method][sizeidx] ? rgb(255, 0, 0) : rgb(0, 255, 0);
+                    ta_draw_text(x, top, state->font_18pt, color, "%.01f", (double)result / 1024.0);
+                    failures += errors[format][method][sizeidx];
+                }
+            }
+        }
+    }
+
+    int bottom = CONTENT_VOFFSET + (21 * (2 + (UPLOAD_FORMATS * UPLOAD_METHODS)));
+    if (failures)
+    {
+        ta_draw_text(CONTENT_HOFFSET, bottom, state->font_18pt, rgb(255, 0, 0), "%d words read back wrong!", failures);
+    }
+    else if (done)
+    {
+        ta_draw_text(CONTENT_HOFFSET, bottom, state->font_18pt, rgb(0, 255, 0), "Every texture read back intact.");
+    }
+    else if (jobstate == JOB_FAILED)
+    {
+        ta_draw_text(CONTENT_HOFFSET, bottom, state->font_18pt, rgb(255, 0, 0), "Not enough free main RAM to build the textures!");
+    }
+    else
+    {
+        ta_draw_text(CONTENT_HOFFSET, bottom, state->font_18pt, rgb(255, 255, 0), "Uploading... %d%%", upload->job.total ? (upload->job.progress * 100) / upload->job.total : 0);
+    }
+    ta_draw_text(CONTENT_HOFFSET, bottom + 21, state->font_12pt, rgb(128, 128, 128), "Figures in red did not read back the same as what was uploaded.");
+    ta_draw_text(CONTENT_HOFFSET, bottom + 35, state->font_12pt, rgb(128, 128, 128), "Textures that did not fit in free VRAM are shown as n/a.");
+
+    if (new_screen != SCREEN_UPLOAD_TESTS)
+    {
+        end_upload_test(upload);
+        upload = NULL;
+    }
+
+    return new_screen;
+}
+
+// Marks a step that the last boot didn't have.
+#define BOOTTRACE_MISSING 0xFFFFFFFF
+
+uint32_t boottrace_find(boottrace_t *trace, char *name)
+{
+    // Steps can come in a different order from boot to boot, so go by name.
+    if (trace != NULL)
+    {
+        for (unsigned int i = 0; i < trace->count; i++)
+        {
+            if (strncmp(trace->steps[i].name, name, BOOTTRACE_NAME_LENGTH) == 0)
+            {
+                return trace->steps[i].us;
+            }
+        }
+    }
+
+    return BOOTTRACE_MISSING;
+}
+
+unsigned int boot_trace(state_t *state, int reinit)
+{
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_BOOT_TRACE;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the boot trace screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if (controls.service_pressed)
+    {
+        // Start or stop keeping traces in SRAM from boot to boot.
+        audio_play_registered_sound(state->sounds.scroll, SPEAKER_LEFT | SPEAKER_RIGHT, 1.0);
+        boottrace_set_saving(!boottrace_saving());
+    }
+
+    // Display instructions.
+    char *instructions[] = {
+        "Times for every step from power on to the first menu frame.",
+        "Press service to turn saving traces to SRAM on or off.",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    boottrace_t *current = boottrace_current();
+    boottrace_t *last = boottrace_last();
+
+    // The slowest step is the one worth looking at, so find it for the bars.
+    uint32_t slowest = 1;
+    uint32_t traced = 0;
+    for (unsigned int i = 0; i < current->count; i++)
+    {
+        slowest = max(slowest, current->steps[i].us);
+        traced += current->steps[i].us;
+    }
+
+    int barwidth = video_width() - (CONTENT_HOFFSET * 2) - 400;
+
+    ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET, state->font_12pt, rgb(255, 255, 255), "Step");
+    ta_draw_text(CONTENT_HOFFSET + 200, CONTENT_VOFFSET, state->font_12pt, rgb(255, 255, 255), "This boot");
+    ta_draw_text(CONTENT_HOFFSET + 300, CONTENT_VOFFSET, state->font_12pt, rgb(255, 255, 255), "Last boot");
+
+    for (unsigned int i = 0; i < current->count; i++)
+    {
+        int top = CONTENT_VOFFSET + (14 * (i + 1));
+        uint32_t us = current->steps[i].us;
+        uint32_t lastus = boottrace_find(last, current->steps[i].name);
+        color_t color = us == slowest ? rgb(255, 255, 0) : rgb(255, 255, 255);
+
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_12pt, color, "%s", current->steps[i].name);
+        ta_draw_text(CONTENT_HOFFSET + 200, top, state->font_12pt, color, "%.02f ms", (double)us / 1000.0);
+        if (lastus == BOOTTRACE_MISSING)
+        {
+            ta_draw_text(CONTENT_HOFFSET + 300, top, state->font_12pt, rgb(128, 128, 128), "n/a");
+        }
+        else
+        {
+            ta_draw_text(CONTENT_HOFFSET + 300, top, state->font_12pt, rgb(128, 128, 128), "%.02f ms", (double)lastus / 1000.0);
+        }
+
+        if (barwidth > 0)
+        {
+            int width = (int)(((uint64_t)us * barwidth) / slowest);
+            sprite_draw_box(CONTENT_HOFFSET + 400, top + 3, CONTENT_HOFFSET + 400 + max(width, 1), top + 11, color);
+        }
+    }
+
+    int bottom = CONTENT_VOFFSET + (14 * (current->count + 2));
+    uint32_t untraced = current->total_us > traced ? current->total_us - traced : 0;
+    ta_draw_text(CONTENT_HOFFSET, bottom, state->font_12pt, rgb(255, 255, 255), "Everything else");
+    ta_draw_text(CONTENT_HOFFSET + 200, bottom, state->font_12pt, rgb(255, 255, 255), "%.02f ms", (double)untraced / 1000.0);
+    ta_draw_text(CONTENT_HOFFSET, bottom + 14, state->font_12pt, rgb(255, 255, 255), "Total to first frame");
+    ta_draw_text(CONTENT_HOFFSET + 200, bottom + 14, state->font_12pt, rgb(255, 255, 255), "%.02f ms", (double)current->total_us / 1000.0);
+    if (last != NULL)
+    {
+        ta_draw_text(CONTENT_HOFFSET + 300, bottom + 14, state->font_12pt, rgb(128, 128, 128), "%.02f ms", (double)last->total_us / 1000.0);
+    }
+    else
+    {
+        ta_draw_text(CONTENT_HOFFSET + 300, bottom + 14, state->font_12pt, rgb(128, 128, 128), "n/a");
+    }
+
+    ta_draw_text(CONTENT_HOFFSET, bottom + 35, state->font_12pt, rgb(128, 128, 128), "The slowest step is shown in yellow.");
+    if (boottrace_saving())
+    {
+        ta_draw_text(CONTENT_HOFFSET, bottom + 49, state->font_12pt, rgb(255, 128, 0), "Each boot saves its trace to the last %d bytes of SRAM.", (int)BOOTTRACE_SRAM_SIZE);
+    }
+    else
+    {
+        ta_draw_text(CONTENT_HOFFSET, bottom + 49, state->font_12pt, rgb(128, 128, 128), "Traces are not being saved. Saving uses the last %d bytes of SRAM,", (int)BOOTTRACE_SRAM_SIZE);
+        ta_draw_text(CONTENT_HOFFSET, bottom + 63, state->font_12pt, rgb(128, 128, 128), "which will destroy any game saves or high scores kept there.");
+    }
+
+    return new_screen;
+}
+
+// Frequencies the tone generator can play, in Hz.
+unsigned int synth_frequencies[] = {
+    50,
+    100,
+    250,
+    440,
+    1000,
+    2000,
+    4000,
+    8000,
+    12000,
+    16000,
+};
+
+unsigned int synth_tests(state_t *state, int reinit)
+{
+    // What we're generating, and the stream that is playing it.
+    static synth_t *synth = NULL;
+    static synth_params_t params;
+    static int frequency = 0;
+    int frequencies = sizeof(synth_frequencies) / sizeof(synth_frequencies[0]);
+
+    if (reinit)
+    {
+        // Start out with silence on both speakers.
+        frequency = 4;
+        params.signal = SYNTH_SILENCE;
+        params.frequency = synth_frequencies[frequency];
+        params.speakers = SPEAKER_LEFT | SPEAKER_RIGHT;
+        params.level = SYNTH_LEVEL_MAX;
+        params.invert = 0;
+        synth = start_synth(&params);
+    }
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_SYNTH_TESTS;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the tone generator screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if (controls.right_pressed || controls.left_pressed)
+    {
+        // Pick the next or previous signal.
+        int signal = (int)params.signal + (controls.left_pressed ? -1 : 1);
+        if (signal < 0) { signal = SYNTH_SIGNALS - 1; }
+        if (signal >= SYNTH_SIGNALS) { signal = 0; }
+        params.signal = signal;
+    }
+    else if (controls.up_pressed || controls.down_pressed)
+    {
+        // Pick a higher or lower frequency.
+        frequency += controls.down_pressed ? -1 : 1;
+        if (frequency < 0) { frequency = 0; }
+        if (frequency >= frequencies) { frequency = frequencies - 1; }
+        params.frequency = synth_frequencies[frequency];
+    }
+    else if (controls.service_pressed)
+    {
+        // Cycle through both, left and right speakers.
+        if (params.speakers == (SPEAKER_LEFT | SPEAKER_RIGHT))
+        {
+            params.speakers = SPEAKER_LEFT;
+        }
+        else if (params.speakers == SPEAKER_LEFT)
+        {
+            params.speakers = SPEAKER_RIGHT;
+        }
+        else
+        {
+            params.speakers = SPEAKER_LEFT | SPEAKER_RIGHT;
+        }
+    }
+    synth_set_params(synth, &params);
+
+    // Display instructions.
+    char *instructions[] = {
+        "Use digital joystick left/right to pick a signal.",
+        "Use digital joystick up/down to change the tone frequency.",
+        "Press service to change speakers.",
+        "",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    char *signals[SYNTH_SIGNALS] = {
+        "No sound playing.",
+        "Sine tone",
+        "Log sine sweep, 20Hz to 20kHz.",
+        "White noise.",
+        "Pink noise.",
+        "Polarity pulses.",
+    };
+    char *speakers = "Both speakers.";
+    if (params.speakers == SPEAKER_LEFT)
+    {
+        speakers = "Left speaker only.";
+    }
+    else if (params.speakers == SPEAKER_RIGHT)
+    {
+        speakers = "Right speaker only.";
+    }
+
+    int top = CONTENT_VOFFSET + 14;
+    if (params.signal == SYNTH_SINE)
+    {
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), "Sine tone, %dHz.", params.frequency);
+    }
+    else
+    {
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), "%s", signals[params.signal]);
+    }
+    ta_draw_text(CONTENT_HOFFSET, top + 21, state->font_18pt, rgb(255, 255, 255), "%s", speakers);
+
+    uint32_t written;
+    job_read(&synth->job, &written, &synth->written, sizeof(written));
+
+    if (job_state(&synth->job) == JOB_FAILED)
+    {
+        ta_draw_text(CONTENT_HOFFSET, top + 63, state->font_12pt, rgb(255, 0, 0), "Not enough free main RAM to generate audio!");
+    }
+    else
+    {
+        ta_draw_text(
+            CONTENT_HOFFSET,
+            top + 63,
+            state->font_12pt,
+            rgb(128, 128, 128),
+            "Generated live at %dHz, %.01f seconds streamed so far.",
+            SYNTH_SAMPLERATE,
+            (double)written / (double)SYNTH_SAMPLERATE
+        );
+    }
+
+    if (new_screen != SCREEN_SYNTH_TESTS)
+    {
+        end_synth(synth);
+        synth = NULL;
+    }
+
+    return new_screen;
+}
+
+typedef struct
+{
+    char *name;
+    char *expected;
+    synth_params_t params;
+} phase_mode_t;
+
+// Each pair of in phase and out of phase signals should sound clearly
+// different on a correctly wired cabinet. If the out of phase one sounds
+// fuller, one of the speakers is wired backwards.
+phase_mode_t phase_modes[] = {
+    {
+        "In phase, pink noise.",
+        "Should sound full and centered between the speakers.",
+        { SYNTH_PINK_NOISE, 0, SPEAKER_LEFT | SPEAKER_RIGHT, 0, 0 },
+    },
+    {
+        "Out of phase, pink noise.",
+        "Should sound hollow and spread out, with weaker bass.",
+        { SYNTH_PINK_NOISE, 0, SPEAKER_LEFT | SPEAKER_RIGHT, 0, SPEAKER_RIGHT },
+    },
+    {
+        "In phase, 80Hz tone.",
+        "Should have strong, steady bass.",
+        { SYNTH_SINE, 80, SPEAKER_LEFT | SPEAKER_RIGHT, 0, 0 },
+    },
+    {
+        "Out of phase, 80Hz tone.",
+        "Bass should nearly vanish, especially between the speakers.",
+        { SYNTH_SINE, 80, SPEAKER_LEFT | SPEAKER_RIGHT, 0, SPEAKER_RIGHT },
+    },
+    {
+        "Polarity pulses, left speaker.",
+        "The cone should push outward on every pulse.",
+        { SYNTH_PULSE, 0, SPEAKER_LEFT, 0, 0 },
+    },
+    {
+        "Polarity pulses, right speaker.",
+        "The cone should push outward on every pulse.",
+        { SYNTH_PULSE, 0, SPEAKER_RIGHT, 0, 0 },
+    },
+    {
+        "Polarity pulses, both speakers.",
+        "Both cones should push outward together on every pulse.",
+        { SYNTH_PULSE, 0, SPEAKER_LEFT | SPEAKER_RIGHT, 0, 0 },
+    },
+};
+
+// How much each up/down press changes the level by.
+#define PHASE_LEVEL_STEP (SYNTH_LEVEL_MAX / 16)
+
+unsigned int phase_tests(state_t *state, int reinit)
+{
+    // Which signal we're playing, how loud, and the stream that plays it.
+    static synth_t *synth = NULL;
+    static int mode = 0;
+    static unsigned int level = SYNTH_LEVEL_MAX / 2;
+    int modes = sizeof(phase_modes) / sizeof(phase_modes[0]);
+
+    if (reinit)
+    {
+        // Start out fairly quiet, since pulses and bass can be startling.
+        mode = 0;
+        level = SYNTH_LEVEL_MAX / 2;
+        synth_params_t params = phase_modes[mode].params;
+        params.level = level;
+        synth = start_synth(&params);
+    }
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_PHASE_TESTS;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the speaker phase screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if (controls.right_pressed || controls.service_pressed || controls.left_pressed)
+    {
+        // Pick the next or previous signal.
+        mode += controls.left_pressed ? -1 : 1;
+        if (mode < 0) { mode = modes - 1; }
+        if (mode >= modes) { mode = 0; }
+    }
+    else if (controls.up_pressed)
+    {
+        level = min(level + PHASE_LEVEL_STEP, SYNTH_LEVEL_MAX);
+    }
+    else if (controls.down_pressed)
+    {
+        level = level > PHASE_LEVEL_STEP ? level - PHASE_LEVEL_STEP : 0;
+    }
+
+    // Level changes are picked up without restarting the signal.
+    synth_params_t params = phase_modes[mode].params;
+    params.level = level;
+    synth_set_params(synth, &params);
+
+    // Display instructions.
+    char *instructions[] = {
+        "Use digital joystick left/right or service to pick a signal.",
+        "Use digital joystick up/down to change the level.",
+        "",
+        "Press either start or test to exit.",
+    };
 
     for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
     {
@@ -1841,39 +3963,514 @@ unsigned int sram_tests(state_t *state, int reinit)
         ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
     }
 
-    pthread_mutex_lock(&test->mutex);
-    unsigned int results[4] = {test->w1saddr, test->w0saddr, test->addraddr, test->dataaddr};
-    char *titles[4] = {"Walking 1s", "Walking 0s", "Address Bus", "Device"};
-    pthread_mutex_unlock(&test->mutex);
+    int top = CONTENT_VOFFSET + 14;
+    ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), phase_modes[mode].name);
+    ta_draw_text(CONTENT_HOFFSET, top + 21, state->font_12pt, rgb(255, 255, 0), phase_modes[mode].expected);
 
-    for (int i = 0; i < (sizeof(results) / sizeof(results[0])); i++)
+    ta_draw_text(CONTENT_HOFFSET, top + 56, state->font_18pt, rgb(255, 255, 255), "Level: %d%%", (level * 100) / SYNTH_LEVEL_MAX);
+    int barleft = CONTENT_HOFFSET + 140;
+    int barwidth = 256;
+    sprite_draw_box(barleft, top + 60, barleft + barwidth, top + 74, rgb(64, 64, 64));
+    if (level > 0)
     {
-        ta_draw_text(CONTENT_HOFFSET, CONTENT_VOFFSET + (24 * i), state->font_18pt, rgb(255, 255, 255), "%s Test...", titles[i]);
+        sprite_draw_box(barleft, top + 60, barleft + ((level * barwidth) / SYNTH_LEVEL_MAX), top + 74, rgb(0, 255, 0));
+    }
 
-        switch(results[i])
+    char *notes[] = {
+        "If the out of phase signals sound fuller than the in phase ones, one",
+        "speaker is wired backwards. Swap the + and - wires on one of them.",
+        "Use the polarity pulses to find which one, with the grille off.",
+    };
+    for (int i = 0; i < sizeof(notes) / sizeof(notes[0]); i++)
+    {
+        ta_draw_text(CONTENT_HOFFSET, top + 105 + (14 * i), state->font_12pt, rgb(128, 128, 128), notes[i]);
+    }
+
+    if (job_state(&synth->job) == JOB_FAILED)
+    {
+        ta_draw_text(CONTENT_HOFFSET, top + 161, state->font_12pt, rgb(255, 0, 0), "Not enough free main RAM to generate audio!");
+    }
+
+    if (new_screen != SCREEN_PHASE_TESTS)
+    {
+        end_synth(synth);
+        synth = NULL;
+    }
+
+    return new_screen;
+}
+
+// How many frames we wait in between each flash and click.
+#define AVSYNC_INTERVAL_FRAMES 60
+
+// How long we look for the click to start before giving up on it.
+#define AVSYNC_TIMEOUT_US 500000
+
+#define AVSYNC_IDLE 0
+#define AVSYNC_FLASHED 1
+#define AVSYNC_SEARCHING 2
+
+unsigned int avsync_tests(state_t *state, int reinit)
+{
+    // The click we play, and where we are in measuring it.
+    static int click = -1;
+    static int phase = AVSYNC_IDLE;
+    static unsigned int frames = 0;
+    static avsync_snapshot_t snapshot;
+    static avsync_results_t results;
+
+    // When we handed off the click, and when the flash went out, along with
+    // the most recent measurements for display.
+    static uint32_t submit_us = 0;
+    static uint32_t flip_us = 0;
+    static int32_t last_offset = 0;
+    static uint32_t last_lead = 0;
+    static uint32_t last_latency = 0;
+
+    if (reinit)
+    {
+        int16_t *data = avsync_make_click();
+        click = audio_register_sound(AUDIO_FORMAT_16BIT, AVSYNC_SAMPLERATE, data, AVSYNC_SOUND_SAMPLES);
+        free(data);
+
+        phase = AVSYNC_IDLE;
+        frames = 0;
+        memset(&results, 0, sizeof(results));
+        last_offset = 0;
+        last_lead = 0;
+        last_latency = 0;
+    }
+
+    // The previous frame, if we drew the flash in it, has just gone out on
+    // the vblank we were waiting for, so this is as close to it as we get.
+    uint32_t now = avsync_clock();
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_AVSYNC_TESTS;
+
+    controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+    if (controls.test_pressed || controls.start_pressed)
+    {
+        // Exit out of the A/V sync screen.
+        new_screen = SCREEN_MAIN_MENU;
+    }
+    else if (controls.service_pressed)
+    {
+        // Throw away everything measured so far.
+        memset(&results, 0, sizeof(results));
+    }
+
+    if (phase == AVSYNC_FLASHED)
+    {
+        flip_us = now;
+        phase = AVSYNC_SEARCHING;
+    }
+    if (phase == AVSYNC_SEARCHING)
+    {
+        int played = avsync_find_start(&snapshot);
+        if (played >= 0)
+        {
+            // Work back from how far into the click the AICA is to when it
+            // actually started playing.
+            uint32_t start_us = avsync_clock() - (uint32_t)(((uint64_t)played * 1000000) / AVSYNC_SAMPLERATE);
+
+            last_offset = (int32_t)(start_us - flip_us);
+            last_lead = flip_us - submit_us;
+            last_latency = start_us - submit_us;
+            avsync_record(&results, last_offset);
+            phase = AVSYNC_IDLE;
+        }
+        else if ((now - submit_us) > AVSYNC_TIMEOUT_US)
+        {
+            results.missed++;
+            phase = AVSYNC_IDLE;
+        }
+    }
+
+    if (phase == AVSYNC_IDLE && new_screen == SCREEN_AVSYNC_TESTS)
+    {
+        frames++;
+        if (frames >= AVSYNC_INTERVAL_FRAMES && click >= 0)
+        {
+            // Start the click in the same frame that we draw the flash.
+            frames = 0;
+            avsync_snapshot(&snapshot);
+            submit_us = avsync_clock();
+            audio_play_registered_sound(click, SPEAKER_LEFT | SPEAKER_RIGHT, 1.0);
+            phase = AVSYNC_FLASHED;
+
+            sprite_draw_box(0, 0, video_width(), video_height(), rgb(255, 255, 255));
+            return new_screen;
+        }
+    }
+
+    // Display instructions.
+    char *instructions[] = {
+        "A click plays with every white flash, about once a second.",
+        "Press service to clear the results.",
+        "",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    int top = CONTENT_VOFFSET;
+    if (click < 0)
+    {
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 0, 0), "Could not register the click sound!");
+    }
+    else if (results.count == 0)
+    {
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), "Waiting for the first click...");
+    }
+    else
+    {
+        int32_t low = results.offsets[0];
+        int32_t high = results.offsets[0];
+        int64_t total = 0;
+        for (unsigned int i = 0; i < results.count; i++)
+        {
+            low = min(low, results.offsets[i]);
+            high = max(high, results.offsets[i]);
+            total += results.offsets[i];
+        }
+
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), "Audio after video: %.02fms (last %.02fms)", (double)total / (double)results.count / 1000.0, (double)last_offset / 1000.0);
+        ta_draw_text(CONTENT_HOFFSET, top + 21, state->font_18pt, rgb(255, 255, 255), "Spread: %.02fms to %.02fms", (double)low / 1000.0, (double)high / 1000.0);
+        ta_draw_text(
+            CONTENT_HOFFSET,
+            top + 42,
+            state->font_12pt,
+            rgb(128, 128, 128),
+            "Last click submitted %.02fms before vblank, audio started %.02fms after submit.",
+            (double)last_lead / 1000.0,
+            (double)last_latency / 1000.0
+        );
+        ta_draw_text(
+            CONTENT_HOFFSET,
+            top + 56,
+            state->font_12pt,
+            rgb(128, 128, 128),
+            "%d clicks measured, %d never seen, %d early, %d late.",
+            results.count,
+            results.missed,
+            results.under,
+            results.over
+        );
+
+        // Draw the distribution, scaled so the busiest bucket fills the graph.
+        unsigned int busiest = 1;
+        for (int i = 0; i < AVSYNC_BUCKETS; i++)
+        {
+            busiest = max(busiest, results.buckets[i]);
+        }
+
+        int graphtop = top + 84;
+        int graphheight = 120;
+        int barwidth = 8;
+        int zero = CONTENT_HOFFSET + ((-AVSYNC_LOWEST_US / AVSYNC_BUCKET_US) * barwidth);
+        sprite_draw_box(CONTENT_HOFFSET, graphtop, CONTENT_HOFFSET + (AVSYNC_BUCKETS * barwidth), graphtop + graphheight, rgb(32, 32, 32));
+        sprite_draw_box(zero, graphtop, zero + 1, graphtop + graphheight, rgb(255, 255, 0));
+        for (int i = 0; i < AVSYNC_BUCKETS; i++)
         {
-            case 0x0:
+            if (results.buckets[i] == 0)
             {
-                ta_draw_text(CONTENT_HOFFSET + 240, CONTENT_VOFFSET + (24 * i), state->font_18pt, rgb(0, 255, 0), "PASSED");
-                break;
+                continue;
             }
-            case 0xFFFFFFFF:
+
+            int height = max(1, (results.buckets[i] * graphheight) / busiest);
+            int left = CONTENT_HOFFSET + (i * barwidth);
+            sprite_draw_box(left, graphtop + graphheight - height, left + barwidth - 1, graphtop + graphheight, rgb(0, 255, 0));
+        }
+
+        ta_draw_text(CONTENT_HOFFSET, graphtop + graphheight + 4, state->font_12pt, rgb(128, 128, 128), "%dms", AVSYNC_LOWEST_US / 1000);
+        ta_draw_text(zero - 8, graphtop + graphheight + 4, state->font_12pt, rgb(255, 255, 0), "0ms");
+        ta_draw_text(
+            CONTENT_HOFFSET + (AVSYNC_BUCKETS * barwidth) - 40,
+            graphtop + graphheight + 4,
+            state->font_12pt,
+            rgb(128, 128, 128),
+            "+%dms",
+            (AVSYNC_LOWEST_US + (AVSYNC_BUCKETS * AVSYNC_BUCKET_US)) / 1000
+        );
+    }
+
+    if (new_screen != SCREEN_AVSYNC_TESTS)
+    {
+        if (click >= 0)
+        {
+            audio_stop_registered_sound(click);
+            audio_unregister_sound(click);
+            click = -1;
+        }
+        avsync_clock_stop();
+    }
+
+    return new_screen;
+}
+
+// How many cycles each run can be set to.
+unsigned int eeprom_bench_cycles[] = {8, 32, 128};
+
+int eeprom_bench_poll(void *param)
+{
+    // Just like the EEPROM test, the worker checks controls for us in
+    // between requests since nothing else can use the maple bus meanwhile.
+    controls_t controls = get_controls((state_t *)param, 0, COMBINED_CONTROLS);
+    return controls.test_pressed || controls.start_pressed;
+}
+
+void draw_eeprom_histogram(state_t *state, int left, int top, char *title, eeprombench_histogram_t *histogram, uint32_t slow_us)
+{
+    if (histogram->count == 0)
+    {
+        ta_draw_text(left, top, state->font_12pt, rgb(128, 128, 128), "%s: none yet", title);
+    }
+    else
+    {
+        ta_draw_text(
+            left,
+            top,
+            state->font_12pt,
+            histogram->max_us > slow_us ? rgb(255, 0, 0) : rgb(255, 255, 255),
+            "%s: %d, %.02f/%.02f/%.02fms",
+            title,
+            histogram->count,
+            (double)histogram->min_us / 1000.0,
+            (double)histogram->total_us / (double)histogram->count / 1000.0,
+            (double)histogram->max_us / 1000.0
+        );
+    }
+
+    // Scale the graph so that the busiest bucket fills it.
+    unsigned int busiest = 1;
+    for (int i = 0; i < EEPROMBENCH_BUCKETS; i++)
+    {
+        busiest = max(busiest, histogram->buckets[i]);
+    }
+
+    int graphtop = top + 16;
+    int graphheight = 60;
+    int barwidth = 18;
+    sprite_draw_box(left, graphtop, left + (EEPROMBENCH_BUCKETS * barwidth), graphtop + graphheight, rgb(32, 32, 32));
+    for (int i = 0; i < EEPROMBENCH_BUCKETS; i++)
+    {
+        if (histogram->buckets[i] == 0)
+        {
+            continue;
+        }
+
+        int height = max(1, (histogram->buckets[i] * graphheight) / busiest);
+        int barleft = left + (i * barwidth);
+        sprite_draw_box(barleft, graphtop + graphheight - height, barleft + barwidth - 2, graphtop + graphheight, rgb(0, 255, 0));
+    }
+
+    ta_draw_text(left, graphtop + graphheight + 2, state->font_12pt, rgb(128, 128, 128), "<%.01fms", (double)EEPROMBENCH_BUCKET_BASE_US / 1000.0);
+    ta_draw_text(
+        left + (EEPROMBENCH_BUCKETS * barwidth) - 48,
+        graphtop + graphheight + 2,
+        state->font_12pt,
+        rgb(128, 128, 128),
+        "%dms+",
+        (EEPROMBENCH_BUCKET_BASE_US << (EEPROMBENCH_BUCKETS - 2)) / 1000
+    );
+}
+
+unsigned int eeprom_bench_tests(state_t *state, int reinit)
+{
+    // The run we're on or last finished, and how long runs should be.
+    static eeprom_bench_t *bench = NULL;
+    static int choice = 1;
+    int choices = sizeof(eeprom_bench_cycles) / sizeof(eeprom_bench_cycles[0]);
+
+    // Whether the last run couldn't start for lack of main RAM.
+    static unsigned int nomemory = 0;
+
+    if (reinit)
+    {
+        if (bench != NULL)
+        {
+            end_eeprom_bench(bench);
+            bench = NULL;
+        }
+
+        choice = 1;
+        nomemory = 0;
+    }
+
+    // If we need to switch screens.
+    unsigned int new_screen = SCREEN_EEPROM_BENCH;
+
+    // Keep our own copy of the results, since we show them after the run.
+    static eeprom_bench_t published;
+    unsigned int running = 0;
+    if (bench != NULL)
+    {
+        unsigned int jobstate = job_state(&bench->job);
+        running = jobstate == JOB_PENDING || jobstate == JOB_RUNNING;
+        job_read(&bench->job, &published, bench, sizeof(published));
+    }
+
+    // The worker is watching the controls while it owns the maple bus. When
+    // asked to leave, it still has to wait out stuck requests and restore the
+    // original contents, so keep drawing those until it is done.
+    if (!running)
+    {
+        controls_t controls = get_controls(state, reinit, COMBINED_CONTROLS);
+
+        if ((bench != NULL && published.exit) || controls.test_pressed || controls.start_pressed)
+        {
+            // Exit out of the EEPROM benchmark screen.
+            new_screen = SCREEN_MAIN_MENU;
+        }
+        else if (controls.right_pressed || controls.left_pressed)
+        {
+            // Pick a different run length for next time.
+            audio_play_registered_sound(state->sounds.scroll, SPEAKER_LEFT | SPEAKER_RIGHT, 1.0);
+
+            choice += controls.left_pressed ? -1 : 1;
+            if (choice < 0) { choice = choices - 1; }
+            if (choice >= choices) { choice = 0; }
+        }
+        else if (controls.service_pressed)
+        {
+            // Start a new run, throwing away the results of the last one.
+            if (bench != NULL)
             {
-                ta_draw_text(CONTENT_HOFFSET + 240, CONTENT_VOFFSET + (24 * i), state->font_18pt, rgb(255, 255, 0), "RUNNING");
-                break;
+                end_eeprom_bench(bench);
             }
-            default:
-            {
-                ta_draw_text(CONTENT_HOFFSET + 240, CONTENT_VOFFSET + (24 * i), state->font_18pt, rgb(255, 0, 0), "FAILED AT 0x%08X", results[i]);
+
+            bench = start_eeprom_bench(eeprom_bench_cycles[choice], eeprom_bench_poll, state);
+            nomemory = bench == NULL;
+            running = bench != NULL;
+            memset(&published, 0, sizeof(published));
+            published.state = EEPROMBENCH_STATE_READING;
+        }
+    }
+
+    // Display instructions.
+    char *instructions[] = {
+        "Use digital joystick left/right to pick how many cycles to run.",
+        "Press service to start a run.",
+        "",
+        "Press either start or test to exit.",
+    };
+
+    for (int i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        font_metrics_t metrics = font_get_text_metrics(state->font_12pt, instructions[i]);
+        ta_draw_text((video_width() - metrics.width) / 2, 22 + (14 * i), state->font_12pt, rgb(255, 255, 255), instructions[i]);
+    }
+
+    unsigned int cycles = eeprom_bench_cycles[choice];
+    ta_draw_text(
+        CONTENT_HOFFSET,
+        CONTENT_VOFFSET,
+        state->font_18pt,
+        rgb(255, 255, 255),
+        "Cycles per run: %d (%d writes, %d reads)",
+        cycles,
+        cycles,
+        cycles * EEPROMBENCH_READS_PER_CYCLE
+    );
+
+    int top = CONTENT_VOFFSET + 21;
+    if (bench == NULL && nomemory)
+    {
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 0, 0), "Not enough free main RAM to start a run!");
+    }
+    else if (bench == NULL)
+    {
+        ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 255), "Press service to start.");
+    }
+    else
+    {
+        switch(published.state)
+        {
+            case EEPROMBENCH_STATE_READING:
+                ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 0), "Reading original contents...");
                 break;
-            }
+            case EEPROMBENCH_STATE_CYCLING:
+                ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 0), "Running cycle %d of %d...", min(bench->job.progress + 1, published.cycles), published.cycles);
+                break;
+            case EEPROMBENCH_STATE_SETTLING:
+                ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 0), "Waiting for a stuck request to finish...");
+                break;
+            case EEPROMBENCH_STATE_RESTORING:
+                ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 255, 0), "Restoring original contents...");
+                break;
+            case EEPROMBENCH_STATE_FINISHED:
+                ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(0, 255, 0), "Finished after %d of %d cycles.", bench->job.progress, published.cycles);
+                break;
+            case EEPROMBENCH_STATE_NO_ORIGINAL:
+                ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 0, 0), "Could not read the EEPROM reliably, nothing written.");
+                break;
+            case EEPROMBENCH_STATE_NO_WRITES_LEFT:
+                ta_draw_text(CONTENT_HOFFSET, top, state->font_18pt, rgb(255, 0, 0), "Write limit reached for this boot, nothing written.");
+                break;
+        }
+
+        draw_eeprom_histogram(state, CONTENT_HOFFSET, top + 28, "Reads", &published.reads, EEPROMBENCH_SLOW_READ_US);
+        draw_eeprom_histogram(state, CONTENT_HOFFSET + 270, top + 28, "Writes", &published.writes, EEPROMBENCH_SLOW_WRITE_US);
+
+        unsigned int problems = published.mismatches + published.failures + published.timeouts;
+        ta_draw_text(
+            CONTENT_HOFFSET,
+            top + 140,
+            state->font_12pt,
+            problems ? rgb(255, 0, 0) : rgb(128, 128, 128),
+            "%d patterns read back wrong, %d requests failed, %d timed out.",
+            published.mismatches,
+            published.failures,
+            published.timeouts
+        );
+
+        if (published.restore == EEPROMBENCH_RESTORE_OK)
+        {
+            ta_draw_text(CONTENT_HOFFSET, top + 156, state->font_18pt, rgb(0, 255, 0), "Original restored, CRC32 %08X verified.", published.crcbefore);
+        }
+        else if (published.restore == EEPROMBENCH_RESTORE_FAILED)
+        {
+            ta_draw_text(CONTENT_HOFFSET, top + 156, state->font_18pt, rgb(255, 0, 0), "Restore FAILED! Wanted CRC32 %08X, got %08X.", published.crcbefore, published.crcafter);
+        }
+        else if (published.restore == EEPROMBENCH_RESTORE_UNVERIFIED)
+        {
+            ta_draw_text(CONTENT_HOFFSET, top + 156, state->font_18pt, rgb(255, 0, 0), "Restore UNVERIFIED! A stuck request never finished.");
+        }
+        else if (published.restore == EEPROMBENCH_RESTORE_UNTOUCHED)
+        {
+            ta_draw_text(CONTENT_HOFFSET, top + 156, state->font_18pt, rgb(255, 255, 255), "EEPROM contents were not changed.");
+        }
+        else if (running && published.exit)
+        {
+            ta_draw_text(CONTENT_HOFFSET, top + 156, state->font_18pt, rgb(255, 255, 0), "Stopping, leaving once the original contents are back...");
         }
     }
 
-    if (new_screen != SCREEN_SRAM_TESTS)
+    ta_draw_text(
+        CONTENT_HOFFSET,
+        top + 184,
+        state->font_12pt,
+        rgb(128, 128, 128),
+        "%d writes this run, %d of %d allowed writes used since boot.",
+        bench != NULL ? published.written : 0,
+        eeprombench_total_writes(),
+        EEPROMBENCH_MAX_WRITES
+    );
+    ta_draw_text(CONTENT_HOFFSET, top + 198, state->font_12pt, rgb(128, 128, 128), "Figures in red are slower than a healthy IO board should ever be.");
+
+    if (new_screen != SCREEN_EEPROM_BENCH)
     {
-        end_memory_test(test);
-        test = 0;
+        if (bench != NULL)
+        {
+            end_eeprom_bench(bench);
+            bench = NULL;
+        }
     }
 
     return new_screen;
@@ -1898,6 +4495,26 @@ void draw_screen(state_t *state)
     static unsigned int curscreen = SCREEN_MAIN_MENU;
     static unsigned int oldscreen = -1;
 
+    // If we were asked to check SRAM retention, go straight to the results.
+    static unsigned int firstdraw = 1;
+    if (firstdraw)
+    {
+        firstdraw = 0;
+        if (state->retention.found)
+        {
+            // Leave the cursor on the retention test for when we get back.
+            for (unsigned int e = 0; e < sizeof(entries) / sizeof(entries[0]); e++)
+            {
+                if (entries[e].screen == SCREEN_RETENTION_TESTS)
+                {
+                    main_selected_entry = e;
+                    break;
+                }
+            }
+            curscreen = SCREEN_RETENTION_TESTS;
+        }
+    }
+
     // The screen we are requested to go to next.
     unsigned int newscreen;
 
@@ -1905,6 +4522,11 @@ void draw_screen(state_t *state)
     {
         case SCREEN_MAIN_MENU:
         {
+            if (curscreen != oldscreen)
+            {
+                screen_assets = ASSET_MENU;
+                assets_require(state, screen_assets);
+            }
             newscreen = main_menu(state, curscreen != oldscreen);
             break;
         }
@@ -1915,6 +4537,11 @@ void draw_screen(state_t *state)
             {
                 if (entries[e].screen == curscreen)
                 {
+                    if (curscreen != oldscreen)
+                    {
+                        screen_assets = entries[e].assets;
+                        assets_require(state, screen_assets);
+                    }
                     newscreen = entries[e].func(state, curscreen != oldscreen);
                     found = 1;
                     break;
@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <naomi/audio.h>
+#include "common.h"
+#include "state.h"
+#include "sounds.h"
+#include "pack.h"
+#include "boottrace.h"
+
+// Some of the packed sounds are stored as the AICA's 4-bit ADPCM, which
+// we can't play back without a driver that knows about it.
+#ifndef AUDIO_FORMAT_4BIT
+#error "This libnaomi has no AUDIO_FORMAT_4BIT, update it to one that can play ADPCM sounds!"
+#endif
+
+int sounds_format(uint32_t format)
+{
+    switch (format)
+    {
+        case PACK_SOUND_PCM16:
+            return AUDIO_FORMAT_16BIT;
+        case PACK_SOUND_ADPCM:
+            return AUDIO_FORMAT_4BIT;
+        default:
+            return -1;
+    }
+}
+
+int sounds_register(const char *name, int samplerate)
+{
+    // The driver copies the samples into sound RAM, so we only need them
+    // long enough to register the sound. The pack knows whether they were
+    // stored as 16-bit PCM or ADPCM.
+    const pack_entry_t *entry = pack_find(name);
+    if (entry == NULL)
+    {
+        return -1;
+    }
+
+    int format = sounds_format(entry->format);
+    if (format < 0)
+    {
+        return -1;
+    }
+
+    int step = boottrace_start("inflate %s", name);
+    void *data = pack_load(name, NULL);
+    boottrace_end(step);
+    if (data == NULL)
+    {
+        return -1;
+    }
+
+    step = boottrace_start("register %s", name);
+    int sound = audio_register_sound(format, samplerate, data, entry->width);
+    boottrace_end(step);
+    free(data);
+    return sound;
+}
+
+void sounds_init(sounds_t *sounds)
+{
+    // Init audio system for audio test subsystem.
+    int step = boottrace_start("audio_init");
+    audio_init();
+    boottrace_end(step);
+
+    // Initialize some system sounds.
+    sounds->scroll = sounds_register("scroll.raw", 44100);
+    sounds->scale = sounds_register("scale.raw", 11025);
+    audio_set_registered_sound_loop(sounds->scale, 0);
+}
+
+void sounds_suspend(sounds_t *sounds)
+{
+    // Make sure nothing is mid-playback when the driver goes away.
+    audio_stop_registered_sound(sounds->scroll);
+    audio_stop_registered_sound(sounds->scale);
+
+    // This halts the AICA and throws away every registered sound.
+    audio_free();
+    sounds->scroll = -1;
+    sounds->scale = -1;
+}
+
+void sounds_resume(sounds_t *sounds)
+{
+    // The driver gets reloaded from scratch, so everything we had in sound
+    // RAM must be registered again.
+    sounds_init(sounds);
+}
@@ -0,0 +1,23 @@
+#ifndef __SOUNDS_H
+#define __SOUNDS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <naomi/audio.h>
+#include "state.h"
+
+// Start the audio driver and register every sound the menus use.
+void sounds_init(sounds_t *sounds);
+
+// Stop all playback and shut down the audio driver, so that nothing but
+// us touches sound RAM until sounds_resume() is called.
+void sounds_suspend(sounds_t *sounds);
+void sounds_resume(sounds_t *sounds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
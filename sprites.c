@@ -0,0 +1,87 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <naomi/system.h>
+#include <naomi/ta.h>
+#include "common.h"
+#include "state.h"
+#include "sprites.h"
+#include "pack.h"
+
+// The same memory as addr, but bypassing the cache.
+#define SPRITE_UNCACHED(addr) (((addr) & 0x1FFFFFFF) | 0xA0000000)
+
+void sprite_sink(void *param, unsigned int offset, uint8_t *data, unsigned int len)
+{
+    uint32_t *dest = (uint32_t *)((uint8_t *)param + offset);
+    if (hw_memcpy(dest, data, (len + 3) & ~3) != 0)
+    {
+        // Fall back to copying it ourselves, a word at a time since VRAM
+        // can't take byte writes.
+        for (unsigned int i = 0; i < (len + 3) / 4; i++)
+        {
+            dest[i] = ((uint32_t *)data)[i];
+        }
+    }
+}
+
+texture_description_t *sprite_load(const char *name)
+{
+    const pack_entry_t *entry = pack_find(name);
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+
+    if (entry->format == SPRITE_FORMAT_LINEAR)
+    {
+        // Let libnaomi twiddle it for us as it goes into VRAM.
+        void *data = pack_load(name, NULL);
+        if (data == NULL)
+        {
+            return NULL;
+        }
+
+        texture_description_t *desc = ta_texture_desc_malloc_direct(entry->width, data, TA_TEXTUREMODE_ARGB1555);
+        free(data);
+        return desc;
+    }
+
+    // Already in the layout the PowerVR wants, so we only need enough VRAM
+    // to inflate it into. VQ textures don't match the size of any plain
+    // texture, so use the smallest allocation they fit in.
+    unsigned int allocuv = entry->width;
+    int bitsize = 4;
+    while (((allocuv * allocuv * bitsize) / 8) < entry->size)
+    {
+        if (bitsize < 16)
+        {
+            bitsize *= 2;
+        }
+        else
+        {
+            allocuv *= 2;
+            bitsize = 4;
+        }
+    }
+
+    void *vram = ta_texture_malloc(allocuv, bitsize);
+    if (vram == NULL)
+    {
+        return NULL;
+    }
+
+    if (pack_stream(entry, sprite_sink, (void *)SPRITE_UNCACHED((uint32_t)vram)) != 0)
+    {
+        ta_texture_free(vram);
+        return NULL;
+    }
+
+    texture_description_t *desc = malloc(sizeof(texture_description_t));
+    desc->vram_location = vram;
+    desc->width = entry->width;
+    desc->height = entry->width;
+    desc->texture_mode = TA_TEXTUREMODE_ARGB1555 | (entry->format == SPRITE_FORMAT_VQ ? TA_TEXTUREMODE_VQ : 0);
+    desc->vram_owned = 1;
+    return desc;
+}
@@ -0,0 +1,29 @@
+#ifndef __SPRITES_H
+#define __SPRITES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "state.h"
+
+// How each sprite was laid out by tools/texconv.py at build time.
+#define SPRITE_FORMAT_LINEAR 0
+#define SPRITE_FORMAT_TWIDDLED 1
+#define SPRITE_FORMAT_VQ 2
+
+// The texture control word bit that tells the PowerVR a texture is VQ
+// compressed, in case libnaomi doesn't give us one.
+#ifndef TA_TEXTUREMODE_VQ
+#define TA_TEXTUREMODE_VQ 0x40000000
+#endif
+
+// Inflate a sprite out of the asset pack and into VRAM, returning a texture
+// that can be drawn like any other. Returns NULL if it can't be loaded.
+texture_description_t *sprite_load(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
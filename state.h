@@ -9,6 +9,7 @@ extern "C" {
 #include <naomi/eeprom.h>
 #include <naomi/video.h>
 #include <naomi/ta.h>
+#include "retention.h"
 
 typedef struct
 {
@@ -36,6 +37,7 @@ typedef struct
     font_t *font_mono;
     sprites_t sprites;
     sounds_t sounds;
+    retention_result_t retention;
 } state_t;
 
 #ifdef __cplusplus
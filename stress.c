@@ -0,0 +1,344 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <naomi/timer.h>
+#include "common.h"
+#include "memtest.h"
+#include "stress.h"
+
+// How much work each kernel does per round. These are sized so that a
+// round takes a few milliseconds, which keeps us responsive to being stopped.
+#define STRESS_INTEGER_ITERATIONS (256 * 1024)
+#define STRESS_FPU_REPEATS 256
+#define STRESS_VECTOR_REPEATS 64
+#define STRESS_CACHE_PASSES 16
+
+// The cache kernel walks a buffer four times the size of the operand cache,
+// jumping just over a cache's worth of lines each step so that every access
+// evicts a line that has just been dirtied.
+#define STRESS_CACHE_SIZE (64 * 1024)
+#define STRESS_CACHE_LINE 32
+#define STRESS_CACHE_STRIDE 513
+
+// Known answers for the integer and cache kernels, computed ahead of time.
+#define STRESS_INTEGER_ANSWER 0x98872BCE
+#define STRESS_CACHE_ANSWER 0x9A8B4158
+
+// Each kernel works on the values 0.0, 0.5, 1.0 ... 127.5, chosen so that
+// every sum the scalar kernel makes is exactly representable.
+#define STRESS_TABLE_SIZE 256
+
+// The vector kernels have less precision than IEEE, so how far off their
+// answers may be, as a fraction of the answer.
+#define STRESS_VECTOR_TOLERANCE (1.0f / (1 << 18))
+
+#if defined(__SH4__) || defined(__SH4_SINGLE_ONLY__)
+static inline float fipr(float x, float y, float z, float w, float a, float b, float c, float d)
+{
+    // Dot product of FV0 and FV4 in a single instruction, landing in FR3.
+    register float fr0 __asm__("fr0") = x;
+    register float fr1 __asm__("fr1") = y;
+    register float fr2 __asm__("fr2") = z;
+    register float fr3 __asm__("fr3") = w;
+    register float fr4 __asm__("fr4") = a;
+    register float fr5 __asm__("fr5") = b;
+    register float fr6 __asm__("fr6") = c;
+    register float fr7 __asm__("fr7") = d;
+
+    __asm__ volatile (
+        "fipr fv4, fv0\n"
+        : "+f" (fr3)
+        : "f" (fr0), "f" (fr1), "f" (fr2), "f" (fr4), "f" (fr5), "f" (fr6), "f" (fr7)
+    );
+
+    return fr3;
+}
+
+static inline void load_xmtrx(const float *matrix)
+{
+    // Load a row-major 4x4 matrix into the back bank, where FTRV expects it.
+    __asm__ volatile (
+        "frchg\n"
+        "fmov.s @%0+, fr0\n"
+        "fmov.s @%0+, fr4\n"
+        "fmov.s @%0+, fr8\n"
+        "fmov.s @%0+, fr12\n"
+        "fmov.s @%0+, fr1\n"
+        "fmov.s @%0+, fr5\n"
+        "fmov.s @%0+, fr9\n"
+        "fmov.s @%0+, fr13\n"
+        "fmov.s @%0+, fr2\n"
+        "fmov.s @%0+, fr6\n"
+        "fmov.s @%0+, fr10\n"
+        "fmov.s @%0+, fr14\n"
+        "fmov.s @%0+, fr3\n"
+        "fmov.s @%0+, fr7\n"
+        "fmov.s @%0+, fr11\n"
+        "fmov.s @%0+, fr15\n"
+        "frchg\n"
+        : "+r" (matrix)
+        :
+        : "fr0", "fr1", "fr2", "fr3", "fr4", "fr5", "fr6", "fr7",
+          "fr8", "fr9", "fr10", "fr11", "fr12", "fr13", "fr14", "fr15", "memory"
+    );
+}
+
+static inline void ftrv(const float *matrix, float *vec)
+{
+    // Transform FV0 by the back bank matrix in a single instruction.
+    register float fr0 __asm__("fr0") = vec[0];
+    register float fr1 __asm__("fr1") = vec[1];
+    register float fr2 __asm__("fr2") = vec[2];
+    register float fr3 __asm__("fr3") = vec[3];
+
+    __asm__ volatile (
+        "ftrv xmtrx, fv0\n"
+        : "+f" (fr0), "+f" (fr1), "+f" (fr2), "+f" (fr3)
+    );
+
+    vec[0] = fr0;
+    vec[1] = fr1;
+    vec[2] = fr2;
+    vec[3] = fr3;
+}
+#else
+// Plain versions for building the kernels anywhere other than an SH-4.
+static inline float fipr(float x, float y, float z, float w, float a, float b, float c, float d)
+{
+    return (x * a) + (y * b) + (z * c) + (w * d);
+}
+
+static inline void load_xmtrx(const float *matrix)
+{
+    // The plain ftrv() reads the matrix directly.
+}
+
+static inline void ftrv(const float *matrix, float *vec)
+{
+    float out[4];
+    for (int row = 0; row < 4; row++)
+    {
+        out[row] = (matrix[row * 4 + 0] * vec[0]) + (matrix[row * 4 + 1] * vec[1]) + (matrix[row * 4 + 2] * vec[2]) + (matrix[row * 4 + 3] * vec[3]);
+    }
+    memcpy(vec, out, sizeof(out));
+}
+#endif
+
+int stress_integer(uint64_t *ops)
+{
+    // A dependent chain of shifts, multiplies and adds, which keeps both
+    // integer pipelines fed and can't be reordered out from under us.
+    uint32_t x = 0x12345678;
+    uint32_t acc = 0;
+    for (unsigned int i = 0; i < STRESS_INTEGER_ITERATIONS; i++)
+    {
+        x = xorshift32(x);
+        acc = (acc * 33) ^ (x + i);
+    }
+
+    // Six for the xorshift, three for the accumulate.
+    *ops = (uint64_t)STRESS_INTEGER_ITERATIONS * 9;
+    return (acc ^ x) == STRESS_INTEGER_ANSWER;
+}
+
+int stress_fpu(float *table, uint64_t *ops)
+{
+    // Four independent multiply-accumulate chains, so the FPU pipeline stays
+    // full. Loading the multiplier from memory stops it being folded away.
+    volatile float unity = 1.0f;
+    float one = unity;
+    float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f, a3 = 0.0f;
+
+    for (unsigned int rep = 0; rep < STRESS_FPU_REPEATS; rep++)
+    {
+        for (unsigned int i = 0; i < STRESS_TABLE_SIZE; i += 4)
+        {
+            a0 = (a0 * one) + table[i + 0];
+            a1 = (a1 * one) + table[i + 1];
+            a2 = (a2 * one) + table[i + 2];
+            a3 = (a3 * one) + table[i + 3];
+        }
+    }
+
+    // Every partial sum is a multiple of 0.5 well under 2^23, so this is exact.
+    float expected = (float)STRESS_FPU_REPEATS * ((STRESS_TABLE_SIZE - 1) * STRESS_TABLE_SIZE / 4);
+    *ops = (uint64_t)STRESS_FPU_REPEATS * STRESS_TABLE_SIZE * 2;
+    return (a0 + a1 + a2 + a3) == expected;
+}
+
+int stress_vector(float *table, uint64_t *ops)
+{
+    static const float matrix[16] = {
+        1.0f, 2.0f, 0.0f, 1.0f,
+        0.0f, 1.0f, 3.0f, 0.0f,
+        2.0f, 0.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 1.0f, 4.0f,
+    };
+
+    float dot = 0.0f;
+    float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    load_xmtrx(matrix);
+    for (unsigned int rep = 0; rep < STRESS_VECTOR_REPEATS; rep++)
+    {
+        for (unsigned int i = 0; i < STRESS_TABLE_SIZE; i += 4)
+        {
+            dot += fipr(1.0f, 2.0f, 3.0f, 4.0f, table[i + 0], table[i + 1], table[i + 2], table[i + 3]);
+
+            float vec[4] = { table[i + 0], table[i + 1], table[i + 2], table[i + 3] };
+            ftrv(matrix, vec);
+            sum[0] += vec[0];
+            sum[1] += vec[1];
+            sum[2] += vec[2];
+            sum[3] += vec[3];
+        }
+    }
+
+    // Both of these are linear, so the answer is the same operation applied
+    // once to the column sums of the table, which we can get exactly.
+    float columns[4];
+    for (int col = 0; col < 4; col++)
+    {
+        // The sum of (4k + col) / 2 for every row k of the table.
+        unsigned int rows = STRESS_TABLE_SIZE / 4;
+        columns[col] = (float)STRESS_VECTOR_REPEATS * (float)((4 * (rows * (rows - 1) / 2)) + (col * rows)) / 2.0f;
+    }
+
+    float expected[5];
+    expected[0] = (1.0f * columns[0]) + (2.0f * columns[1]) + (3.0f * columns[2]) + (4.0f * columns[3]);
+    for (int row = 0; row < 4; row++)
+    {
+        expected[row + 1] = 0.0f;
+        for (int col = 0; col < 4; col++)
+        {
+            expected[row + 1] += matrix[row * 4 + col] * columns[col];
+        }
+    }
+
+    float actual[5] = { dot, sum[0], sum[1], sum[2], sum[3] };
+    int ok = 1;
+    for (int i = 0; i < 5; i++)
+    {
+        float diff = actual[i] - expected[i];
+        if (diff < 0.0f) { diff = -diff; }
+        if (diff > expected[i] * STRESS_VECTOR_TOLERANCE)
+        {
+            ok = 0;
+        }
+    }
+
+    // Seven for each FIPR plus its accumulate, 28 for each FTRV plus four accumulates.
+    *ops = (uint64_t)STRESS_VECTOR_REPEATS * (STRESS_TABLE_SIZE / 4) * (8 + 32);
+    return ok;
+}
+
+int stress_cache(uint32_t *buffer, uint64_t *ops)
+{
+    unsigned int words = STRESS_CACHE_SIZE / 4;
+    unsigned int lines = STRESS_CACHE_SIZE / STRESS_CACHE_LINE;
+    unsigned int perline = STRESS_CACHE_LINE / 4;
+
+    for (unsigned int i = 0; i < words; i++)
+    {
+        buffer[i] = i;
+    }
+
+    // Read-modify-write one word per line, in an order where each access
+    // lands on the same cache set as one we dirtied moments ago.
+    for (unsigned int pass = 0; pass < STRESS_CACHE_PASSES; pass++)
+    {
+        unsigned int line = 0;
+        for (unsigned int i = 0; i < lines; i++)
+        {
+            uint32_t *word = &buffer[(line * perline) + (i % perline)];
+            *word = (*word * 3) + pass;
+            line = (line + STRESS_CACHE_STRIDE) % lines;
+        }
+    }
+
+    uint32_t acc = 0;
+    for (unsigned int i = 0; i < words; i++)
+    {
+        acc = (acc << 1 | acc >> 31) ^ buffer[i];
+    }
+
+    *ops = (uint64_t)STRESS_CACHE_PASSES * lines;
+    return acc == STRESS_CACHE_ANSWER;
+}
+
+unsigned int stress_thread(void *param)
+{
+    stress_test_t *stress = (stress_test_t *)param;
+
+    /* First, set up the inputs every kernel works from. */
+    uint64_t burnin_us = (stress->burnin == STRESS_FOREVER) ? UINT64_MAX : (uint64_t)stress->burnin * 1000000;
+
+    float table[STRESS_TABLE_SIZE];
+    for (int i = 0; i < STRESS_TABLE_SIZE; i++)
+    {
+        table[i] = (float)i / 2.0f;
+    }
+    uint32_t *buffer = malloc(STRESS_CACHE_SIZE);
+
+    /* Now, run each kernel in turn until we've gone long enough. */
+    uint64_t elapsed_us = 0;
+    do
+    {
+        for (int kernel = 0; kernel < STRESS_KERNELS; kernel++)
+        {
+            if (job_cancelled(&stress->job))
+            {
+                free(buffer);
+                return JOB_CANCELLED;
+            }
+
+            uint64_t ops = 0;
+            int ok = 0;
+            int profile = profile_start();
+            switch(kernel)
+            {
+                case STRESS_KERNEL_INTEGER:
+                    ok = stress_integer(&ops);
+                    break;
+                case STRESS_KERNEL_FPU:
+                    ok = stress_fpu(table, &ops);
+                    break;
+                case STRESS_KERNEL_VECTOR:
+                    ok = stress_vector(table, &ops);
+                    break;
+                case STRESS_KERNEL_CACHE:
+                    ok = stress_cache(buffer, &ops);
+                    break;
+            }
+            uint32_t round_us = max(profile_end(profile), 1);
+            elapsed_us += round_us;
+
+            job_publish_begin(&stress->job);
+            stress->rounds[kernel]++;
+            stress->errors[kernel] += ok ? 0 : 1;
+            stress->kops[kernel] = (uint32_t)((ops * 1000) / round_us);
+            stress->elapsed_us = elapsed_us;
+            job_publish_end(&stress->job);
+        }
+    } while (elapsed_us < burnin_us);
+
+    /* Finally, let the UI know we've finished. */
+    free(buffer);
+    return JOB_FINISHED;
+}
+
+stress_test_t *start_stress_test(unsigned int burnin)
+{
+    stress_test_t *stress = malloc(sizeof(stress_test_t));
+    memset(stress, 0, sizeof(stress_test_t));
+    stress->burnin = burnin;
+    job_start(&stress->job, stress_thread, stress, JOB_NO_TIMEOUT);
+    return stress;
+}
+
+void end_stress_test(stress_test_t *stress)
+{
+    // Ask the worker to stop after its current round and wait for it.
+    job_end(&stress->job);
+    free(stress);
+}
@@ -0,0 +1,50 @@
+#ifndef __STRESS_H
+#define __STRESS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "jobs.h"
+
+// The kernels we run, in the order we run them.
+#define STRESS_KERNEL_INTEGER 0
+#define STRESS_KERNEL_FPU 1
+#define STRESS_KERNEL_VECTOR 2
+#define STRESS_KERNEL_CACHE 3
+#define STRESS_KERNELS 4
+
+// Burn-in length that never ends on its own.
+#define STRESS_FOREVER 0xFFFFFFFF
+
+typedef struct
+{
+    // How long to keep going in seconds, or zero for a single pass.
+    unsigned int burnin;
+
+    // The worker running the kernels. Each kernel runs in short rounds and
+    // checks for cancellation in between them.
+    job_t job;
+
+    // How many rounds of each kernel have run, and how many of those came up
+    // with the wrong answer.
+    unsigned int rounds[STRESS_KERNELS];
+    unsigned int errors[STRESS_KERNELS];
+
+    // How fast the most recent round of each kernel went, in thousands of
+    // operations per second.
+    uint32_t kops[STRESS_KERNELS];
+
+    // How long we've been running, in microseconds.
+    uint64_t elapsed_us;
+} stress_test_t;
+
+stress_test_t *start_stress_test(unsigned int burnin);
+void end_stress_test(stress_test_t *stress);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
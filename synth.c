@@ -0,0 +1,288 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <naomi/audio.h>
+#include <naomi/thread.h>
+#include "common.h"
+#include "memtest.h"
+#include "synth.h"
+
+// How many stereo samples the ring buffer in sound RAM holds, and how many we
+// generate at once. The AICA plays one half of the ring while we refill the
+// other, so each chunk has to be well under half of it.
+#define SYNTH_RING_SAMPLES 8192
+#define SYNTH_CHUNK_SAMPLES 1024
+
+// The loudest we ever go, leaving a little headroom.
+#define SYNTH_PEAK 30000
+
+static int16_t sine_table[SYNTH_SINE_ENTRIES + 1];
+static int sine_ready = 0;
+
+void synth_init()
+{
+    if (sine_ready)
+    {
+        return;
+    }
+
+    // Rotate a unit vector around the circle one table step at a time. The
+    // step itself comes from a Taylor series so that we don't need libm.
+    double step = (2.0 * 3.14159265358979323846) / (double)SYNTH_SINE_ENTRIES;
+    double stepsq = step * step;
+    double stepcos = 1.0 - (stepsq / 2.0) + ((stepsq * stepsq) / 24.0) - ((stepsq * stepsq * stepsq) / 720.0);
+    double stepsin = step - ((step * stepsq) / 6.0) + ((step * stepsq * stepsq) / 120.0);
+    double c = 1.0;
+    double s = 0.0;
+
+    for (int i = 0; i <= SYNTH_SINE_ENTRIES; i++)
+    {
+        sine_table[i] = (int16_t)(s * 32767.0 + (s < 0 ? -0.5 : 0.5));
+
+        double nc = (c * stepcos) - (s * stepsin);
+        double ns = (s * stepcos) + (c * stepsin);
+        c = nc;
+        s = ns;
+    }
+
+    // The extra entry lets us interpolate past the end without wrapping.
+    sine_table[SYNTH_SINE_ENTRIES] = sine_table[0];
+    sine_ready = 1;
+}
+
+int32_t synth_sine(uint32_t phase)
+{
+    // Linearly interpolate between table entries.
+    uint32_t index = phase >> (32 - SYNTH_SINE_BITS);
+    int32_t frac = (phase >> (16 - SYNTH_SINE_BITS)) & 0xFFFF;
+    int32_t a = sine_table[index];
+    int32_t b = sine_table[index + 1];
+    return a + (((b - a) * frac) >> 16);
+}
+
+uint32_t synth_increment(unsigned int frequency)
+{
+    return (uint32_t)(((uint64_t)frequency << 32) / SYNTH_SAMPLERATE);
+}
+
+void synth_reset(synth_generator_t *gen, synth_params_t *params)
+{
+    synth_init();
+    memset(gen, 0, sizeof(*gen));
+    gen->seed = 0x2545F491;
+
+    if (params->signal == SYNTH_SWEEP)
+    {
+        // Each sample raises the frequency by the same ratio, which is the
+        // span of the sweep spread evenly in log space. With x = ln(span) / n,
+        // e^x = 1 + x + x^2/2 is plenty close when x is this small.
+        double octaves = 0.0;
+        for (unsigned int f = SYNTH_SWEEP_LOW; f < SYNTH_SWEEP_HIGH; f *= 2)
+        {
+            octaves += 1.0;
+        }
+        double x = (octaves * 0.69314718055994530942) / (double)(SYNTH_SWEEP_SECONDS * SYNTH_SAMPLERATE);
+        gen->sweepratio = (uint32_t)((1.0 + x + ((x * x) / 2.0)) * (double)(1 << 30));
+        gen->sweepstart = synth_increment(SYNTH_SWEEP_LOW);
+        gen->sweepend = synth_increment(SYNTH_SWEEP_HIGH);
+        gen->increment = gen->sweepstart;
+    }
+    else
+    {
+        gen->increment = synth_increment(params->frequency);
+    }
+}
+
+int32_t synth_white(synth_generator_t *gen)
+{
+    gen->seed = xorshift32(gen->seed);
+    return (int32_t)(gen->seed >> 16) - 32768;
+}
+
+int32_t synth_pink(synth_generator_t *gen)
+{
+    // Voss-McCartney: each row is redrawn half as often as the one before
+    // it, so summing them rolls off at 3dB per octave.
+    gen->counter++;
+    uint32_t counter = gen->counter;
+    int row = 0;
+    while (row < SYNTH_PINK_ROWS - 1 && (counter & 1) == 0)
+    {
+        counter >>= 1;
+        row++;
+    }
+
+    int32_t value = synth_white(gen) / SYNTH_PINK_ROWS;
+    gen->rowsum += value - gen->rows[row];
+    gen->rows[row] = value;
+
+    // Add one more white sample that changes every time to fill in the top.
+    return (gen->rowsum + (synth_white(gen) / SYNTH_PINK_ROWS)) * 2;
+}
+
+int32_t synth_pulse(synth_generator_t *gen)
+{
+    // A single positive half-sine, so that a correctly wired speaker cone
+    // visibly pushes out on every pulse.
+    unsigned int length = (SYNTH_SAMPLERATE / (1000000 / SYNTH_PULSE_US));
+    unsigned int period = (unsigned int)(((uint64_t)SYNTH_SAMPLERATE * SYNTH_PULSE_PERIOD_US) / 1000000);
+    int32_t value = 0;
+    if (gen->pulsepos < length)
+    {
+        value = synth_sine((uint32_t)(((uint64_t)gen->pulsepos << 31) / length));
+    }
+
+    gen->pulsepos++;
+    if (gen->pulsepos >= period)
+    {
+        gen->pulsepos = 0;
+    }
+    return value;
+}
+
+void synth_generate(synth_generator_t *gen, synth_params_t *params, int16_t *out, unsigned int samples)
+{
+    int32_t left = (params->speakers & SPEAKER_LEFT) ? params->level : 0;
+    int32_t right = (params->speakers & SPEAKER_RIGHT) ? params->level : 0;
+    if (params->invert & SPEAKER_LEFT)
+    {
+        left = -left;
+    }
+    if (params->invert & SPEAKER_RIGHT)
+    {
+        right = -right;
+    }
+
+    for (unsigned int i = 0; i < samples; i++)
+    {
+        int32_t value;
+        switch (params->signal)
+        {
+            case SYNTH_SINE:
+            {
+                value = synth_sine(gen->phase);
+                gen->phase += gen->increment;
+                break;
+            }
+            case SYNTH_SWEEP:
+            {
+                value = synth_sine(gen->phase);
+                gen->phase += gen->increment;
+                gen->increment = (uint32_t)(((uint64_t)gen->increment * gen->sweepratio) >> 30);
+                if (gen->increment >= gen->sweepend)
+                {
+                    gen->increment = gen->sweepstart;
+                }
+                break;
+            }
+            case SYNTH_WHITE_NOISE:
+            {
+                value = synth_white(gen);
+                break;
+            }
+            case SYNTH_PINK_NOISE:
+            {
+                value = synth_pink(gen);
+                break;
+            }
+            case SYNTH_PULSE:
+            {
+                value = synth_pulse(gen);
+                break;
+            }
+            default:
+            {
+                value = 0;
+                break;
+            }
+        }
+
+        // Scale down to leave headroom, then apply the level.
+        value = max(-32768, min(32767, value));
+        value = (value * SYNTH_PEAK) / 32768;
+        out[i * 2] = (int16_t)((value * left) / SYNTH_LEVEL_MAX);
+        out[(i * 2) + 1] = (int16_t)((value * right) / SYNTH_LEVEL_MAX);
+    }
+}
+
+unsigned int synth_thread(void *param)
+{
+    synth_t *synth = (synth_t *)param;
+    synth_generator_t gen;
+    synth_params_t params;
+    int16_t *chunk = malloc(SYNTH_CHUNK_SAMPLES * 4);
+    if (chunk == NULL)
+    {
+        return JOB_FAILED;
+    }
+
+    job_read_request(&synth->job, &params, &synth->params, sizeof(params));
+    synth_reset(&gen, &params);
+
+    while (!job_cancelled(&synth->job))
+    {
+        /* First, pick up any changes the UI made. Level, speaker and
+           inversion changes take effect on the next chunk without
+           restarting the signal. */
+        synth_params_t previous = params;
+        job_read_request(&synth->job, &params, &synth->params, sizeof(params));
+
+        if (params.signal != previous.signal || params.frequency != previous.frequency)
+        {
+            synth_reset(&gen, &params);
+        }
+
+        /* Now, generate a chunk and feed it to the ring buffer as room frees
+           up, giving the render loop the CPU whenever the ring is full. */
+        synth_generate(&gen, &params, chunk, SYNTH_CHUNK_SAMPLES);
+
+        unsigned int done = 0;
+        while (done < SYNTH_CHUNK_SAMPLES && !job_cancelled(&synth->job))
+        {
+            int written = audio_write_stereo_data(chunk + (done * 2), SYNTH_CHUNK_SAMPLES - done);
+            if (written <= 0)
+            {
+                thread_yield();
+                continue;
+            }
+
+            done += written;
+        }
+
+        job_publish_begin(&synth->job);
+        synth->written += done;
+        job_publish_end(&synth->job);
+    }
+
+    free(chunk);
+    return JOB_CANCELLED;
+}
+
+synth_t *start_synth(synth_params_t *params)
+{
+    synth_t *synth = malloc(sizeof(synth_t));
+    synth->params = *params;
+    synth->written = 0;
+
+    audio_register_ringbuffer(AUDIO_FORMAT_16BIT, SYNTH_SAMPLERATE, SYNTH_RING_SAMPLES);
+
+    job_start(&synth->job, synth_thread, synth, JOB_NO_TIMEOUT);
+    return synth;
+}
+
+void synth_set_params(synth_t *synth, synth_params_t *params)
+{
+    // The worker notices signal and frequency changes itself and starts the
+    // generator over, so all we do here is hand the new settings across.
+    job_request_begin(&synth->job);
+    synth->params = *params;
+    job_request_end(&synth->job);
+}
+
+void end_synth(synth_t *synth)
+{
+    // Stop refilling first, so the driver never reads a half-written chunk.
+    job_end(&synth->job);
+    audio_unregister_ringbuffer();
+    free(synth);
+}
@@ -0,0 +1,109 @@
+#ifndef __SYNTH_H
+#define __SYNTH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "jobs.h"
+
+// The signals we can generate.
+#define SYNTH_SILENCE 0
+#define SYNTH_SINE 1
+#define SYNTH_SWEEP 2
+#define SYNTH_WHITE_NOISE 3
+#define SYNTH_PINK_NOISE 4
+#define SYNTH_PULSE 5
+#define SYNTH_SIGNALS 6
+
+#define SYNTH_SAMPLERATE 44100
+
+// Entries in the sine table. Must be a power of two.
+#define SYNTH_SINE_BITS 10
+#define SYNTH_SINE_ENTRIES (1 << SYNTH_SINE_BITS)
+
+// The log sweep goes from the low to the high frequency over this long,
+// then starts again.
+#define SYNTH_SWEEP_LOW 20
+#define SYNTH_SWEEP_HIGH 20000
+#define SYNTH_SWEEP_SECONDS 10
+
+// Polarity pulses are a single positive half-cycle this long, repeated.
+#define SYNTH_PULSE_US 5000
+#define SYNTH_PULSE_PERIOD_US 500000
+
+// The number of random rows summed together for pink noise.
+#define SYNTH_PINK_ROWS 16
+
+// Full volume for the level setting.
+#define SYNTH_LEVEL_MAX 256
+
+typedef struct
+{
+    unsigned int signal;
+    // Frequency of the sine, in Hz.
+    unsigned int frequency;
+    // SPEAKER_LEFT and SPEAKER_RIGHT, for the channels that should sound.
+    unsigned int speakers;
+    // Volume from 0 to SYNTH_LEVEL_MAX.
+    unsigned int level;
+    // SPEAKER_LEFT and SPEAKER_RIGHT, for the channels that should get an
+    // inverted copy of the signal.
+    unsigned int invert;
+} synth_params_t;
+
+typedef struct
+{
+    // Oscillator phase and how far it moves each sample, where 2^32 is one
+    // full cycle.
+    uint32_t phase;
+    uint32_t increment;
+
+    // For sweeps, the per-sample increment multiplier in 2.30 fixed point,
+    // and where to start over.
+    uint32_t sweepratio;
+    uint32_t sweepstart;
+    uint32_t sweepend;
+
+    // Noise state.
+    uint32_t seed;
+    uint32_t counter;
+    int32_t rows[SYNTH_PINK_ROWS];
+    int32_t rowsum;
+
+    // Where we are within the pulse period, in samples.
+    unsigned int pulsepos;
+} synth_generator_t;
+
+typedef struct
+{
+    // The worker streaming samples, which runs until it is cancelled.
+    job_t job;
+
+    // What the UI wants played, handed over as a job request.
+    synth_params_t params;
+
+    // How many stereo samples have been handed to the audio driver.
+    uint32_t written;
+} synth_t;
+
+// Fill the sine table. Safe to call more than once.
+void synth_init();
+
+// Set up a generator to start a signal from the beginning.
+void synth_reset(synth_generator_t *gen, synth_params_t *params);
+
+// Generate interleaved 16-bit stereo samples, left channel first.
+void synth_generate(synth_generator_t *gen, synth_params_t *params, int16_t *out, unsigned int samples);
+
+// Start and stop streaming to the speakers from a background thread.
+synth_t *start_synth(synth_params_t *params);
+void synth_set_params(synth_t *synth, synth_params_t *params);
+void end_synth(synth_t *synth);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,59 @@
+#! /usr/bin/env python3
+#
+# Round-trips every sound the ROM ships as ADPCM, plus a few synthetic ones,
+# through tools/adpcm.py and fails if any of them comes back noisier than
+# the bound that mkpack.py enforces, or if the encoder and decoder disagree.
+import math
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tools"))
+
+from adpcm import MIN_SNR, decode, encode, read_pcm, snr  # noqa: E402
+
+TOP = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+# The sounds listed in ADPCM_SOUNDS in the Makefile.
+SOUNDS = ["scroll.raw", "scale.raw"]
+
+failures = 0
+
+
+def check(name: str, samples: list) -> None:
+    global failures
+
+    data = encode(samples)
+    if len(data) != (len(samples) + 1) // 2:
+        print(f"FAILED: {name} encoded to {len(data)} bytes for {len(samples)} samples")
+        failures += 1
+        return
+
+    ratio = snr(samples, decode(data, len(samples)))
+    if ratio < MIN_SNR:
+        print(f"FAILED: {name} SNR {ratio:.02f} dB is below {MIN_SNR:.02f} dB")
+        failures += 1
+    else:
+        print(f"{name}: SNR {ratio:.02f} dB")
+
+
+def tone(frequency: float, samplerate: int, amplitude: float, count: int) -> list:
+    return [int(amplitude * math.sin(2.0 * math.pi * frequency * i / samplerate)) for i in range(count)]
+
+
+def main() -> int:
+    for sound in SOUNDS:
+        check(sound, read_pcm(os.path.join(TOP, sound)))
+
+    check("1kHz sine at 44.1kHz", tone(1000.0, 44100, 16000.0, 44100))
+    check("440Hz sine at 11kHz", tone(440.0, 11025, 8000.0, 11025))
+    check("quiet 200Hz sine at 44.1kHz", tone(200.0, 44100, 500.0, 44100))
+
+    if failures:
+        print(f"FAILED, {failures} failed checks")
+        return 1
+    print("PASSED, 0 failed checks")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <zlib.h>
+#include "../crc.h"
+
+// Checks the slice-by-8 CRC against zlib's crc32(), over every alignment
+// and every length of the byte-wise tail, and when chained across calls.
+#define BUFFER_SIZE 4096
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            printf("    FAILED: %s (line %d)\n", #cond, __LINE__); \
+            failures++; \
+        } \
+    } while (0)
+
+static uint8_t buffer[BUFFER_SIZE + 16];
+
+static uint32_t zlib_crc(uint32_t crc, const uint8_t *data, unsigned int len)
+{
+    return crc32(crc, data, len);
+}
+
+static void test_short()
+{
+    printf("Lengths 0-15 at every alignment\n");
+
+    for (unsigned int start = 0; start < 8; start++)
+    {
+        for (unsigned int len = 0; len < 16; len++)
+        {
+            CHECK(crc_update(0, buffer + start, len) == zlib_crc(0, buffer + start, len));
+        }
+    }
+}
+
+static void test_random()
+{
+    printf("Random buffers with unaligned starts\n");
+
+    for (int i = 0; i < 1000; i++)
+    {
+        unsigned int start = rand() % 16;
+        unsigned int len = rand() % BUFFER_SIZE;
+        CHECK(crc_update(0, buffer + start, len) == zlib_crc(0, buffer + start, len));
+    }
+}
+
+static void test_chained()
+{
+    printf("Chained calls\n");
+
+    for (int i = 0; i < 1000; i++)
+    {
+        unsigned int start = rand() % 16;
+        unsigned int len = rand() % BUFFER_SIZE;
+        unsigned int split = len ? rand() % len : 0;
+        uint32_t crc = crc_update(crc_update(0, buffer + start, split), buffer + start + split, len - split);
+        CHECK(crc == zlib_crc(0, buffer + start, len));
+    }
+}
+
+int main()
+{
+    srand(1);
+    for (unsigned int i = 0; i < sizeof(buffer); i++)
+    {
+        buffer[i] = rand();
+    }
+
+    test_short();
+    test_random();
+    test_chained();
+
+    printf("%s, %d failed checks\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "simmaple.h"
+#include "../maplewd.h"
+#include "../eeprombench.h"
+#include "../jobs.h"
+
+// Runs the EEPROM bench against a stand-in EEPROM, and makes sure that it
+// only reports the original contents as restored once nothing it gave up on
+// can still write over them.
+#define TEST_CYCLES 4
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            printf("    FAILED: %s (line %d)\n", #cond, __LINE__); \
+            failures++; \
+        } \
+    } while (0)
+
+static void *release_later(void *param)
+{
+    usleep(*(unsigned int *)param);
+    simmaple_release();
+    return NULL;
+}
+
+// Asks the run to stop once it has been polled this many times.
+static int leave_after(void *param)
+{
+    unsigned int *polls = (unsigned int *)param;
+    if (*polls > 0)
+    {
+        (*polls)--;
+    }
+    return *polls == 0;
+}
+
+static eeprom_bench_t *run_bench(uint8_t *original, unsigned int *polls)
+{
+    memcpy(original, simmaple_contents(), SIMMAPLE_EEPROM_SIZE);
+
+    eeprom_bench_t *bench = start_eeprom_bench(TEST_CYCLES, polls ? leave_after : NULL, polls);
+    CHECK(bench != NULL);
+    while (job_state(&bench->job) == JOB_PENDING || job_state(&bench->job) == JOB_RUNNING)
+    {
+        usleep(1000);
+    }
+
+    return bench;
+}
+
+static void test_healthy()
+{
+    printf("Healthy EEPROM\n");
+
+    uint8_t original[SIMMAPLE_EEPROM_SIZE];
+    simmaple_reset(NULL);
+    eeprom_bench_t *bench = run_bench(original, NULL);
+    CHECK(job_state(&bench->job) == JOB_FINISHED);
+    CHECK(bench->restore == EEPROMBENCH_RESTORE_OK);
+    CHECK(bench->crcbefore == bench->crcafter);
+    CHECK(bench->mismatches == 0 && bench->failures == 0 && bench->timeouts == 0);
+    CHECK(bench->written == TEST_CYCLES + 1);
+    CHECK(memcmp(original, simmaple_contents(), SIMMAPLE_EEPROM_SIZE) == 0);
+    CHECK(simmaple_stats().overlaps == 0);
+    end_eeprom_bench(bench);
+}
+
+static void test_late_write()
+{
+    printf("Pattern write that lands after timing out\n");
+
+    // Gets stuck past its deadline, then lands before we give up waiting.
+    uint8_t original[SIMMAPLE_EEPROM_SIZE];
+    unsigned int delay = MAPLEWD_DEFAULT_DEADLINE + (MAPLEWD_DEFAULT_DEADLINE / 2);
+    pthread_t thread;
+    simmaple_reset(NULL);
+    simmaple_stall(SIMMAPLE_WRITES, 1, SIMMAPLE_STALL_UNTIL_RELEASED);
+    pthread_create(&thread, NULL, release_later, &delay);
+
+    eeprom_bench_t *bench = run_bench(original, NULL);
+    pthread_join(thread, NULL);
+    CHECK(job_state(&bench->job) == JOB_FINISHED);
+    CHECK(bench->timeouts == 1);
+    CHECK(bench->restore == EEPROMBENCH_RESTORE_OK);
+    CHECK(memcmp(original, simmaple_contents(), SIMMAPLE_EEPROM_SIZE) == 0);
+    CHECK(simmaple_stats().overlaps == 0);
+    end_eeprom_bench(bench);
+}
+
+static void test_stuck_write()
+{
+    printf("Pattern write that never comes back\n");
+
+    uint8_t original[SIMMAPLE_EEPROM_SIZE];
+    simmaple_reset(NULL);
+    simmaple_stall(SIMMAPLE_WRITES, 1, SIMMAPLE_STALL_UNTIL_RELEASED);
+
+    eeprom_bench_t *bench = run_bench(original, NULL);
+    CHECK(job_state(&bench->job) == JOB_FAILED);
+    CHECK(bench->timeouts == 1);
+    CHECK(bench->restore == EEPROMBENCH_RESTORE_UNVERIFIED);
+    CHECK(simmaple_stats().overlaps == 0);
+    end_eeprom_bench(bench);
+
+    // Which was right, since it still lands once it is let go.
+    simmaple_release();
+    CHECK(maplewd_wait_idle(MAPLEWD_DEFAULT_DEADLINE));
+    CHECK(memcmp(original, simmaple_contents(), SIMMAPLE_EEPROM_SIZE) != 0);
+}
+
+static void test_leave_early()
+{
+    printf("Asked to leave part way through\n");
+
+    // The screen waits for this instead of ending the run straight away, so
+    // it has to finish on its own with the original contents back.
+    uint8_t original[SIMMAPLE_EEPROM_SIZE];
+    unsigned int polls = 2;
+    simmaple_reset(NULL);
+
+    eeprom_bench_t *bench = run_bench(original, &polls);
+    CHECK(job_state(&bench->job) == JOB_FINISHED);
+    CHECK(bench->exit);
+    CHECK(bench->written < TEST_CYCLES + 1);
+    CHECK(bench->restore == EEPROMBENCH_RESTORE_OK);
+    CHECK(memcmp(original, simmaple_contents(), SIMMAPLE_EEPROM_SIZE) == 0);
+    end_eeprom_bench(bench);
+}
+
+int main()
+{
+    test_healthy();
+    test_late_write();
+    test_stuck_write();
+    test_leave_early();
+
+    printf("%s, %d failed checks\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <naomi/timer.h>
+#include <naomi/thread.h>
+#include <naomi/system.h>
+
+// Deadlines and start times in microseconds, or zero for a free slot.
+static uint64_t timers[MAX_TIMERS];
+static uint64_t profiles[MAX_PROFILERS];
+static pthread_mutex_t slot_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t host_now()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000) + 1;
+}
+
+static int slot_take(uint64_t *slots, int count, uint64_t value)
+{
+    pthread_mutex_lock(&slot_mutex);
+    for (int i = 0; i < count; i++)
+    {
+        if (slots[i] == 0)
+        {
+            slots[i] = value;
+            pthread_mutex_unlock(&slot_mutex);
+            return i;
+        }
+    }
+    pthread_mutex_unlock(&slot_mutex);
+
+    return -1;
+}
+
+int timer_start(uint32_t microseconds)
+{
+    return slot_take(timers, MAX_TIMERS, host_now() + microseconds);
+}
+
+void timer_stop(int timer)
+{
+    if (timer >= 0 && timer < MAX_TIMERS)
+    {
+        timers[timer] = 0;
+    }
+}
+
+uint32_t timer_left(int timer)
+{
+    if (timer < 0 || timer >= MAX_TIMERS || timers[timer] == 0)
+    {
+        return 0;
+    }
+
+    uint64_t now = host_now();
+    return timers[timer] > now ? timers[timer] - now : 0;
+}
+
+int profile_start()
+{
+    return slot_take(profiles, MAX_PROFILERS, host_now());
+}
+
+uint32_t profile_end(int profile)
+{
+    if (profile < 0 || profile >= MAX_PROFILERS || profiles[profile] == 0)
+    {
+        return 0;
+    }
+
+    uint32_t elapsed = host_now() - profiles[profile];
+    profiles[profile] = 0;
+    return elapsed;
+}
+
+void thread_yield()
+{
+    sched_yield();
+}
+
+void thread_sleep(uint32_t microseconds)
+{
+    usleep(microseconds);
+}
+
+int hw_memcpy(void *dest, void *src, unsigned int amount)
+{
+    memcpy(dest, src, amount);
+    return 0;
+}
+
+int hw_memset(void *addr, uint32_t value, unsigned int amount)
+{
+    for (unsigned int i = 0; i < amount; i += 4)
+    {
+        memcpy((uint8_t *)addr + i, &value, amount - i < 4 ? amount - i : 4);
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "../jobs.h"
+
+// Checks that jobs report how they ended, and in particular that one stuck
+// past its timeout is reported as timed out while it is still stuck.
+#define TEST_TIMEOUT 20000
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            printf("    FAILED: %s (line %d)\n", #cond, __LINE__); \
+            failures++; \
+        } \
+    } while (0)
+
+static volatile unsigned int released = 0;
+
+static unsigned int quick_job(void *param)
+{
+    return JOB_FINISHED;
+}
+
+static unsigned int polite_job(void *param)
+{
+    job_t *job = (job_t *)param;
+    while (!job_cancelled(job))
+    {
+        usleep(1000);
+    }
+
+    return JOB_CANCELLED;
+}
+
+static unsigned int stuck_job(void *param)
+{
+    // Never checks for cancellation, like a request stuck on a bus.
+    while (!released)
+    {
+        usleep(1000);
+    }
+
+    return JOB_FINISHED;
+}
+
+static unsigned int wait_for(job_t *job)
+{
+    // Give up well after the timeout, so a job that never reports it fails
+    // the check instead of hanging the test.
+    unsigned int state;
+    for (int waited = 0; waited < (TEST_TIMEOUT * 50) / 1000; waited++)
+    {
+        state = job_state(job);
+        if (state != JOB_PENDING && state != JOB_RUNNING)
+        {
+            break;
+        }
+        usleep(1000);
+    }
+
+    return state;
+}
+
+static void test_finished()
+{
+    printf("Job that finishes in time\n");
+
+    job_t job;
+    job_start(&job, quick_job, &job, TEST_TIMEOUT);
+    CHECK(wait_for(&job) == JOB_FINISHED);
+    job_end(&job);
+    CHECK(job_done(&job));
+}
+
+static void test_polite_timeout()
+{
+    printf("Job that notices its timeout\n");
+
+    job_t job;
+    job_start(&job, polite_job, &job, TEST_TIMEOUT);
+    CHECK(wait_for(&job) == JOB_TIMED_OUT);
+    job_end(&job);
+    CHECK(job_done(&job));
+    CHECK(job_state(&job) == JOB_TIMED_OUT);
+}
+
+static void test_stuck_timeout()
+{
+    printf("Job stuck past its timeout\n");
+
+    static job_t job;
+    released = 0;
+    job_start(&job, stuck_job, &job, TEST_TIMEOUT);
+    CHECK(wait_for(&job) == JOB_TIMED_OUT);
+    CHECK(!job_done(&job));
+    job_abandon(&job);
+
+    // Once it does come back, it is still reported as having timed out.
+    released = 1;
+    while (!job_done(&job))
+    {
+        usleep(1000);
+    }
+    CHECK(job_state(&job) == JOB_TIMED_OUT);
+}
+
+int main()
+{
+    test_finished();
+    test_polite_timeout();
+    test_stuck_timeout();
+
+    printf("%s, %d failed checks\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
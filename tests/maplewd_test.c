@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "simmaple.h"
+#include "../maplewd.h"
+
+// Runs the maple watchdog against a stand-in EEPROM that can fail, or stall
+// until the bus is reset or until the test lets it go, and makes sure that
+// stuck requests are walked away from without anything else ever joining
+// them on the bus.
+#define TEST_DEADLINE 20000
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            printf("    FAILED: %s (line %d)\n", #cond, __LINE__); \
+            failures++; \
+        } \
+    } while (0)
+
+static void test_healthy()
+{
+    printf("Healthy requests\n");
+
+    uint8_t data[MAPLEWD_EEPROM_SIZE];
+    uint32_t elapsed_us = 0;
+    simmaple_reset(NULL);
+    memset(data, 0x5A, sizeof(data));
+    CHECK(maplewd_eeprom_write(data, TEST_DEADLINE, &elapsed_us) == MAPLEWD_OK);
+    CHECK(elapsed_us > 0);
+    CHECK(simmaple_contents()[17] == 0x5A);
+
+    memset(data, 0, sizeof(data));
+    CHECK(maplewd_eeprom_read(data, TEST_DEADLINE, &elapsed_us) == MAPLEWD_OK);
+    CHECK(data[17] == 0x5A);
+    CHECK(!maplewd_busy());
+    CHECK(simmaple_stats().resets == 0);
+}
+
+static void test_failed()
+{
+    printf("Failed request\n");
+
+    uint8_t data[MAPLEWD_EEPROM_SIZE];
+    uint32_t elapsed_us;
+    simmaple_reset(NULL);
+    simmaple_fail(1);
+    CHECK(maplewd_eeprom_read(data, TEST_DEADLINE, &elapsed_us) == MAPLEWD_FAILED);
+    simmaple_fail(0);
+    CHECK(maplewd_abandoned() == 0);
+    CHECK(!maplewd_busy());
+}
+
+static void test_stall_cleared_by_reset()
+{
+    printf("Stalled request knocked loose by the reset\n");
+
+    uint8_t data[MAPLEWD_EEPROM_SIZE];
+    uint32_t elapsed_us;
+    unsigned int abandoned = maplewd_abandoned();
+    simmaple_reset(NULL);
+    simmaple_stall(SIMMAPLE_READS, 0, SIMMAPLE_STALL_UNTIL_RESET);
+    CHECK(maplewd_eeprom_read(data, TEST_DEADLINE, &elapsed_us) == MAPLEWD_TIMED_OUT);
+    CHECK(elapsed_us >= TEST_DEADLINE);
+    CHECK(maplewd_abandoned() == abandoned + 1);
+    CHECK(simmaple_stats().resets == 1);
+
+    // The next request waits for the old one to come back, then goes out.
+    CHECK(maplewd_eeprom_read(data, TEST_DEADLINE, &elapsed_us) == MAPLEWD_OK);
+    CHECK(!maplewd_busy());
+    CHECK(simmaple_stats().overlaps == 0);
+}
+
+static void test_stall_outlasts_reset()
+{
+    printf("Stalled write that outlasts the reset\n");
+
+    uint8_t original[MAPLEWD_EEPROM_SIZE];
+    uint8_t data[MAPLEWD_EEPROM_SIZE];
+    uint32_t elapsed_us;
+    simmaple_reset(NULL);
+    memcpy(original, simmaple_contents(), sizeof(original));
+    memset(data, 0xC3, sizeof(data));
+
+    simmaple_stall(SIMMAPLE_WRITES, 0, SIMMAPLE_STALL_UNTIL_RELEASED);
+    CHECK(maplewd_eeprom_write(data, TEST_DEADLINE, &elapsed_us) == MAPLEWD_TIMED_OUT);
+    CHECK(maplewd_busy());
+    CHECK(!maplewd_wait_idle(TEST_DEADLINE));
+
+    // Nothing else goes out while it is stuck, including a restore.
+    unsigned int requests = simmaple_stats().requests;
+    CHECK(maplewd_eeprom_write(original, TEST_DEADLINE, &elapsed_us) == MAPLEWD_BUSY);
+    CHECK(elapsed_us >= TEST_DEADLINE);
+    CHECK(simmaple_stats().requests == requests);
+
+    // Once it lets go, its write lands late, and only then can we put the
+    // original contents back.
+    simmaple_release();
+    CHECK(maplewd_wait_idle(TEST_DEADLINE * 10));
+    CHECK(!maplewd_busy());
+    CHECK(simmaple_contents()[3] == 0xC3);
+    CHECK(maplewd_eeprom_write(original, TEST_DEADLINE, &elapsed_us) == MAPLEWD_OK);
+    CHECK(memcmp(original, simmaple_contents(), sizeof(original)) == 0);
+    CHECK(simmaple_stats().overlaps == 0);
+}
+
+int main()
+{
+    test_healthy();
+    test_failed();
+    test_stall_cleared_by_reset();
+    test_stall_outlasts_reset();
+
+    printf("%s, %d failed checks\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
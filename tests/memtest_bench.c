@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "simmem.h"
+#include "../memtest.h"
+#include "../jobs.h"
+
+// Reports how many bytes per second each memory test kernel gets through at
+// each access width. Every access goes through the simulated device, so
+// these compare the kernels against each other rather than predicting
+// cabinet figures.
+#define BENCH_SIZE (1024 * 1024)
+
+static double bench_rate(uint32_t us)
+{
+    return us ? ((double)BENCH_SIZE / ((double)us / 1000000.0)) / (1024.0 * 1024.0) : 0.0;
+}
+
+static void bench_width(unsigned int flags, const char *name)
+{
+    simmem_reset(BENCH_SIZE, NULL);
+
+    memory_test_t *memtest = start_memory_test(SIMMEM_BASE, BENCH_SIZE, flags);
+    while (job_state(&memtest->job) == JOB_PENDING || job_state(&memtest->job) == JOB_RUNNING)
+    {
+        usleep(1000);
+    }
+
+    printf(
+        "%-10s %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+        name,
+        bench_rate(memtest->w1sus),
+        bench_rate(memtest->w0sus),
+        bench_rate(memtest->dataus),
+        bench_rate(memtest->randus),
+        (double)memtest->addrus / 1000.0
+    );
+    end_memory_test(memtest);
+}
+
+int main()
+{
+    printf("Kernel throughput over %dKB, in MB/s (address test in ms)\n", BENCH_SIZE / 1024);
+    printf("%-10s %10s %10s %10s %10s %10s\n", "Width", "Walking 1s", "Walking 0s", "Device", "Random", "Address");
+    bench_width(0, "8-bit");
+    bench_width(MEMTEST_FLAG_WIDE, "32-bit");
+    bench_width(MEMTEST_FLAG_G2, "G2 32-bit");
+    bench_width(MEMTEST_FLAG_PRESERVE, "8-bit NDT");
+    return 0;
+}
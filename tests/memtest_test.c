@@ -0,0 +1,376 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <naomi/timer.h>
+#include "simmem.h"
+#include "../memtest.h"
+#include "../jobs.h"
+
+// Runs every memory test kernel against a simulated device with one fault
+// class injected at a time, and makes sure the kernels that claim to catch
+// that fault do, and point at the right place.
+#define TEST_SIZE (64 * 1024)
+
+static int failures = 0;
+
+// Linked with --wrap=memalign, so that tests can make the buffers the memory
+// test backs regions up into fail to allocate.
+static unsigned int memalign_fails = 0;
+
+void *__real_memalign(size_t alignment, size_t size);
+
+void *__wrap_memalign(size_t alignment, size_t size)
+{
+    return memalign_fails ? NULL : __real_memalign(alignment, size);
+}
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            printf("    FAILED: %s (line %d)\n", #cond, __LINE__); \
+            failures++; \
+        } \
+    } while (0)
+
+static memory_test_t *run_memory_test(const simmem_faults_t *faults, unsigned int flags)
+{
+    simmem_reset(TEST_SIZE, faults);
+
+    memory_test_t *memtest = start_memory_test(SIMMEM_BASE, TEST_SIZE, flags);
+    while (job_state(&memtest->job) == JOB_PENDING || job_state(&memtest->job) == JOB_RUNNING)
+    {
+        usleep(1000);
+    }
+
+    return memtest;
+}
+
+static void test_clean_device(unsigned int flags, const char *name)
+{
+    printf("Fault-free device, %s\n", name);
+
+    memory_test_t *memtest = run_memory_test(NULL, flags);
+    CHECK(job_state(&memtest->job) == JOB_FINISHED);
+    CHECK(memtest->w1saddr == MEMTEST_PASSED);
+    CHECK(memtest->w0saddr == MEMTEST_PASSED);
+    CHECK(memtest->addraddr == MEMTEST_PASSED);
+    CHECK(memtest->dataaddr == MEMTEST_PASSED);
+    CHECK(memtest->randaddr == MEMTEST_PASSED);
+    CHECK(memtest->faults.total == 0);
+    CHECK(memtest->addrlines.stuck == 0);
+    if (flags & MEMTEST_FLAG_G2)
+    {
+        CHECK(simmem_g2_waits() > 0);
+    }
+    end_memory_test(memtest);
+}
+
+static void test_preserve()
+{
+    printf("Non-destructive mode puts every byte back\n");
+
+    uint8_t original[TEST_SIZE];
+    simmem_reset(TEST_SIZE, NULL);
+    memcpy(original, simmem_cells(), TEST_SIZE);
+
+    memory_test_t *memtest = start_memory_test(SIMMEM_BASE, TEST_SIZE, MEMTEST_FLAG_PRESERVE);
+    while (job_state(&memtest->job) == JOB_PENDING || job_state(&memtest->job) == JOB_RUNNING)
+    {
+        usleep(1000);
+    }
+
+    CHECK(job_state(&memtest->job) == JOB_FINISHED);
+    CHECK(memtest->restoreaddr == MEMTEST_PASSED);
+    CHECK(memtest->crcbefore == memtest->crcafter);
+    CHECK(memcmp(original, simmem_cells(), TEST_SIZE) == 0);
+    end_memory_test(memtest);
+}
+
+static void test_cancel_restores()
+{
+    printf("Cancelling partway through puts every byte back\n");
+
+    uint8_t original[TEST_SIZE];
+    simmem_reset(TEST_SIZE, NULL);
+    memcpy(original, simmem_cells(), TEST_SIZE);
+
+    memory_test_t *memtest = start_memory_test(SIMMEM_BASE, TEST_SIZE, 0);
+    while (simmem_accesses() < TEST_SIZE)
+    {
+        usleep(100);
+    }
+    end_memory_test(memtest);
+
+    CHECK(memcmp(original, simmem_cells(), TEST_SIZE) == 0);
+}
+
+static void test_cancel_releases_profile()
+{
+    printf("Cancelling gives back every profile slot\n");
+
+    // Cancel during the first kernel, then during the region checksum.
+    for (int i = 0; i < MAX_PROFILERS * 2; i++)
+    {
+        simmem_reset(TEST_SIZE, NULL);
+        memory_test_t *memtest = start_memory_test(SIMMEM_BASE, TEST_SIZE, (i & 1) ? MEMTEST_FLAG_PRESERVE : 0);
+        while (simmem_accesses() < 64)
+        {
+            usleep(10);
+        }
+        end_memory_test(memtest);
+    }
+
+    int held[MAX_PROFILERS];
+    int count = 0;
+    while (count < MAX_PROFILERS && (held[count] = profile_start()) >= 0)
+    {
+        count++;
+    }
+    CHECK(count == MAX_PROFILERS);
+
+    while (count > 0)
+    {
+        profile_end(held[--count]);
+    }
+}
+
+static void test_no_profile_slots()
+{
+    printf("Running out of profile slots doesn't look like a cancel\n");
+
+    // Leave just the one the worker takes for the whole test and the one
+    // each kernel takes, so every chunk finds the slots all used up.
+    int held[MAX_PROFILERS];
+    int count = 0;
+    while (count < MAX_PROFILERS - 2)
+    {
+        held[count++] = profile_start();
+    }
+
+    memory_test_t *memtest = run_memory_test(NULL, 0);
+    CHECK(job_state(&memtest->job) == JOB_FINISHED);
+    CHECK(memtest->randaddr == MEMTEST_PASSED);
+    end_memory_test(memtest);
+
+    while (count > 0)
+    {
+        profile_end(held[--count]);
+    }
+}
+
+static void test_no_backup_memory()
+{
+    printf("No memory to back the region up refuses to start\n");
+
+    simmem_reset(TEST_SIZE, NULL);
+    memalign_fails = 1;
+    CHECK(start_memory_test(SIMMEM_BASE, TEST_SIZE, MEMTEST_FLAG_PRESERVE) == NULL);
+    CHECK(start_memory_test(SIMMEM_BASE, TEST_SIZE, 0) == NULL);
+    memalign_fails = 0;
+    CHECK(simmem_accesses() == 0);
+}
+
+static void test_stuck_data_bit(unsigned int flags, uint32_t stuck0, uint32_t stuck1, int lane, const char *name)
+{
+    printf("Stuck data bit, %s\n", name);
+
+    simmem_faults_t faults = { 0 };
+    faults.stuck0 = stuck0;
+    faults.stuck1 = stuck1;
+
+    // Walking a one finds bits stuck low, walking a zero finds bits stuck high.
+    memory_test_t *memtest = run_memory_test(&faults, flags);
+    if (stuck0)
+    {
+        CHECK(memtest->w1scount > 0);
+    }
+    if (stuck1)
+    {
+        CHECK(memtest->w0scount > 0);
+    }
+    CHECK(memtest->faults.lanes[lane] > 0);
+    for (int i = 0; i < MEMTEST_LANES; i++)
+    {
+        if (i != lane)
+        {
+            CHECK(memtest->faults.lanes[i] == 0);
+        }
+    }
+    end_memory_test(memtest);
+}
+
+static void test_stuck_address_line()
+{
+    printf("Stuck address line\n");
+
+    simmem_faults_t faults = { 0 };
+    faults.addrstuck0 = 1 << 10;
+
+    simmem_reset(TEST_SIZE, &faults);
+    address_lines_t lines;
+    CHECK(address_lines_analyze(SIMMEM_BASE, TEST_SIZE, 0, NULL, &lines) == 0);
+    CHECK(lines.lines == 16);
+    CHECK(lines.stuck == (1 << 10));
+    for (int i = 0; i < 32; i++)
+    {
+        CHECK(lines.shorted[i] == 0);
+    }
+
+    // A10 low makes every cell alias the one 1KB below it. The incrementing
+    // pattern repeats every 256 bytes so it can't see this, but the random
+    // stream never repeats over the region.
+    memory_test_t *memtest = run_memory_test(&faults, 0);
+    CHECK(memtest->addrlines.stuck == (1 << 10));
+    CHECK(memtest->addraddr == SIMMEM_BASE + (1 << 10));
+    CHECK(memtest->w1saddr == MEMTEST_PASSED);
+    CHECK(memtest->dataaddr == MEMTEST_PASSED);
+    CHECK(memtest->randaddr != MEMTEST_PASSED);
+    end_memory_test(memtest);
+}
+
+static void test_stuck_high_address_line()
+{
+    printf("Stuck high address line in a word-wide region\n");
+
+    simmem_faults_t faults = { 0 };
+    faults.addrstuck1 = 1 << 3;
+
+    simmem_reset(TEST_SIZE, &faults);
+    address_lines_t lines;
+    CHECK(address_lines_analyze(SIMMEM_BASE, TEST_SIZE, MEMTEST_FLAG_WIDE, NULL, &lines) == 0);
+    CHECK(lines.firstline == 2);
+    CHECK(lines.stuck == (1 << 3));
+}
+
+static void test_shorted_address_lines()
+{
+    printf("Shorted address lines\n");
+
+    simmem_faults_t faults = { 0 };
+    faults.shorta = 1 << 4;
+    faults.shortb = 1 << 7;
+
+    simmem_reset(TEST_SIZE, &faults);
+    address_lines_t lines;
+    CHECK(address_lines_analyze(SIMMEM_BASE, TEST_SIZE, 0, NULL, &lines) == 0);
+    CHECK(lines.stuck == 0);
+    CHECK(lines.shorted[4] == (1 << 7));
+    CHECK(lines.shorted[7] == (1 << 4));
+    for (int i = 0; i < 32; i++)
+    {
+        if (i != 4 && i != 7)
+        {
+            CHECK(lines.shorted[i] == 0);
+        }
+    }
+
+    memory_test_t *memtest = run_memory_test(&faults, 0);
+    CHECK(memtest->addraddr != MEMTEST_PASSED);
+    CHECK(memtest->randaddr != MEMTEST_PASSED);
+    end_memory_test(memtest);
+}
+
+static void test_unaligned_region()
+{
+    printf("Address lines of a region that isn't aligned to its size\n");
+
+    // The region starts with A14 already high, so stepping 2^14 from its
+    // start actually drives A15. Only the real A14 should be reported.
+    simmem_faults_t faults = { 0 };
+    faults.addrstuck0 = 1 << 14;
+
+    simmem_reset(TEST_SIZE, &faults);
+    address_lines_t lines;
+    CHECK(address_lines_analyze(SIMMEM_BASE + 0x4000, TEST_SIZE - 0x4000, MEMTEST_FLAG_WIDE, NULL, &lines) == 0);
+    CHECK(lines.lines == 16);
+    CHECK(lines.stuck == (1 << 14));
+
+    faults.addrstuck0 = 0;
+    faults.shorta = 1 << 14;
+    faults.shortb = 1 << 9;
+
+    simmem_reset(TEST_SIZE, &faults);
+    CHECK(address_lines_analyze(SIMMEM_BASE + 0x4000, TEST_SIZE - 0x4000, MEMTEST_FLAG_WIDE, NULL, &lines) == 0);
+    CHECK(lines.stuck == 0);
+    CHECK(lines.shorted[14] == (1 << 9));
+    CHECK(lines.shorted[9] == (1 << 14));
+    CHECK(lines.shorted[15] == 0);
+
+    // Nothing wrong at all shouldn't turn up anything either.
+    simmem_reset(TEST_SIZE, NULL);
+    CHECK(address_lines_analyze(SIMMEM_BASE + 0x4000, TEST_SIZE - 0x4000, MEMTEST_FLAG_WIDE, NULL, &lines) == 0);
+    CHECK(lines.stuck == 0);
+    CHECK(lines.dataerrors == 0);
+    for (int i = 0; i < 32; i++)
+    {
+        CHECK(lines.shorted[i] == 0);
+    }
+}
+
+static void test_coupling(unsigned int flags, const char *name)
+{
+    printf("Coupling fault, %s\n", name);
+
+    simmem_faults_t faults = { 0 };
+    faults.coupled = 1;
+    faults.aggressor = 0x2011;
+    faults.victim = 0x1001;
+    faults.couplemask = 0x10;
+
+    // Each cell reads back fine straight after it is written, so only the
+    // tests that fill everything before checking anything can see this.
+    memory_test_t *memtest = run_memory_test(&faults, flags);
+    CHECK(memtest->w1saddr == MEMTEST_PASSED);
+    CHECK(memtest->w0saddr == MEMTEST_PASSED);
+    CHECK(memtest->dataaddr == SIMMEM_BASE + (faults.victim & ~((flags & MEMTEST_FLAG_WIDE) ? 3 : 0)));
+    CHECK(memtest->randaddr == SIMMEM_BASE + (faults.victim & ~3));
+    CHECK(memtest->faults.lanes[(flags & MEMTEST_FLAG_WIDE) ? 12 : 4] > 0);
+    end_memory_test(memtest);
+}
+
+static void test_retention_decay()
+{
+    printf("Retention decay\n");
+
+    // Leaks well after a walking test has read a cell back, but well before
+    // a fill of the whole region comes back around to verify it.
+    simmem_faults_t faults = { 0 };
+    faults.leaky = 0x00000040;
+    faults.decayticks = TEST_SIZE / 8;
+
+    memory_test_t *memtest = run_memory_test(&faults, 0);
+    CHECK(memtest->w1saddr == MEMTEST_PASSED);
+    CHECK(memtest->w0saddr == MEMTEST_PASSED);
+    CHECK(memtest->dataaddr != MEMTEST_PASSED);
+    CHECK(memtest->randaddr != MEMTEST_PASSED);
+    CHECK(memtest->faults.lanes[6] > 0);
+    end_memory_test(memtest);
+}
+
+int main()
+{
+    test_clean_device(0, "byte-wide");
+    test_clean_device(MEMTEST_FLAG_WIDE, "word-wide");
+    test_clean_device(MEMTEST_FLAG_G2, "G2 bus");
+    test_preserve();
+    test_cancel_restores();
+    test_cancel_releases_profile();
+    test_no_profile_slots();
+    test_no_backup_memory();
+    test_stuck_data_bit(0, 0x00000008, 0, 3, "D3 low, byte-wide");
+    test_stuck_data_bit(0, 0, 0x00000080, 7, "D7 high, byte-wide");
+    test_stuck_data_bit(MEMTEST_FLAG_WIDE, 0x00000200, 0, 9, "D9 low, word-wide");
+    test_stuck_data_bit(MEMTEST_FLAG_WIDE, 0, 0x40000000, 30, "D30 high, word-wide");
+    test_stuck_address_line();
+    test_stuck_high_address_line();
+    test_shorted_address_lines();
+    test_unaligned_region();
+    test_coupling(0, "byte-wide");
+    test_coupling(MEMTEST_FLAG_WIDE, "word-wide");
+    test_retention_decay();
+
+    printf("%s, %d failed checks\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
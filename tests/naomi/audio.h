@@ -0,0 +1,20 @@
+#ifndef __NAOMI_AUDIO_H
+#define __NAOMI_AUDIO_H
+
+// Host stand-in for the parts of the libnaomi audio driver that the signal
+// generator streams through. The test that links against it provides the
+// ring buffer calls and decides what happens to the samples.
+#include <stdint.h>
+
+#define AUDIO_FORMAT_16BIT 0
+#define AUDIO_FORMAT_8BIT 1
+#define AUDIO_FORMAT_4BIT 2
+
+#define SPEAKER_LEFT 1
+#define SPEAKER_RIGHT 2
+
+int audio_register_ringbuffer(int format, unsigned int samplerate, unsigned int num_samples);
+void audio_unregister_ringbuffer();
+int audio_write_stereo_data(void *data, unsigned int num_samples);
+
+#endif
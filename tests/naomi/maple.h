@@ -0,0 +1,13 @@
+#ifndef __NAOMI_MAPLE_H
+#define __NAOMI_MAPLE_H
+
+// Host stand-in for the libnaomi maple calls. Host builds force-include
+// simmaple.h, which points the maple watchdog at a stand-in EEPROM instead,
+// so none of these are ever called.
+#include <stdint.h>
+
+int maple_request_eeprom_read(uint8_t *outbytes);
+int maple_request_eeprom_write(uint8_t *inbytes);
+int maple_request_reset();
+
+#endif
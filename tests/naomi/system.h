@@ -0,0 +1,11 @@
+#ifndef __NAOMI_SYSTEM_H
+#define __NAOMI_SYSTEM_H
+
+// Host stand-in for the libnaomi system calls that the code under test
+// references. There's no hardware to talk to, so these are plain copies.
+#include <stdint.h>
+
+int hw_memcpy(void *dest, void *src, unsigned int amount);
+int hw_memset(void *addr, uint32_t value, unsigned int amount);
+
+#endif
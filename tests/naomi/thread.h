@@ -0,0 +1,11 @@
+#ifndef __NAOMI_THREAD_H
+#define __NAOMI_THREAD_H
+
+// Host stand-in for the libnaomi thread helpers. Threads themselves come
+// from the host's pthreads, just like they do on the cabinet.
+#include <stdint.h>
+
+void thread_yield();
+void thread_sleep(uint32_t microseconds);
+
+#endif
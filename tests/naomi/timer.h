@@ -0,0 +1,19 @@
+#ifndef __NAOMI_TIMER_H
+#define __NAOMI_TIMER_H
+
+// Host stand-in for the libnaomi timer and profiling calls, backed by the
+// host's monotonic clock. Like the real thing, there are only so many of
+// each and starting one returns a negative number once they run out.
+#include <stdint.h>
+
+#define MAX_TIMERS 64
+#define MAX_PROFILERS 16
+
+int timer_start(uint32_t microseconds);
+void timer_stop(int timer);
+uint32_t timer_left(int timer);
+
+int profile_start();
+uint32_t profile_end(int profile);
+
+#endif
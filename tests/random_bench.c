@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <naomi/timer.h>
+#include "rawmem.h"
+#include "../memtest.h"
+#include "../jobs.h"
+
+// Times the pseudo-random pattern generator on its own, and the random
+// test's fill and verify loop over plain host memory.
+#define GENERATOR_ROUNDS (64 * 1024 * 1024)
+
+uint8_t rawmem[RAWMEM_SIZE] __attribute__((aligned(32)));
+
+int main()
+{
+    // The generator by itself. The result is printed so the loop can't be
+    // thrown away.
+    uint32_t seed = 0x2545F491;
+    int profile = profile_start();
+    for (unsigned int i = 0; i < GENERATOR_ROUNDS; i++)
+    {
+        seed = xorshift32(seed);
+    }
+    uint32_t generator_us = profile_end(profile);
+    printf(
+        "xorshift32: %.1f million words/s (%08X)\n",
+        (double)GENERATOR_ROUNDS / (double)generator_us,
+        seed
+    );
+
+    // A plain word loop over the same memory, for comparison.
+    profile = profile_start();
+    for (unsigned int i = 0; i < RAWMEM_SIZE; i += 4)
+    {
+        MEMTEST_WRITE32(RAWMEM_BASE + i, i);
+    }
+    for (unsigned int i = 0; i < RAWMEM_SIZE; i += 4)
+    {
+        if (MEMTEST_READ32(RAWMEM_BASE + i) != i)
+        {
+            printf("Host memory doesn't work!\n");
+            return 1;
+        }
+    }
+    uint32_t baseline_us = profile_end(profile);
+
+    // The random test fills and verifies the region once per seed.
+    memory_test_t *memtest = start_memory_test(RAWMEM_BASE, RAWMEM_SIZE, MEMTEST_FLAG_WIDE);
+    while (job_state(&memtest->job) == JOB_PENDING || job_state(&memtest->job) == JOB_RUNNING)
+    {
+        usleep(1000);
+    }
+
+    double moved = (double)RAWMEM_SIZE * 2.0 * MEMTEST_RANDOM_SEEDS / (1024.0 * 1024.0);
+    printf(
+        "Random fill/verify: %d seeds over %dKB in %.1fms, %.1f MB/s written and read back\n",
+        MEMTEST_RANDOM_SEEDS,
+        RAWMEM_SIZE / 1024,
+        (double)memtest->randus / 1000.0,
+        moved / ((double)memtest->randus / 1000000.0)
+    );
+    printf(
+        "Plain fill/verify: %.1f MB/s written and read back\n",
+        ((double)RAWMEM_SIZE * 2.0 / (1024.0 * 1024.0)) / ((double)baseline_us / 1000000.0)
+    );
+
+    int failed = memtest->randaddr != MEMTEST_PASSED;
+    end_memory_test(memtest);
+    return failed;
+}
@@ -0,0 +1,28 @@
+#ifndef __RAWMEM_H
+#define __RAWMEM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Plain host memory standing in for a device with nothing wrong with it.
+// Unlike the simulated device this adds nothing to each access, so it is
+// what to benchmark against when timing a kernel's own loop.
+#define RAWMEM_BASE 0x0C000000
+#define RAWMEM_SIZE (4 * 1024 * 1024)
+
+extern uint8_t rawmem[RAWMEM_SIZE];
+
+#define MEMTEST_READ8(addr) (*((volatile uint8_t *)(rawmem + ((addr) - RAWMEM_BASE))))
+#define MEMTEST_WRITE8(addr, val) (*((volatile uint8_t *)(rawmem + ((addr) - RAWMEM_BASE))) = (val))
+#define MEMTEST_READ32(addr) (*((volatile uint32_t *)(rawmem + ((addr) - RAWMEM_BASE))))
+#define MEMTEST_WRITE32(addr, val) (*((volatile uint32_t *)(rawmem + ((addr) - RAWMEM_BASE))) = (val))
+#define MEMTEST_G2_WAIT()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
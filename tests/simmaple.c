@@ -0,0 +1,124 @@
+#include <string.h>
+#include <unistd.h>
+#include "simmaple.h"
+
+// How long a healthy request takes, in microseconds.
+#define SIMMAPLE_REQUEST_US 2000
+
+static uint8_t eeprom[SIMMAPLE_EEPROM_SIZE];
+static volatile unsigned int stallkinds = 0;
+static volatile unsigned int stallskip = 0;
+static volatile unsigned int stallhow = 0;
+static volatile unsigned int released = 0;
+static volatile unsigned int failing = 0;
+static volatile unsigned int onbus = 0;
+static volatile simmaple_stats_t stats;
+
+void simmaple_reset(const uint8_t *contents)
+{
+    for (unsigned int i = 0; i < SIMMAPLE_EEPROM_SIZE; i++)
+    {
+        eeprom[i] = contents != NULL ? contents[i] : (i * 13) + 1;
+    }
+
+    stallkinds = 0;
+    released = 0;
+    failing = 0;
+    memset((void *)&stats, 0, sizeof(stats));
+}
+
+uint8_t *simmaple_contents()
+{
+    return eeprom;
+}
+
+void simmaple_stall(unsigned int kinds, unsigned int skip, unsigned int how)
+{
+    stallskip = skip;
+    stallhow = how;
+    released = 0;
+    stallkinds = kinds;
+}
+
+void simmaple_release()
+{
+    released = 1;
+}
+
+void simmaple_fail(unsigned int fail)
+{
+    failing = fail;
+}
+
+simmaple_stats_t simmaple_stats()
+{
+    return stats;
+}
+
+static int simmaple_request(uint8_t *data, unsigned int kind)
+{
+    if (onbus)
+    {
+        stats.overlaps++;
+    }
+    onbus = 1;
+    stats.requests++;
+    if (kind == SIMMAPLE_WRITES)
+    {
+        stats.writes++;
+    }
+
+    // Work out whether this is the one to get stuck.
+    unsigned int how = 0;
+    if (stallkinds & kind)
+    {
+        if (stallskip > 0)
+        {
+            stallskip--;
+        }
+        else
+        {
+            how = stallhow;
+            stallkinds = 0;
+        }
+    }
+
+    unsigned int resets = stats.resets;
+    while ((how == SIMMAPLE_STALL_UNTIL_RESET && stats.resets == resets) || (how == SIMMAPLE_STALL_UNTIL_RELEASED && !released))
+    {
+        usleep(1000);
+    }
+
+    int result = -1;
+    if (!failing && (how == SIMMAPLE_STALL_UNTIL_RELEASED || stats.resets == resets))
+    {
+        usleep(SIMMAPLE_REQUEST_US);
+        if (kind == SIMMAPLE_WRITES)
+        {
+            memcpy(eeprom, data, SIMMAPLE_EEPROM_SIZE);
+        }
+        else
+        {
+            memcpy(data, eeprom, SIMMAPLE_EEPROM_SIZE);
+        }
+        result = 0;
+    }
+
+    onbus = 0;
+    return result;
+}
+
+int simmaple_eeprom_read(uint8_t *data)
+{
+    return simmaple_request(data, SIMMAPLE_READS);
+}
+
+int simmaple_eeprom_write(uint8_t *data)
+{
+    return simmaple_request(data, SIMMAPLE_WRITES);
+}
+
+void simmaple_bus_reset()
+{
+    stats.resets++;
+}
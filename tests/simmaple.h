@@ -0,0 +1,67 @@
+#ifndef __SIMMAPLE_H
+#define __SIMMAPLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// A stand-in for the IO board's EEPROM on the maple bus, for running the
+// maple watchdog and everything built on it on the host. This is
+// force-included ahead of maplewd.c, so every request it makes lands here.
+#define MAPLEWD_EEPROM_READ(data) simmaple_eeprom_read(data)
+#define MAPLEWD_EEPROM_WRITE(data) simmaple_eeprom_write(data)
+#define MAPLEWD_RESET() simmaple_bus_reset()
+
+// The size of the EEPROM, which must match MAPLEWD_EEPROM_SIZE.
+#define SIMMAPLE_EEPROM_SIZE 128
+
+// Which requests a stall applies to.
+#define SIMMAPLE_READS 0x1
+#define SIMMAPLE_WRITES 0x2
+
+// How a stalled request hangs. One stuck until the bus is reset then fails,
+// one stuck until it is released goes through however late it is.
+#define SIMMAPLE_STALL_UNTIL_RESET 1
+#define SIMMAPLE_STALL_UNTIL_RELEASED 2
+
+typedef struct
+{
+    // Requests that reached the EEPROM, and how many of them were writes.
+    unsigned int requests;
+    unsigned int writes;
+
+    // Bus resets, and requests that arrived while another was on the bus.
+    unsigned int resets;
+    unsigned int overlaps;
+} simmaple_stats_t;
+
+// Start over with the given contents, or a known pattern if NULL, and with
+// nothing stalled or failing.
+void simmaple_reset(const uint8_t *contents);
+
+// The EEPROM itself, for checking contents without making a request.
+uint8_t *simmaple_contents();
+
+// Stall the next request of the given kinds after letting skip of them
+// through first. Only one request is stalled each time this is called.
+void simmaple_stall(unsigned int kinds, unsigned int skip, unsigned int how);
+
+// Let go of a request stalled until released.
+void simmaple_release();
+
+// Fail every request outright until this is called again with zero.
+void simmaple_fail(unsigned int fail);
+
+simmaple_stats_t simmaple_stats();
+
+int simmaple_eeprom_read(uint8_t *data);
+int simmaple_eeprom_write(uint8_t *data);
+void simmaple_bus_reset();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
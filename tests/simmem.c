@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simmem.h"
+
+static uint8_t cells[SIMMEM_MAX_SIZE];
+static uint32_t written[SIMMEM_MAX_SIZE];
+static unsigned int cellcount = 0;
+static simmem_faults_t faults;
+static unsigned long ticks = 0;
+static unsigned long g2waits = 0;
+
+void simmem_reset(unsigned int size, const simmem_faults_t *newfaults)
+{
+    if (size > SIMMEM_MAX_SIZE)
+    {
+        fprintf(stderr, "Simulated device can't be %u bytes!\n", size);
+        abort();
+    }
+
+    cellcount = size;
+    ticks = 0;
+    g2waits = 0;
+    memset(&faults, 0, sizeof(faults));
+    if (newfaults != NULL)
+    {
+        memcpy(&faults, newfaults, sizeof(faults));
+    }
+
+    // Something other than zero, so that a kernel which never writes
+    // can't pass by accident.
+    for (unsigned int i = 0; i < size; i++)
+    {
+        cells[i] = (i * 7) ^ (i >> 8);
+        written[i] = 0;
+    }
+}
+
+uint8_t *simmem_cells()
+{
+    return cells;
+}
+
+unsigned long simmem_accesses()
+{
+    return ticks;
+}
+
+unsigned long simmem_g2_waits()
+{
+    return g2waits;
+}
+
+static unsigned int simmem_decode(unsigned int addr)
+{
+    unsigned int offset = addr - SIMMEM_BASE;
+    if (offset >= cellcount)
+    {
+        fprintf(stderr, "Access to %08X is outside the simulated device!\n", addr);
+        abort();
+    }
+
+    // Broken address lines change which cell actually gets selected.
+    offset = (offset & ~faults.addrstuck0) | faults.addrstuck1;
+    if (faults.shorta && faults.shortb && ((offset & faults.shorta) == 0 || (offset & faults.shortb) == 0))
+    {
+        offset &= ~(faults.shorta | faults.shortb);
+    }
+
+    return offset % cellcount;
+}
+
+static uint8_t simmem_lane(uint32_t mask, unsigned int cell)
+{
+    // The word-wide masks laid out the way the SH-4 sees bytes in a word.
+    return (mask >> ((cell & 3) * 8)) & 0xFF;
+}
+
+static uint8_t simmem_get(unsigned int cell)
+{
+    uint8_t leaky = simmem_lane(faults.leaky, cell);
+    if (leaky && faults.decayticks && ticks - written[cell] > faults.decayticks)
+    {
+        // Once it has leaked, it stays that way until it is written again.
+        cells[cell] &= ~leaky;
+    }
+
+    return (cells[cell] & ~simmem_lane(faults.stuck0, cell)) | simmem_lane(faults.stuck1, cell);
+}
+
+static void simmem_set(unsigned int cell, uint8_t val)
+{
+    cells[cell] = val;
+    written[cell] = ticks;
+
+    if (faults.coupled && cell == faults.aggressor)
+    {
+        cells[faults.victim] = (cells[faults.victim] & ~faults.couplemask) | (val & faults.couplemask);
+    }
+}
+
+uint8_t simmem_read8(unsigned int addr)
+{
+    ticks++;
+    return simmem_get(simmem_decode(addr));
+}
+
+void simmem_write8(unsigned int addr, uint8_t val)
+{
+    ticks++;
+    simmem_set(simmem_decode(addr), val);
+}
+
+uint32_t simmem_read32(unsigned int addr)
+{
+    ticks++;
+
+    uint32_t val = 0;
+    for (int byte = 0; byte < 4; byte++)
+    {
+        val |= (uint32_t)simmem_get(simmem_decode(addr + byte)) << (byte * 8);
+    }
+    return val;
+}
+
+void simmem_write32(unsigned int addr, uint32_t val)
+{
+    ticks++;
+
+    for (int byte = 0; byte < 4; byte++)
+    {
+        simmem_set(simmem_decode(addr + byte), (val >> (byte * 8)) & 0xFF);
+    }
+}
+
+void simmem_g2_wait()
+{
+    g2waits++;
+}
@@ -0,0 +1,74 @@
+#ifndef __SIMMEM_H
+#define __SIMMEM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// A simulated memory device for running the memory test kernels on the
+// host. This is force-included ahead of memtest.c, so every access the
+// kernels make lands here instead of on a real bus.
+#define MEMTEST_READ8(addr) simmem_read8(addr)
+#define MEMTEST_WRITE8(addr, val) simmem_write8(addr, val)
+#define MEMTEST_READ32(addr) simmem_read32(addr)
+#define MEMTEST_WRITE32(addr, val) simmem_write32(addr, val)
+#define MEMTEST_G2_WAIT() simmem_g2_wait()
+
+// Where the device appears in the address space, and the largest it can be.
+#define SIMMEM_BASE 0x0C000000
+#define SIMMEM_MAX_SIZE (1024 * 1024)
+
+// Faults that can be injected into the device. Data bits are given as a
+// mask over a 32-bit word, so bit 8 is D0 of the second byte in each word.
+typedef struct
+{
+    // Data bits that always read back as zero, or as one.
+    uint32_t stuck0;
+    uint32_t stuck1;
+
+    // Address lines that are always driven low, or high.
+    uint32_t addrstuck0;
+    uint32_t addrstuck1;
+
+    // Two address lines shorted together, each given as a single bit. Both
+    // lines end up low unless both are driven high.
+    uint32_t shorta;
+    uint32_t shortb;
+
+    // Writing to the aggressor cell drags the same bits of the victim cell
+    // along with it, leaving its other bits alone.
+    unsigned int coupled;
+    unsigned int aggressor;
+    unsigned int victim;
+    uint8_t couplemask;
+
+    // Data bits that leak back to zero once this many accesses have been
+    // made to the device since the cell was last written.
+    uint32_t leaky;
+    unsigned int decayticks;
+} simmem_faults_t;
+
+// Start over with a device of the given size, filled with a known pattern,
+// and with the given faults. Pass NULL for a device with nothing wrong.
+void simmem_reset(unsigned int size, const simmem_faults_t *faults);
+
+// The raw cells, for checking contents without going through any faults.
+uint8_t *simmem_cells();
+
+// How many accesses and G2 FIFO waits have been made since the last reset.
+unsigned long simmem_accesses();
+unsigned long simmem_g2_waits();
+
+uint8_t simmem_read8(unsigned int addr);
+void simmem_write8(unsigned int addr, uint8_t val);
+uint32_t simmem_read32(unsigned int addr);
+void simmem_write32(unsigned int addr, uint32_t val);
+void simmem_g2_wait();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
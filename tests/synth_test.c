@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <naomi/audio.h>
+#include "../synth.h"
+#include "../jobs.h"
+
+// Checks the signal generator's output against what it claims to be: the
+// sine table against libm, white noise for a flat spectrum and pink noise
+// for a 3dB per octave roll-off, measured with an averaged FFT.
+#define FFT_BITS 12
+#define FFT_SIZE (1 << FFT_BITS)
+#define FFT_BLOCKS 64
+
+#define PI 3.14159265358979323846
+
+// How far the generator may stray. The sine table interpolates between 1024
+// entries, which is good for better than 1.5 LSB and around 90dB SINAD.
+#define SINE_MAX_ERROR 2.0
+#define SINE_MIN_SINAD 80.0
+#define WHITE_MAX_RIPPLE 1.0
+#define PINK_SLOPE -3.0
+#define PINK_SLOPE_ERROR 0.5
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            printf("    FAILED: %s (line %d)\n", #cond, __LINE__); \
+            failures++; \
+        } \
+    } while (0)
+
+// The ring buffer the synth worker streams into, which only keeps count.
+static unsigned int ring_registered = 0;
+static unsigned int ring_samples = 0;
+static int16_t ring_last[2];
+
+int audio_register_ringbuffer(int format, unsigned int samplerate, unsigned int num_samples)
+{
+    ring_registered = 1;
+    return 0;
+}
+
+void audio_unregister_ringbuffer()
+{
+    ring_registered = 0;
+}
+
+int audio_write_stereo_data(void *data, unsigned int num_samples)
+{
+    // Take a few samples at a time, so the worker has to come back for more.
+    unsigned int taken = num_samples < 100 ? num_samples : 100;
+    memcpy(ring_last, (int16_t *)data + ((taken - 1) * 2), sizeof(ring_last));
+    ring_samples += taken;
+    return taken;
+}
+
+// From synth.c, which doesn't export them in synth.h.
+int32_t synth_sine(uint32_t phase);
+
+static void fft(double *re, double *im)
+{
+    // In-place iterative radix-2, bit reversal first.
+    for (unsigned int i = 1, j = 0; i < FFT_SIZE; i++)
+    {
+        unsigned int bit = FFT_SIZE >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+
+        if (i < j)
+        {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for (unsigned int len = 2; len <= FFT_SIZE; len <<= 1)
+    {
+        double angle = -2.0 * PI / len;
+        for (unsigned int i = 0; i < FFT_SIZE; i += len)
+        {
+            for (unsigned int k = 0; k < len / 2; k++)
+            {
+                double wr = cos(angle * k);
+                double wi = sin(angle * k);
+                double xr = (re[i + k + (len / 2)] * wr) - (im[i + k + (len / 2)] * wi);
+                double xi = (re[i + k + (len / 2)] * wi) + (im[i + k + (len / 2)] * wr);
+                re[i + k + (len / 2)] = re[i + k] - xr;
+                im[i + k + (len / 2)] = im[i + k] - xi;
+                re[i + k] += xr;
+                im[i + k] += xi;
+            }
+        }
+    }
+}
+
+static void power_spectrum(unsigned int signal, double *power)
+{
+    // Average windowed blocks of the left channel. Blackman-Harris keeps the
+    // tone's own leakage well under the distortion we are looking for.
+    synth_params_t params = { signal, 1000, SPEAKER_LEFT, SYNTH_LEVEL_MAX, 0 };
+    synth_generator_t gen;
+    static int16_t out[FFT_SIZE * 2];
+    static double re[FFT_SIZE];
+    static double im[FFT_SIZE];
+
+    synth_reset(&gen, &params);
+    memset(power, 0, sizeof(double) * (FFT_SIZE / 2));
+
+    for (unsigned int block = 0; block < FFT_BLOCKS; block++)
+    {
+        synth_generate(&gen, &params, out, FFT_SIZE);
+        for (unsigned int i = 0; i < FFT_SIZE; i++)
+        {
+            double x = (2.0 * PI * i) / (FFT_SIZE - 1);
+            double window = 0.35875 - (0.48829 * cos(x)) + (0.14128 * cos(2.0 * x)) - (0.01168 * cos(3.0 * x));
+            re[i] = out[i * 2] * window;
+            im[i] = 0.0;
+        }
+
+        fft(re, im);
+        for (unsigned int k = 0; k < FFT_SIZE / 2; k++)
+        {
+            power[k] += ((re[k] * re[k]) + (im[k] * im[k])) / FFT_BLOCKS;
+        }
+    }
+}
+
+// Average power per bin over one octave starting at the given frequency, in dB.
+static double octave_db(double *power, double low)
+{
+    unsigned int first = (unsigned int)ceil((low * FFT_SIZE) / SYNTH_SAMPLERATE);
+    unsigned int last = (unsigned int)floor((low * 2.0 * FFT_SIZE) / SYNTH_SAMPLERATE);
+    double sum = 0.0;
+    for (unsigned int k = first; k < last; k++)
+    {
+        sum += power[k];
+    }
+    return 10.0 * log10(sum / (last - first));
+}
+
+static void test_sine_table()
+{
+    printf("Sine table against libm\n");
+
+    synth_init();
+    double worst = 0.0;
+    for (uint64_t phase = 0; phase < 0x100000000ULL; phase += 0x10001)
+    {
+        double expected = 32767.0 * sin((2.0 * PI * (double)phase) / 4294967296.0);
+        double error = fabs(synth_sine((uint32_t)phase) - expected);
+        if (error > worst)
+        {
+            worst = error;
+        }
+    }
+
+    printf("    worst error %.2f LSB\n", worst);
+    CHECK(worst <= SINE_MAX_ERROR);
+}
+
+static void test_sine_purity()
+{
+    printf("Sine tone purity\n");
+
+    double power[FFT_SIZE / 2];
+    power_spectrum(SYNTH_SINE, power);
+
+    // Everything more than a few bins from the tone is distortion or noise.
+    unsigned int tone = (1000 * FFT_SIZE) / SYNTH_SAMPLERATE;
+    double signal = 0.0;
+    double noise = 0.0;
+    for (unsigned int k = 1; k < FFT_SIZE / 2; k++)
+    {
+        if (k + 4 >= tone && k <= tone + 4)
+        {
+            signal += power[k];
+        }
+        else
+        {
+            noise += power[k];
+        }
+    }
+
+    double ratio = 10.0 * log10(signal / noise);
+    printf("    signal to noise and distortion %.1f dB\n", ratio);
+    CHECK(ratio >= SINE_MIN_SINAD);
+}
+
+static void test_white_noise()
+{
+    printf("White noise flatness\n");
+
+    double power[FFT_SIZE / 2];
+    power_spectrum(SYNTH_WHITE_NOISE, power);
+
+    double lowest = 1000.0;
+    double highest = -1000.0;
+    for (double low = 80.0; low < 16000.0; low *= 2.0)
+    {
+        double db = octave_db(power, low);
+        printf("    %5.0fHz %6.2f dB\n", low, db);
+        lowest = db < lowest ? db : lowest;
+        highest = db > highest ? db : highest;
+    }
+
+    CHECK(highest - lowest <= WHITE_MAX_RIPPLE);
+}
+
+static void test_pink_noise()
+{
+    printf("Pink noise slope\n");
+
+    double power[FFT_SIZE / 2];
+    power_spectrum(SYNTH_PINK_NOISE, power);
+
+    // Least squares fit of level against octave number.
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    unsigned int n = 0;
+    for (double low = 80.0; low < 16000.0; low *= 2.0)
+    {
+        double x = (double)n;
+        double y = octave_db(power, low);
+        printf("    %5.0fHz %6.2f dB\n", low, y);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        n++;
+    }
+
+    double slope = ((n * sxy) - (sx * sy)) / ((n * sxx) - (sx * sx));
+    printf("    slope %.2f dB per octave\n", slope);
+    CHECK(slope <= PINK_SLOPE + PINK_SLOPE_ERROR);
+    CHECK(slope >= PINK_SLOPE - PINK_SLOPE_ERROR);
+}
+
+static void test_streaming()
+{
+    printf("Streaming to the ring buffer\n");
+
+    synth_params_t params = { SYNTH_SINE, 1000, SPEAKER_LEFT | SPEAKER_RIGHT, SYNTH_LEVEL_MAX, SPEAKER_RIGHT };
+    synth_t *synth = start_synth(&params);
+    CHECK(ring_registered);
+    while (ring_samples < SYNTH_SAMPLERATE)
+    {
+        usleep(1000);
+    }
+    end_synth(synth);
+
+    CHECK(!ring_registered);
+    CHECK(ring_last[0] == -ring_last[1]);
+}
+
+int main()
+{
+    test_sine_table();
+    test_sine_purity();
+    test_white_noise();
+    test_pink_noise();
+    test_streaming();
+
+    printf("%s, %d failed checks\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+#! /usr/bin/env python3
+#
+# Encodes signed 16-bit little-endian mono PCM into the 4-bit Yamaha ADPCM
+# that the AICA can play directly. Two samples go in each byte, low nibble
+# first, and the decoder state starts from silence every time a sound is
+# played, so every sound is encoded from that same starting state.
+#
+# Run on its own, this encodes a raw file, decodes it again and reports the
+# signal to noise ratio against the original.
+import argparse
+import math
+import struct
+import sys
+from typing import List, Tuple
+
+# How much the step size changes after each magnitude, in 8.8 fixed point.
+STEP_SCALE = [0x0E6, 0x0E6, 0x0E6, 0x0E6, 0x133, 0x199, 0x200, 0x266]
+
+STEP_MIN = 0x7F
+STEP_MAX = 0x6000
+
+# The least signal to noise ratio, in dB, that a sound may be left with after
+# encoding. Anything noisier than this fails the build rather than shipping.
+MIN_SNR = 20.0
+
+
+def step_sample(signal: int, step: int, nibble: int) -> Tuple[int, int]:
+    # Exactly what the AICA does with each nibble, so that the encoder can
+    # track the decoder without drifting.
+    delta = (((nibble & 7) * 2) + 1) * step >> 3
+    signal += -delta if (nibble & 8) else delta
+    signal = max(-32768, min(32767, signal))
+    step = max(STEP_MIN, min(STEP_MAX, (step * STEP_SCALE[nibble & 7]) >> 8))
+    return signal, step
+
+
+def encode(samples: List[int]) -> bytes:
+    signal = 0
+    step = STEP_MIN
+    nibbles = []
+    for sample in samples:
+        difference = sample - signal
+        magnitude = min(7, (abs(difference) * 4) // step)
+        nibble = magnitude | (8 if difference < 0 else 0)
+        signal, step = step_sample(signal, step, nibble)
+        nibbles.append(nibble)
+
+    if len(nibbles) & 1:
+        nibbles.append(0)
+    return bytes(nibbles[i] | (nibbles[i + 1] << 4) for i in range(0, len(nibbles), 2))
+
+
+def decode(data: bytes, count: int) -> List[int]:
+    signal = 0
+    step = STEP_MIN
+    samples = []
+    for i in range(count):
+        nibble = (data[i >> 1] >> (4 * (i & 1))) & 0xF
+        signal, step = step_sample(signal, step, nibble)
+        samples.append(signal)
+    return samples
+
+
+def read_pcm(filename: str) -> List[int]:
+    with open(filename, "rb") as bfp:
+        data = bfp.read()
+    return list(struct.unpack(f"<{len(data) // 2}h", data[:(len(data) & ~1)]))
+
+
+def snr(original: List[int], decoded: List[int]) -> float:
+    signal = sum(s * s for s in original)
+    noise = sum((s - d) * (s - d) for s, d in zip(original, decoded))
+    if noise == 0:
+        return math.inf
+    if signal == 0:
+        return -math.inf
+    return 10.0 * math.log10(signal / noise)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Encode 16-bit PCM to AICA ADPCM and report the round-trip SNR.")
+    parser.add_argument("pcm", metavar="PCM", type=str, help="The raw 16-bit little-endian PCM file to encode.")
+    parser.add_argument("--output", metavar="FILE", type=str, help="Write the ADPCM data here as well.")
+    args = parser.parse_args()
+
+    samples = read_pcm(args.pcm)
+    data = encode(samples)
+    print(f"{args.pcm}: {len(samples) * 2} bytes down to {len(data)} bytes, SNR {snr(samples, decode(data, len(samples))):.02f} dB")
+
+    if args.output:
+        with open(args.output, "wb") as bfp:
+            bfp.write(data)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,95 @@
+#! /usr/bin/env python3
+#
+# Builds the compressed asset pack that gets linked into the ROM, written out
+# as a C file. Every asset is compressed on its own with zlib so that it can
+# be inflated straight into wherever it ends up without the rest of the pack.
+# PNGs are converted to textures with texconv first, and raw 16-bit sounds
+# can be encoded to ADPCM, which prints how much noise that added and refuses
+# to pack any sound that comes out noisier than adpcm.MIN_SNR allows.
+#
+# The pack starts with a header, then a table of entries, then the compressed
+# data for each entry. Everything is little-endian, and the layout must match
+# pack_header_t and pack_entry_t in pack.h.
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+from adpcm import MIN_SNR, decode, encode, read_pcm, snr
+from texconv import convert
+
+PACK_MAGIC = b"NDPK"
+PACK_NAME_LENGTH = 24
+
+# These must match the PACK_SOUND_ values in pack.h. They are the pack's own,
+# and sounds.c maps them onto libnaomi's AUDIO_FORMAT_ values at runtime.
+PACK_SOUND_PCM16 = 0
+PACK_SOUND_ADPCM = 1
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Build a compressed asset pack.")
+    parser.add_argument("output", metavar="OUTPUT", type=str, help="The C file to write.")
+    parser.add_argument("assets", metavar="ASSET", type=str, nargs="+", help="The files to pack.")
+    parser.add_argument("--vq", metavar="PNG", type=str, action="append", default=[], help="A PNG to VQ compress as well as twiddle.")
+    parser.add_argument("--adpcm", metavar="RAW", type=str, action="append", default=[], help="A raw 16-bit sound to encode to 4-bit ADPCM.")
+    args = parser.parse_args()
+
+    entries = []
+    for filename in args.assets:
+        name = os.path.basename(filename)
+        if len(name) >= PACK_NAME_LENGTH:
+            raise Exception(f"{name} is too long to fit in the pack!")
+
+        width = 0
+        fmt = 0
+        if filename.endswith(".png"):
+            width, fmt, data = convert(filename, vq=filename in args.vq)
+        elif filename.endswith(".raw"):
+            # For sounds, the width is how many samples there are.
+            samples = read_pcm(filename)
+            width = len(samples)
+            if filename in args.adpcm:
+                fmt = PACK_SOUND_ADPCM
+                data = encode(samples)
+                ratio = snr(samples, decode(data, width))
+                print(f"{filename}: ADPCM SNR {ratio:.02f} dB", file=sys.stderr)
+                if ratio < MIN_SNR:
+                    raise Exception(f"{filename} is too noisy as ADPCM, {ratio:.02f} dB is below {MIN_SNR:.02f} dB!")
+            else:
+                fmt = PACK_SOUND_PCM16
+                with open(filename, "rb") as bfp:
+                    data = bfp.read()
+        else:
+            with open(filename, "rb") as bfp:
+                data = bfp.read()
+
+        entries.append((name, width, fmt, data, zlib.compress(data, 9)))
+
+    table = PACK_MAGIC + struct.pack("<I", len(entries))
+    offset = len(table) + (len(entries) * (PACK_NAME_LENGTH + 20))
+    blobs = b""
+    for name, width, fmt, data, compressed in entries:
+        table += name.encode("ascii").ljust(PACK_NAME_LENGTH, b"\0")
+        table += struct.pack("<IIIII", offset + len(blobs), len(compressed), len(data), width, fmt)
+        blobs += compressed
+
+    pack = table + blobs
+    with open(args.output, "w") as sfp:
+        sfp.write("#include <stdint.h>\n\n")
+        sfp.write(f"static uint8_t __attribute__((aligned(4))) assets_pack_bytes[{len(pack)}] = {{\n")
+        for start in range(0, len(pack), 16):
+            sfp.write("    " + ", ".join(f"0x{b:02X}" for b in pack[start:(start + 16)]) + ",\n")
+        sfp.write("};\n\n")
+        sfp.write("uint8_t *assets_pack_data = assets_pack_bytes;\n")
+        sfp.write(f"unsigned int assets_pack_len = {len(pack)};\n")
+
+    original = sum(len(e[3]) for e in entries)
+    print(f"Packed {len(entries)} assets, {original} bytes down to {len(pack)} bytes.", file=sys.stderr)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
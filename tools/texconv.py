@@ -0,0 +1,286 @@
+#! /usr/bin/env python3
+#
+# Converts a PNG into a C file holding an ARGB1555 texture that is already in
+# the layout the PowerVR wants, so nothing has to be reordered at boot. By
+# default the texture is twiddled. With --vq it is also VQ compressed, which
+# trades a 2KB codebook for one byte per 2x2 block of texels.
+#
+# The generated file exports <name>_png_width, <name>_png_height,
+# <name>_png_format, <name>_png_size and <name>_png_data, where <name> is
+# the PNG's filename without its extension. The format values must match the
+# SPRITE_FORMAT_ defines in sprites.h.
+import argparse
+import os
+import struct
+import sys
+import zlib
+from typing import List, Tuple
+
+FORMAT_LINEAR = 0
+FORMAT_TWIDDLED = 1
+FORMAT_VQ = 2
+
+# The number of entries in a VQ codebook, and the number of texels in each.
+VQ_CODES = 256
+VQ_TEXELS = 4
+
+# How many refinement passes we make over the codebook when an image has more
+# distinct 2x2 blocks than fit in it.
+VQ_PASSES = 16
+
+Pixel = Tuple[int, int, int, int]
+
+
+def read_png(filename: str) -> Tuple[int, int, List[Pixel]]:
+    # Just enough of a PNG decoder for our sprites, so building doesn't need
+    # anything past a stock python. Handles non-interlaced 8-bit grayscale,
+    # RGB, paletted and RGBA images.
+    with open(filename, "rb") as bfp:
+        data = bfp.read()
+
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise Exception(f"{filename} is not a PNG file!")
+
+    pos = 8
+    header = b""
+    palette = b""
+    transparency = b""
+    compressed = b""
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:(pos + 8)])
+        chunk = data[(pos + 8):(pos + 8 + length)]
+        pos += length + 12
+
+        if kind == b"IHDR":
+            header = chunk
+        elif kind == b"PLTE":
+            palette = chunk
+        elif kind == b"tRNS":
+            transparency = chunk
+        elif kind == b"IDAT":
+            compressed += chunk
+        elif kind == b"IEND":
+            break
+
+    width, height, depth, colortype, _, _, interlace = struct.unpack(">IIBBBBB", header)
+    if depth != 8 or interlace != 0:
+        raise Exception(f"{filename} must be a non-interlaced 8-bit PNG!")
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[colortype]
+    stride = width * channels
+    raw = zlib.decompress(compressed)
+
+    # Undo the per-scanline filters.
+    rows: List[bytearray] = []
+    previous = bytearray(stride)
+    for y in range(height):
+        start = y * (stride + 1)
+        method = raw[start]
+        row = bytearray(raw[(start + 1):(start + 1 + stride)])
+        for x in range(stride):
+            left = row[x - channels] if x >= channels else 0
+            up = previous[x]
+            upleft = previous[x - channels] if x >= channels else 0
+            if method == 1:
+                row[x] = (row[x] + left) & 0xFF
+            elif method == 2:
+                row[x] = (row[x] + up) & 0xFF
+            elif method == 3:
+                row[x] = (row[x] + ((left + up) // 2)) & 0xFF
+            elif method == 4:
+                estimate = left + up - upleft
+                pa = abs(estimate - left)
+                pb = abs(estimate - up)
+                pc = abs(estimate - upleft)
+                if pa <= pb and pa <= pc:
+                    row[x] = (row[x] + left) & 0xFF
+                elif pb <= pc:
+                    row[x] = (row[x] + up) & 0xFF
+                else:
+                    row[x] = (row[x] + upleft) & 0xFF
+        rows.append(row)
+        previous = row
+
+    pixels: List[Pixel] = []
+    for row in rows:
+        for x in range(width):
+            texel = row[(x * channels):((x + 1) * channels)]
+            if colortype == 0:
+                pixels.append((texel[0], texel[0], texel[0], 255))
+            elif colortype == 2:
+                pixels.append((texel[0], texel[1], texel[2], 255))
+            elif colortype == 3:
+                index = texel[0]
+                alpha = transparency[index] if index < len(transparency) else 255
+                pixels.append((palette[index * 3], palette[index * 3 + 1], palette[index * 3 + 2], alpha))
+            elif colortype == 4:
+                pixels.append((texel[0], texel[0], texel[0], texel[1]))
+            else:
+                pixels.append((texel[0], texel[1], texel[2], texel[3]))
+
+    return width, height, pixels
+
+
+def argb1555(pixel: Pixel) -> int:
+    r, g, b, a = pixel
+    return (0x8000 if a >= 128 else 0) | ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3)
+
+
+def unpack1555(texel: int) -> Pixel:
+    return (
+        ((texel >> 10) & 0x1F) << 3,
+        ((texel >> 5) & 0x1F) << 3,
+        (texel & 0x1F) << 3,
+        255 if (texel & 0x8000) else 0,
+    )
+
+
+def twiddle(u: int, v: int) -> int:
+    # The PowerVR stores twiddled textures in Morton order, with V in the even
+    # bits and U in the odd bits of each texel's index.
+    out = 0
+    for bit in range(16):
+        out |= ((v >> bit) & 1) << (bit * 2)
+        out |= ((u >> bit) & 1) << ((bit * 2) + 1)
+    return out
+
+
+def twiddled(uvsize: int, texels: List[int]) -> List[int]:
+    out = [0] * (uvsize * uvsize)
+    for v in range(uvsize):
+        for u in range(uvsize):
+            out[twiddle(u, v)] = texels[(v * uvsize) + u]
+    return out
+
+
+def distance(a: Tuple[int, ...], b: Tuple[int, ...]) -> int:
+    return sum((x - y) * (x - y) for x, y in zip(a, b))
+
+
+def vq_compress(uvsize: int, texels: List[int]) -> Tuple[bytes, float]:
+    # Each codebook entry is a 2x2 block of texels, stored in twiddled order,
+    # and each block of the image is one byte that picks an entry. The index
+    # bytes are themselves twiddled across the half-sized image.
+    half = uvsize // 2
+    blocks: List[Tuple[int, ...]] = []
+    for bv in range(half):
+        for bu in range(half):
+            blocks.append(tuple(
+                texels[(((bv * 2) + (i & 1)) * uvsize) + (bu * 2) + (i >> 1)]
+                for i in range(VQ_TEXELS)
+            ))
+
+    distinct = sorted(set(blocks))
+    if len(distinct) <= VQ_CODES:
+        # Everything fits, so the compression is lossless.
+        codebook = distinct
+    else:
+        # Cluster the blocks in ARGB space, seeding with the most common ones.
+        def vector(block: Tuple[int, ...]) -> Tuple[int, ...]:
+            return tuple(channel for texel in block for channel in unpack1555(texel))
+
+        counts = {}
+        for block in blocks:
+            counts[block] = counts.get(block, 0) + 1
+        seeds = sorted(distinct, key=lambda b: -counts[b])[:VQ_CODES]
+        centers = [vector(b) for b in seeds]
+        vectors = {b: vector(b) for b in distinct}
+
+        for _ in range(VQ_PASSES):
+            sums = [[0] * (VQ_TEXELS * 4) for _ in centers]
+            weights = [0] * len(centers)
+            for block in distinct:
+                best = min(range(len(centers)), key=lambda c: distance(vectors[block], centers[c]))
+                weights[best] += counts[block]
+                for i, channel in enumerate(vectors[block]):
+                    sums[best][i] += channel * counts[block]
+            centers = [
+                tuple(s // weights[c] for s in sums[c]) if weights[c] else centers[c]
+                for c in range(len(centers))
+            ]
+
+        codebook = [
+            tuple(
+                argb1555((c[i * 4], c[(i * 4) + 1], c[(i * 4) + 2], c[(i * 4) + 3]))
+                for i in range(VQ_TEXELS)
+            )
+            for c in centers
+        ]
+
+    lookup = {}
+    indexes = []
+    error = 0
+    for block in blocks:
+        if block not in lookup:
+            lookup[block] = min(
+                range(len(codebook)),
+                key=lambda c: distance(
+                    tuple(ch for t in block for ch in unpack1555(t)),
+                    tuple(ch for t in codebook[c] for ch in unpack1555(t)),
+                ),
+            )
+        index = lookup[block]
+        indexes.append(index)
+        error += distance(
+            tuple(ch for t in block for ch in unpack1555(t)),
+            tuple(ch for t in codebook[index] for ch in unpack1555(t)),
+        )
+
+    out = bytearray()
+    for code in range(VQ_CODES):
+        entry = codebook[code] if code < len(codebook) else (0,) * VQ_TEXELS
+        for texel in entry:
+            out += struct.pack("<H", texel)
+    for index in twiddled(half, indexes):
+        out.append(index)
+
+    # Root mean squared error per channel, so we can warn about lossy sprites.
+    return bytes(out), (error / (len(blocks) * VQ_TEXELS * 4)) ** 0.5
+
+
+def convert(filename: str, vq: bool = False, linear: bool = False) -> Tuple[int, int, bytes]:
+    # Returns the size, format and texture data for a PNG.
+    width, height, pixels = read_png(filename)
+    if width != height or (width & (width - 1)) != 0 or width < 8:
+        raise Exception(f"{filename} must be square with a power of two size of at least 8!")
+
+    texels = [argb1555(p) for p in pixels]
+    if linear:
+        return width, FORMAT_LINEAR, b"".join(struct.pack("<H", t) for t in texels)
+    elif vq:
+        data, rmse = vq_compress(width, texels)
+        if rmse > 0.0:
+            print(f"{filename}: VQ compression is lossy, RMS error {rmse:.02f}", file=sys.stderr)
+        return width, FORMAT_VQ, data
+    else:
+        return width, FORMAT_TWIDDLED, b"".join(struct.pack("<H", t) for t in twiddled(width, texels))
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Convert a PNG to a pre-twiddled or VQ compressed ARGB1555 texture.")
+    parser.add_argument("image", metavar="IMAGE", type=str, help="The PNG file to convert.")
+    parser.add_argument("output", metavar="OUTPUT", type=str, help="The C file to write.")
+    parser.add_argument("--vq", action="store_true", help="VQ compress the texture as well as twiddling it.")
+    parser.add_argument("--linear", action="store_true", help="Leave the texture linear, to be twiddled at load time.")
+    args = parser.parse_args()
+
+    width, fmt, data = convert(args.image, vq=args.vq, linear=args.linear)
+
+    name = os.path.basename(args.image).replace(".", "_")
+    with open(args.output, "w") as sfp:
+        sfp.write("#include <stdint.h>\n\n")
+        sfp.write(f"static uint8_t __attribute__((aligned(32))) {name}_bytes[{len(data)}] = {{\n")
+        for start in range(0, len(data), 16):
+            sfp.write("    " + ", ".join(f"0x{b:02X}" for b in data[start:(start + 16)]) + ",\n")
+        sfp.write("};\n\n")
+        sfp.write(f"unsigned int {name}_width = {width};\n")
+        sfp.write(f"unsigned int {name}_height = {width};\n")
+        sfp.write(f"unsigned int {name}_format = {fmt};\n")
+        sfp.write(f"unsigned int {name}_size = {len(data)};\n")
+        sfp.write(f"void *{name}_data = {name}_bytes;\n")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
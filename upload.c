@@ -0,0 +1,234 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <naomi/system.h>
+#include <naomi/timer.h>
+#include <naomi/ta.h>
+#include "common.h"
+#include "memtest.h"
+#include "upload.h"
+
+// How long, in microseconds, we keep uploading each texture to time it.
+#define UPLOAD_MIN_US 10000
+
+// The largest texture we will build a source image for.
+#define UPLOAD_MAX_BYTES (2 * 1024 * 1024)
+
+// The same memory as addr, but bypassing the cache.
+#define UPLOAD_UNCACHED(addr) (((addr) & 0x1FFFFFFF) | 0xA0000000)
+
+unsigned int upload_format_bits(int format)
+{
+    unsigned int bits[UPLOAD_FORMATS] = { 16, 16, 32, 4, 8, 16 };
+    return bits[format];
+}
+
+uint32_t twiddle_spread(uint32_t v)
+{
+    // Spread the low ten bits of v out to every other bit.
+    uint32_t out = 0;
+    for (int bit = 0; bit < 10; bit++)
+    {
+        out |= ((v >> bit) & 1) << (bit * 2);
+    }
+
+    return out;
+}
+
+void twiddle_16bpp(uint16_t *dest, uint16_t *src, unsigned int uvsize, uint32_t *spread)
+{
+    // The PowerVR stores twiddled textures in Morton order, with V in the
+    // even bits and U in the odd bits of each texel's index.
+    for (unsigned int v = 0; v < uvsize; v++)
+    {
+        for (unsigned int u = 0; u < uvsize; u++)
+        {
+            dest[spread[v] | (spread[u] << 1)] = src[(v * uvsize) + u];
+        }
+    }
+}
+
+void upload_cpu(unsigned int dest, uint32_t *src, unsigned int size)
+{
+    volatile uint32_t *vram = (volatile uint32_t *)dest;
+    for (unsigned int i = 0; i < size / 4; i++)
+    {
+        vram[i] = src[i];
+    }
+}
+
+unsigned int upload_verify(unsigned int dest, uint32_t *src, unsigned int size)
+{
+    volatile uint32_t *vram = (volatile uint32_t *)dest;
+    unsigned int errors = 0;
+    for (unsigned int i = 0; i < size / 4; i++)
+    {
+        if (vram[i] != src[i])
+        {
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+uint32_t upload_measure(upload_test_t *upload, int format, int method, unsigned int uvsize, uint32_t *source, uint32_t *staging, uint32_t *spread, unsigned int *errors)
+{
+    unsigned int bits = upload_format_bits(format);
+    unsigned int size = (uvsize * uvsize * bits) / 8;
+    if (size > UPLOAD_MAX_BYTES)
+    {
+        return UPLOAD_NO_ROOM;
+    }
+
+    if (size > upload->texturesize)
+    {
+        return UPLOAD_NO_ROOM;
+    }
+    unsigned int dest = UPLOAD_UNCACHED((unsigned int)upload->texture);
+
+    // Keep uploading until we've gone long enough to get a good figure. The
+    // twiddled format has to be reordered every time, as a loader would.
+    uint64_t bytes = 0;
+    uint32_t elapsed = 0;
+    uint32_t *image = source;
+    while (elapsed < UPLOAD_MIN_US)
+    {
+        if (job_cancelled(&upload->job))
+        {
+            return UPLOAD_RUNNING;
+        }
+
+        int profile = profile_start();
+        if (format == UPLOAD_FORMAT_TWIDDLED)
+        {
+            twiddle_16bpp((uint16_t *)staging, (uint16_t *)source, uvsize, spread);
+            image = staging;
+        }
+
+        if (method == UPLOAD_METHOD_SQ)
+        {
+            hw_memcpy((void *)dest, image, size);
+        }
+        else
+        {
+            upload_cpu(dest, image, size);
+        }
+        elapsed += profile_end(profile);
+        bytes += size;
+    }
+
+    // Now, read it back and make sure every word made it intact.
+    *errors = upload_verify(dest, image, size);
+
+    return (uint32_t)((bytes * 1000000) / ((uint64_t)elapsed * 1024));
+}
+
+unsigned int upload_thread(void *param)
+{
+    upload_test_t *upload = (upload_test_t *)param;
+
+    /* First, build a source image big enough for the largest texture. */
+    uint32_t *source = memalign(32, UPLOAD_MAX_BYTES);
+    uint32_t *staging = memalign(32, UPLOAD_MAX_BYTES);
+    uint32_t *spread = malloc(sizeof(uint32_t) * 1024);
+    uint32_t seed = 0x13579BDF;
+
+    if (source == NULL || staging == NULL || spread == NULL)
+    {
+        // Not enough main RAM left to build the images from.
+        free(source);
+        free(staging);
+        free(spread);
+        return JOB_FAILED;
+    }
+
+    for (unsigned int i = 0; i < UPLOAD_MAX_BYTES / 4; i++)
+    {
+        seed = xorshift32(seed);
+        source[i] = seed;
+    }
+    for (unsigned int i = 0; i < 1024; i++)
+    {
+        spread[i] = twiddle_spread(i);
+    }
+
+    /* Now, time and verify every combination, smallest textures first. */
+    for (int sizeidx = 0; sizeidx < UPLOAD_SIZES; sizeidx++)
+    {
+        for (int format = 0; format < UPLOAD_FORMATS; format++)
+        {
+            for (int method = 0; method < UPLOAD_METHODS; method++)
+            {
+                unsigned int errors = 0;
+                uint32_t result = upload_measure(upload, format, method, UPLOAD_MIN_UVSIZE << sizeidx, source, staging, spread, &errors);
+                if (result == UPLOAD_RUNNING)
+                {
+                    free(source);
+                    free(staging);
+                    free(spread);
+                    return JOB_CANCELLED;
+                }
+
+                job_publish_begin(&upload->job);
+                upload->results[format][method][sizeidx] = result;
+                upload->errors[format][method][sizeidx] = errors;
+                job_publish_end(&upload->job);
+
+                job_progress(&upload->job, (((sizeidx * UPLOAD_FORMATS) + format) * UPLOAD_METHODS) + method + 1, UPLOAD_SIZES * UPLOAD_FORMATS * UPLOAD_METHODS);
+            }
+        }
+    }
+
+    free(source);
+    free(staging);
+    free(spread);
+
+    return JOB_FINISHED;
+}
+
+upload_test_t *start_upload_test()
+{
+    upload_test_t *upload = malloc(sizeof(upload_test_t));
+    for (int format = 0; format < UPLOAD_FORMATS; format++)
+    {
+        for (int method = 0; method < UPLOAD_METHODS; method++)
+        {
+            for (int sizeidx = 0; sizeidx < UPLOAD_SIZES; sizeidx++)
+            {
+                upload->results[format][method][sizeidx] = UPLOAD_RUNNING;
+                upload->errors[format][method][sizeidx] = 0;
+            }
+        }
+    }
+
+    // Reserve the largest texture we can before the worker starts, halving
+    // it until it fits. Anything bigger than we got is reported as no room.
+    upload->texture = NULL;
+    upload->texturesize = 0;
+    for (unsigned int uvsize = UPLOAD_MIN_UVSIZE << (UPLOAD_SIZES - 1); uvsize >= UPLOAD_MIN_UVSIZE; uvsize /= 2)
+    {
+        upload->texture = ta_texture_malloc(uvsize, 16);
+        if (upload->texture != NULL)
+        {
+            upload->texturesize = (uvsize * uvsize * 16) / 8;
+            break;
+        }
+    }
+
+    job_start(&upload->job, upload_thread, upload, JOB_NO_TIMEOUT);
+    return upload;
+}
+
+void end_upload_test(upload_test_t *upload)
+{
+    // Ask the worker to stop after its current upload and wait for it,
+    // and only then give back the VRAM it was uploading into.
+    job_end(&upload->job);
+    if (upload->texture != NULL)
+    {
+        ta_texture_free(upload->texture);
+    }
+    free(upload);
+}
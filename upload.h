@@ -0,0 +1,62 @@
+#ifndef __UPLOAD_H
+#define __UPLOAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "jobs.h"
+
+// The texture layouts we upload.
+#define UPLOAD_FORMAT_1555 0
+#define UPLOAD_FORMAT_4444 1
+#define UPLOAD_FORMAT_8888 2
+#define UPLOAD_FORMAT_CLUT4 3
+#define UPLOAD_FORMAT_CLUT8 4
+#define UPLOAD_FORMAT_TWIDDLED 5
+#define UPLOAD_FORMATS 6
+
+// How we get each texture into VRAM.
+#define UPLOAD_METHOD_CPU 0
+#define UPLOAD_METHOD_SQ 1
+#define UPLOAD_METHODS 2
+
+// Texture sizes we try, from 64x64 up to 1024x1024.
+#define UPLOAD_MIN_UVSIZE 64
+#define UPLOAD_SIZES 5
+
+// Special result values. Anything else is a throughput in KB/s.
+#define UPLOAD_RUNNING 0xFFFFFFFF
+#define UPLOAD_NO_ROOM 0xFFFFFFFE
+
+typedef struct
+{
+    // The worker doing the uploads, checked for cancellation in between
+    // each one. Its progress counts finished uploads.
+    job_t job;
+
+    // VRAM set aside for the uploads, and how big it is. Every upload goes
+    // into the start of this. The texture allocator is shared with the
+    // font cache the render loop uses, so this is only ever reserved and
+    // given back from the UI thread, never by the worker.
+    void *texture;
+    unsigned int texturesize;
+
+    // Throughput for every format, method and size, and how many words
+    // read back wrong after uploading.
+    uint32_t results[UPLOAD_FORMATS][UPLOAD_METHODS][UPLOAD_SIZES];
+    unsigned int errors[UPLOAD_FORMATS][UPLOAD_METHODS][UPLOAD_SIZES];
+} upload_test_t;
+
+// How many bits per texel each format uses.
+unsigned int upload_format_bits(int format);
+
+upload_test_t *start_upload_test();
+void end_upload_test(upload_test_t *upload);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif